@@ -0,0 +1,295 @@
+#include "app/bench.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/time.hpp"
+#include "engine/src/render/render.hpp"
+
+#include "app/grass.hpp"
+#include "app/grass_bake.hpp"
+#include "app/grass_tiles.hpp"
+#include "app/governor.hpp"
+#include "app/frame_memory.hpp"
+#include "app/state.hpp"
+
+#include <stdlib.h>
+
+#define BENCH_BAKE_PATH GRASS_BAKE_DIRECTORY"/bench.bake"
+
+namespace ty
+{
+namespace Grass
+{
+
+void RunBenchmarks(BenchFrameFunc renderFrame)
+{
+    BenchmarkGrassPlacement();
+    BenchmarkGrassTileCull();
+    BenchmarkGrassInstanceOrder(renderFrame);
+    BenchmarkGrassSplat(renderFrame);
+}
+
+void BenchmarkGrassPlacement()
+{
+    // CPU bake vs GPU placement compute vs loading a baked file. Loading is split into mapping the file and
+    // copying its blades to the instance buffer as is (page faults and transfer), and UploadGrassBake on an
+    // already mapped file (CPU reorder into tile ranges, species lookup and upload of the reordered tiles).
+    // GPU timings include immediate submit and wait, like InitGrassPositions.
+    f32 densities[] = { 0.5f, 1.f, 2.f, 4.f, 8.f };
+    GrassUniformBlock initialUniforms = grassUniforms;
+    GrassDensityMap densityMap = MakeGrassDensityMap(hAssetGrassDensity);
+
+    LOGF("Grass placement benchmark (%d iterations, avg ms)\n", benchIterations);
+    LOGF("%10s %10s %10s %10s %10s %10s %10s\n", "density", "grid", "blades", "cpu bake", "gpu", "map+copy", "reorder+up");
+    for(i32 i = 0; i < (i32)ARR_LEN(densities); i++)
+    {
+        grassUniforms.grassDensity = densities[i];
+        grassUniforms.bladesPerSide = GetGrassBladesPerSide();
+        UpdateGrassInstanceCapacity();
+        grassUniforms.instanceCapacity = grassInstanceCapacity;
+        render::CopyMemoryToBuffer(hUbGrass, 0, sizeof(GrassUniformBlock), &grassUniforms);
+        u32 bladesPerSide = grassUniforms.bladesPerSide;
+
+        // CPU bake
+        GrassInstanceDataBlock* instances = (GrassInstanceDataBlock*)AppHeapAlloc((u64)bladesPerSide * bladesPerSide * sizeof(GrassInstanceDataBlock));
+        u32 bladeCount = 0;
+        time::Timer timer;
+        timer.Start();
+        for(i32 it = 0; it < benchIterations; it++)
+        {
+            bladeCount = BakeGrassPositionsCPU(instances, bladesPerSide, grassUniforms.terrainSize, densityMap);
+        }
+        timer.Stop();
+        f64 cpuMS = timer.GetElapsedMS() / benchIterations;
+
+        // GPU placement
+        timer.Start();
+        for(i32 it = 0; it < benchIterations; it++)
+        {
+            Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_IMMEDIATE);
+            render::BeginCommandBuffer(hCmd);
+            PlaceAllGrassTiles(hCmd);
+            render::EndCommandBuffer(hCmd);
+            render::SubmitImmediate(hCmd);
+        }
+        timer.Stop();
+        f64 gpuMS = timer.GetElapsedMS() / benchIterations;
+
+        // Mapped bake upload
+        GrassBakeHeader header = {};
+        header.instanceCount = bladeCount;
+        header.bladesPerSide = bladesPerSide;
+        header.terrainSize = grassUniforms.terrainSize;
+        header.grassDensity = grassUniforms.grassDensity;
+        bool written = WriteGrassBakeFile(BENCH_BAKE_PATH, header, instances);
+        AppHeapFree(instances);
+        // Unwritable bake directory only loses these columns, not the whole run
+        f64 mapMS = -1.0;
+        f64 reorderMS = -1.0;
+        if(written)
+        {
+            timer.Start();
+            for(i32 it = 0; it < benchIterations; it++)
+            {
+                GrassBakeFile bake = {};
+                bool mapped = MapGrassBakeFile(BENCH_BAKE_PATH, &bake);
+                ASSERT(mapped);
+                render::CopyMemoryToBuffer(hSbGrassInstanceData, 0,
+                        (u64)bake.header->instanceCount * sizeof(GrassInstanceDataBlock), bake.instances);
+                UnmapGrassBakeFile(&bake);
+            }
+            timer.Stop();
+            mapMS = timer.GetElapsedMS() / benchIterations;
+
+            GrassBakeFile bake = {};
+            bool mapped = MapGrassBakeFile(BENCH_BAKE_PATH, &bake);
+            ASSERT(mapped);
+            timer.Start();
+            for(i32 it = 0; it < benchIterations; it++)
+            {
+                UploadGrassBake(&bake);
+            }
+            timer.Stop();
+            reorderMS = timer.GetElapsedMS() / benchIterations;
+            UnmapGrassBakeFile(&bake);
+        }
+
+        LOGF("%10.2f %10u %10u %10.3f %10.3f %10.3f %10.3f\n",
+                densities[i], bladesPerSide, bladeCount, cpuMS, gpuMS, mapMS, reorderMS);
+    }
+
+    remove(BENCH_BAKE_PATH);
+    grassPositionsDirty = true;
+    grassUniforms = initialUniforms;
+}
+
+void BenchmarkGrassTileCull()
+{
+    // SIMD vs scalar tile culling against main camera, on square grids of 4 unit tiles
+    // centered on camera so part of each grid is in view and part behind or past far distance.
+    u32 tileCounts[] = { 10000, 100000, 1000000 };
+    GrassFrustum frustum = MakeGrassFrustum(appCamera.GetProjection() * appCamera.GetView(),
+            appCamera.position, grassUniforms.farDistance);
+    const f32 tileSize = 4.f;
+
+    LOGF("Grass tile cull benchmark (%d iterations, avg ms)\n", benchIterations);
+    LOGF("%10s %10s %10s %10s %12s %12s\n", "tiles", "visible", "simd", "scalar", "simd Mt/s", "scalar Mt/s");
+    for(i32 i = 0; i < (i32)ARR_LEN(tileCounts); i++)
+    {
+        u32 tilesPerSide = (u32)sqrt((f64)tileCounts[i]);
+        u32 tileCount = tilesPerSide * tilesPerSide;
+        f32 gridOrigin = -0.5f * tilesPerSide * tileSize;
+        GrassTileBounds bounds = {};
+        ResizeGrassTileBounds(&bounds, tileCount);
+        for(u32 y = 0; y < tilesPerSide; y++)
+        {
+            for(u32 x = 0; x < tilesPerSide; x++)
+            {
+                u32 tile = y * tilesPerSide + x;
+                bounds.minX[tile] = appCamera.position.x + gridOrigin + x * tileSize;
+                bounds.maxX[tile] = bounds.minX[tile] + tileSize;
+                bounds.minY[tile] = 0;
+                bounds.maxY[tile] = grassUniforms.bladeHeight;
+                bounds.minZ[tile] = appCamera.position.z + gridOrigin + y * tileSize;
+                bounds.maxZ[tile] = bounds.minZ[tile] + tileSize;
+            }
+        }
+        u32* visibleTiles = (u32*)AppHeapAlloc(tileCount * sizeof(u32));
+        u32 simdVisible = 0;
+        u32 scalarVisible = 0;
+        u32 frustumVisible = 0;
+
+        time::Timer timer;
+        timer.Start();
+        for(i32 it = 0; it < benchIterations; it++)
+        {
+            simdVisible = CullGrassTiles(bounds, &frustum, 1, visibleTiles, &frustumVisible);
+        }
+        timer.Stop();
+        f64 simdMS = timer.GetElapsedMS() / benchIterations;
+
+        timer.Start();
+        for(i32 it = 0; it < benchIterations; it++)
+        {
+            scalarVisible = CullGrassTilesScalar(bounds, &frustum, 1, visibleTiles, &frustumVisible);
+        }
+        timer.Stop();
+        f64 scalarMS = timer.GetElapsedMS() / benchIterations;
+        ASSERT(simdVisible == scalarVisible);
+
+        LOGF("%10u %10u %10.3f %10.3f %12.1f %12.1f\n",
+                tileCount, simdVisible, simdMS, scalarMS,
+                tileCount / (simdMS * 1000.0), tileCount / (scalarMS * 1000.0));
+        AppHeapFree(visibleTiles);
+        DestroyGrassTileBounds(&bounds);
+    }
+}
+
+// Average ms of kernel over whole grid, with immediate submit and wait
+f64 TimeGrassKernel(ComputeKernelRunFunc run)
+{
+    time::Timer timer;
+    timer.Start();
+    for(i32 it = 0; it < benchIterations; it++)
+    {
+        Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_IMMEDIATE);
+        render::BeginCommandBuffer(hCmd);
+        run(hCmd);
+        render::EndCommandBuffer(hCmd);
+        render::SubmitImmediate(hCmd);
+    }
+    timer.Stop();
+    return timer.GetElapsedMS() / benchIterations;
+}
+
+void BenchmarkGrassInstanceOrder(BenchFrameFunc renderFrame)
+{
+    // Row major vs Morton order within tiles. Vulkan exposes no portable cache counters, so locality
+    // shows up as time: placement and blade cull over every tile (compaction passes, wind fetches),
+    // and full frames (vertex fetches through visible lists). Governor is off so density stays fixed.
+    f32 densities[] = { 2.f, 4.f, 8.f };
+    GrassInstanceOrder orders[] = { GRASS_INSTANCE_ORDER_ROW_MAJOR, GRASS_INSTANCE_ORDER_MORTON };
+    f32 initialDensity = grassDensityRequested;
+    GrassInstanceOrder initialOrder = grassInstanceOrder;
+    f32 initialTargetFrameMS = governorSettings.targetFrameMS;
+    governorSettings.targetFrameMS = 0;
+
+    LOGF("Grass instance order benchmark (avg ms, row major / morton)\n");
+    LOGF("%10s %20s %20s %20s\n", "density", "placement", "cull", "frame");
+    for(i32 i = 0; i < (i32)ARR_LEN(densities); i++)
+    {
+        grassDensityRequested = densities[i];
+        f64 placementMS[ARR_LEN(orders)] = {};
+        f64 cullMS[ARR_LEN(orders)] = {};
+        f64 frameMS[ARR_LEN(orders)] = {};
+        for(i32 j = 0; j < (i32)ARR_LEN(orders); j++)
+        {
+            grassInstanceOrder = orders[j];
+            grassPositionsDirty = true;
+            for(i32 frame = 0; frame < benchWarmupFrames; frame++)
+            {
+                renderFrame();
+            }
+            time::Timer timer;
+            timer.Start();
+            for(i32 frame = 0; frame < benchFrames; frame++)
+            {
+                renderFrame();
+            }
+            timer.Stop();
+            frameMS[j] = timer.GetElapsedMS() / benchFrames;
+            // Placing every tile first also makes every tile's count valid for cull
+            placementMS[j] = TimeGrassKernel(PlaceAllGrassTiles);
+            cullMS[j] = TimeGrassKernel(CullAllGrassTiles);
+        }
+        LOGF("%10.2f %9.3f / %-8.3f %9.3f / %-8.3f %9.3f / %-8.3f\n", densities[i],
+                placementMS[0], placementMS[1], cullMS[0], cullMS[1], frameMS[0], frameMS[1]);
+    }
+
+    grassDensityRequested = initialDensity;
+    grassInstanceOrder = initialOrder;
+    grassPositionsDirty = true;
+    governorSettings.targetFrameMS = initialTargetFrameMS;
+}
+
+void BenchmarkGrassSplat(BenchFrameFunc renderFrame)
+{
+    // Full frame times with every blade on hardware raster vs distant blades splatted.
+    // Governor is off so density and render scale stay fixed.
+    f32 densities[] = { 1.f, 2.f, 4.f, 8.f };
+    f32 splatPixelSizes[] = { 0.f, 2.f, 4.f };
+    f32 initialDensity = grassDensityRequested;
+    f32 initialSplatPixelSize = grassSplatPixelSize;
+    f32 initialTargetFrameMS = governorSettings.targetFrameMS;
+    governorSettings.targetFrameMS = 0;
+
+    LOGF("Grass splat benchmark (%d frames, avg ms)\n", benchFrames);
+    LOGF("%10s %10s %10s %10s\n", "density", "hw only", "splat 2px", "splat 4px");
+    for(i32 i = 0; i < (i32)ARR_LEN(densities); i++)
+    {
+        grassDensityRequested = densities[i];
+        f64 frameMS[ARR_LEN(splatPixelSizes)] = {};
+        for(i32 j = 0; j < (i32)ARR_LEN(splatPixelSizes); j++)
+        {
+            grassSplatPixelSize = splatPixelSizes[j];
+            for(i32 frame = 0; frame < benchWarmupFrames; frame++)
+            {
+                renderFrame();
+            }
+            time::Timer timer;
+            timer.Start();
+            for(i32 frame = 0; frame < benchFrames; frame++)
+            {
+                renderFrame();
+            }
+            timer.Stop();
+            frameMS[j] = timer.GetElapsedMS() / benchFrames;
+        }
+        LOGF("%10.2f %10.3f %10.3f %10.3f\n", densities[i], frameMS[0], frameMS[1], frameMS[2]);
+    }
+
+    grassDensityRequested = initialDensity;
+    grassSplatPixelSize = initialSplatPixelSize;
+    governorSettings.targetFrameMS = initialTargetFrameMS;
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,24 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+
+// Offline benchmarks, run with --bench after app init. Results are logged.
+
+namespace ty
+{
+namespace Grass
+{
+
+const i32 benchIterations = 16;
+const i32 benchWarmupFrames = 8;
+const i32 benchFrames = 64;
+
+typedef void (*BenchFrameFunc)();   // Renders and presents one full frame
+
+void RunBenchmarks(BenchFrameFunc renderFrame);
+void BenchmarkGrassPlacement();
+void BenchmarkGrassTileCull();
+void BenchmarkGrassInstanceOrder(BenchFrameFunc renderFrame);
+void BenchmarkGrassSplat(BenchFrameFunc renderFrame);
+
+};  // namespace Grass
+};  // namespace ty
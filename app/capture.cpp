@@ -0,0 +1,358 @@
+#include "app/capture.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/gpu_memory.hpp"
+#include "app/render_utils.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void ParseCaptureSettings(const wchar_t* cmdLine)
+{
+    captureSettings = {};
+    if(!cmdLine) return;
+
+    if(wcsstr(cmdLine, L"--capture=png")) captureSettings.enabled = true;
+    else if(wcsstr(cmdLine, L"--capture=raw"))
+    {
+        captureSettings.enabled = true;
+        captureSettings.format = CAPTURE_FORMAT_RAW;
+    }
+
+    const wchar_t* intervalArg = wcsstr(cmdLine, L"--capture-interval=");
+    if(intervalArg)
+    {
+        captureSettings.interval = (u32)MAX(1, (i32)wcstol(intervalArg + wcslen(L"--capture-interval="), NULL, 10));
+    }
+
+    const wchar_t* dirArg = wcsstr(cmdLine, L"--capture-dir=");
+    if(dirArg)
+    {
+        dirArg += wcslen(L"--capture-dir=");
+        i32 length = 0;
+        while(dirArg[length] && dirArg[length] != L' ' && length < (i32)sizeof(captureSettings.directory) - 1)
+        {
+            captureSettings.directory[length] = (char)dirArg[length];
+            length++;
+        }
+        captureSettings.directory[length] = 0;
+    }
+}
+
+// PNG with stored (uncompressed) deflate blocks. Encoding is a copy plus CRC and Adler sums,
+// so the encoder keeps up with capture rate, at the cost of file size.
+u32 pngCrcTable[256];
+
+void InitPngCrcTable()
+{
+    for(u32 i = 0; i < 256; i++)
+    {
+        u32 c = i;
+        for(i32 k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        pngCrcTable[i] = c;
+    }
+}
+
+struct PngStream
+{
+    FILE* file = NULL;
+    u32 crc = 0;
+    u32 adlerA = 1;
+    u32 adlerB = 0;
+    u64 rawRemaining = 0;       // Uncompressed bytes left in stream
+    u32 blockRemaining = 0;     // Uncompressed bytes left in current stored block
+    bool result = true;
+};
+
+void PngWrite(PngStream* stream, const u8* data, u64 size)
+{
+    u32 crc = stream->crc;
+    for(u64 i = 0; i < size; i++)
+    {
+        crc = pngCrcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    stream->crc = crc;
+    stream->result = stream->result && fwrite(data, 1, size, stream->file) == size;
+}
+
+void PngWriteU32(PngStream* stream, u32 value)
+{
+    u8 bytes[4] = { (u8)(value >> 24), (u8)(value >> 16), (u8)(value >> 8), (u8)value };
+    PngWrite(stream, bytes, 4);
+}
+
+void PngBeginChunk(PngStream* stream, const char* type, u32 size)
+{
+    PngWriteU32(stream, size);
+    stream->crc = 0xFFFFFFFF;
+    PngWrite(stream, (const u8*)type, 4);
+}
+
+void PngEndChunk(PngStream* stream)
+{
+    PngWriteU32(stream, ~stream->crc);
+}
+
+void PngWriteDeflate(PngStream* stream, const u8* data, u64 size)
+{
+    while(size > 0)
+    {
+        if(stream->blockRemaining == 0)
+        {
+            u32 blockSize = (u32)MIN(stream->rawRemaining, (u64)0xFFFF);
+            u8 header[5] =
+            {
+                (u8)(stream->rawRemaining <= 0xFFFF ? 1 : 0),   // BFINAL, BTYPE stored
+                (u8)blockSize, (u8)(blockSize >> 8),
+                (u8)~blockSize, (u8)(~blockSize >> 8),
+            };
+            PngWrite(stream, header, sizeof(header));
+            stream->blockRemaining = blockSize;
+        }
+        u32 count = (u32)MIN(size, (u64)stream->blockRemaining);
+        PngWrite(stream, data, count);
+        // Sums stay below 2^32 for 5552 bytes before the modulo is needed
+        for(u32 i = 0; i < count; i++)
+        {
+            stream->adlerA += data[i];
+            stream->adlerB += stream->adlerA;
+            if((i & 4095) == 4095)
+            {
+                stream->adlerA %= 65521;
+                stream->adlerB %= 65521;
+            }
+        }
+        stream->adlerA %= 65521;
+        stream->adlerB %= 65521;
+        stream->blockRemaining -= count;
+        stream->rawRemaining -= count;
+        data += count;
+        size -= count;
+    }
+}
+
+bool WriteImagePNG(const char* path, u8* rgba, u32 width, u32 height)
+{
+    PngStream stream = {};
+    stream.file = fopen(path, "wb");
+    if(!stream.file) return false;
+
+    const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    stream.result = fwrite(signature, 1, sizeof(signature), stream.file) == sizeof(signature);
+
+    PngBeginChunk(&stream, "IHDR", 13);
+    PngWriteU32(&stream, width);
+    PngWriteU32(&stream, height);
+    const u8 format[5] = { 8, 6, 0, 0, 0 };     // 8 bit RGBA, deflate, adaptive filters, no interlace
+    PngWrite(&stream, format, sizeof(format));
+    PngEndChunk(&stream);
+
+    // Each row is prefixed by filter type 0 (none)
+    u64 rowSize = (u64)width * 4;
+    u64 rawSize = (rowSize + 1) * height;
+    u64 blockCount = (rawSize + 0xFFFE) / 0xFFFF;
+    u64 zlibSize = 2 + blockCount * 5 + rawSize + 4;
+    ASSERT(zlibSize < 0x7FFFFFFF);
+    PngBeginChunk(&stream, "IDAT", (u32)zlibSize);
+    const u8 zlibHeader[2] = { 0x78, 0x01 };
+    PngWrite(&stream, zlibHeader, sizeof(zlibHeader));
+    stream.rawRemaining = rawSize;
+    for(u32 y = 0; y < height; y++)
+    {
+        const u8 filter = 0;
+        PngWriteDeflate(&stream, &filter, 1);
+        PngWriteDeflate(&stream, rgba + y * rowSize, rowSize);
+    }
+    PngWriteU32(&stream, (stream.adlerB << 16) | stream.adlerA);
+    PngEndChunk(&stream);
+
+    PngBeginChunk(&stream, "IEND", 0);
+    PngEndChunk(&stream);
+
+    bool result = stream.result;
+    result = fclose(stream.file) == 0 && result;
+    return result;
+}
+
+bool WriteCaptureSlot(CaptureSlot& slot)
+{
+    char path[512];
+    u64 size = (u64)slot.width * slot.height * 4;
+    if(captureSettings.format == CAPTURE_FORMAT_PNG)
+    {
+        snprintf(path, sizeof(path), "%s/frame_%06u.png", captureSettings.directory, slot.captureIndex);
+        if(!WriteImagePNG(path, slot.data, slot.width, slot.height)) return false;
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s/frame_%06u_%ux%u.rgba", captureSettings.directory, slot.captureIndex, slot.width, slot.height);
+        FILE* file = fopen(path, "wb");
+        if(!file) return false;
+        bool result = fwrite(slot.data, 1, size, file) == size;
+        result = fclose(file) == 0 && result;
+        if(!result) return false;
+    }
+    captureStats.bytesWritten += size;
+    return true;
+}
+
+void CaptureThreadMain()
+{
+    while(true)
+    {
+        i32 slotIndex = -1;
+        if(!captureQueue.Pop(&slotIndex))
+        {
+            if(captureQuit.load()) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        CaptureSlot& slot = captureSlots[slotIndex];
+        time::Timer encodeTimer;
+        encodeTimer.Start();
+        if(WriteCaptureSlot(slot)) captureStats.written++;
+        else captureStats.failed++;
+        encodeTimer.Stop();
+        captureStats.encodeUS += (u64)(encodeTimer.GetElapsedMS() * 1000.0);
+        slot.state.store(CAPTURE_SLOT_WRITTEN, std::memory_order_release);
+    }
+}
+
+void InitCapture(u32 width, u32 height)
+{
+    if(!captureSettings.enabled) return;
+    InitPngCrcTable();
+    CreateDirectoryA(captureSettings.directory, NULL);
+    u64 size = (u64)width * height * 4;
+    for(i32 i = 0; i < CAPTURE_SLOT_COUNT; i++)
+    {
+        captureSlots[i].hBuffer = MakeGpuBuffer("Capture readback", render::BUFFER_TYPE_READBACK, size, 4);
+        captureSlots[i].state = CAPTURE_SLOT_FREE;
+    }
+    captureRecordSlot = -1;
+    captureFrameCount = 0;
+    captureQuit = false;
+    captureThread = std::thread(CaptureThreadMain);
+    captureTimer.Start();
+    LOGF("Capturing every %u frames as %s to %s/\n",
+            captureSettings.interval,
+            captureSettings.format == CAPTURE_FORMAT_PNG ? "png" : "raw",
+            captureSettings.directory);
+}
+
+void ShutdownCapture()
+{
+    if(!captureSettings.enabled) return;
+    // Encoder drains its queue before exiting
+    captureQuit = true;
+    captureThread.join();
+    for(i32 i = 0; i < CAPTURE_SLOT_COUNT; i++)
+    {
+        CaptureSlot& slot = captureSlots[i];
+        if(slot.state == CAPTURE_SLOT_GPU) captureStats.dropped++;
+        if(slot.data) render::UnmapBuffer(slot.hBuffer);
+        slot.data = NULL;
+        slot.state = CAPTURE_SLOT_FREE;
+        DeferDestroyBuffer(slot.hBuffer);
+    }
+    captureTimer.Stop();
+    f64 seconds = captureTimer.GetElapsedS();
+    LOGF("Capture: %u frames written (%.1f/s), %u dropped, %u failed, %.1f MB\n",
+            captureStats.written.load(),
+            seconds > 0 ? captureStats.written.load() / seconds : 0.0,
+            captureStats.dropped,
+            captureStats.failed.load(),
+            captureStats.bytesWritten.load() / (1024.0 * 1024.0));
+}
+
+bool BeginCaptureFrame(i32 frame, u32 width, u32 height)
+{
+    captureRecordSlot = -1;
+    if(!captureSettings.enabled) return false;
+    u32 captureIndex = captureFrameCount++;
+    if(captureIndex % captureSettings.interval != 0) return false;
+
+    captureStats.requested++;
+    for(i32 i = 0; i < CAPTURE_SLOT_COUNT; i++)
+    {
+        CaptureSlot& slot = captureSlots[i];
+        if(slot.state.load(std::memory_order_acquire) != CAPTURE_SLOT_FREE) continue;
+        slot.width = width;
+        slot.height = height;
+        slot.captureIndex = captureIndex;
+        slot.retireFrame = frame + RENDER_CONCURRENT_FRAMES;
+        slot.state.store(CAPTURE_SLOT_GPU, std::memory_order_relaxed);
+        captureRecordSlot = i;
+        return true;
+    }
+    // Encoder is behind, waiting for it would stall the frame
+    captureStats.dropped++;
+    return false;
+}
+
+void RecordCaptureCopy(Handle<render::CommandBuffer> hCmd, Handle<render::Texture> hTexture)
+{
+    ASSERT(captureRecordSlot >= 0);
+    CaptureSlot& slot = captureSlots[captureRecordSlot];
+    render::CmdCopyTextureToBuffer(hCmd, hTexture, slot.hBuffer);
+    // Fence wait alone doesn't make transfer writes visible to host reads
+    render::Barrier barrier =
+    {
+        .srcAccess = render::MEMORY_ACCESS_TRANSFER_WRITE,
+        .dstAccess = render::MEMORY_ACCESS_HOST_READ,
+        .srcStage = render::PIPELINE_STAGE_TRANSFER,
+        .dstStage = render::PIPELINE_STAGE_HOST,
+    };
+    render::CmdPipelineBarrier(hCmd, barrier);
+}
+
+void MarkCaptureRetired(i32 frame)
+{
+    if(!captureSettings.enabled) return;
+    for(i32 i = 0; i < CAPTURE_SLOT_COUNT; i++)
+    {
+        CaptureSlot& slot = captureSlots[i];
+        u32 state = slot.state.load(std::memory_order_acquire);
+        if(state == CAPTURE_SLOT_WRITTEN)
+        {
+            render::UnmapBuffer(slot.hBuffer);
+            slot.data = NULL;
+            slot.state.store(CAPTURE_SLOT_FREE, std::memory_order_release);
+        }
+        else if(state == CAPTURE_SLOT_GPU && frame >= slot.retireFrame)
+        {
+            slot.data = (u8*)render::MapBuffer(slot.hBuffer);
+            slot.state.store(CAPTURE_SLOT_ENCODING, std::memory_order_release);
+            // Queue holds every slot, so this never fails
+            bool pushed = captureQueue.Push(i);
+            ASSERT(pushed);
+        }
+    }
+}
+
+void UpdateCaptureUI()
+{
+    if(!captureSettings.enabled) return;
+    u32 written = captureStats.written.load();
+    f64 encodeS = captureStats.encodeUS.load() / 1000000.0;
+    captureTimer.Stop();
+    f64 elapsedS = captureTimer.GetElapsedS();
+    egui::Text("Capture: %u/%u written, %u dropped, %u failed",
+            written, captureStats.requested, captureStats.dropped, captureStats.failed.load());
+    egui::Text("Capture throughput: %.1f frames/s, encoder %.1f MB/s",
+            elapsedS > 0 ? written / elapsedS : 0.0,
+            encodeS > 0 ? captureStats.bytesWritten.load() / (1024.0 * 1024.0) / encodeS : 0.0);
+}
+
+};  // namespace Grass
+};  // namespace ty
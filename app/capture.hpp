@@ -0,0 +1,93 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+#include "app/sim.hpp"
+
+#include <atomic>
+#include <thread>
+
+// Asynchronous frame capture, enabled with --capture=png or --capture=raw, every
+// --capture-interval=N frames (default 1) into --capture-dir=path (default captures).
+// Main color before UI is copied into one of a ring of host visible readback buffers at the end
+// of the frame. The buffer is only mapped once its frame fence was waited on (RENDER_CONCURRENT_FRAMES
+// later), then an encoder thread writes it to disk and hands it back. Render loop never waits: when
+// no buffer is free the frame is dropped and counted instead.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum CaptureFormat
+{
+    CAPTURE_FORMAT_PNG,         // RGBA8, uncompressed deflate, cheap to encode
+    CAPTURE_FORMAT_RAW,         // Tightly packed RGBA8 rows, size in file name
+};
+
+enum CaptureSlotState
+{
+    CAPTURE_SLOT_FREE,
+    CAPTURE_SLOT_GPU,           // Copy recorded, frame not retired yet
+    CAPTURE_SLOT_ENCODING,      // Mapped, owned by encoder thread
+    CAPTURE_SLOT_WRITTEN,       // Encoder done, render side unmaps and frees
+};
+
+struct CaptureSettings
+{
+    bool enabled = false;
+    CaptureFormat format = CAPTURE_FORMAT_PNG;
+    u32 interval = 1;
+    char directory[256] = "captures";
+};
+
+// Frames in flight plus encoder backlog
+#define CAPTURE_SLOT_COUNT (RENDER_CONCURRENT_FRAMES + 2)
+
+struct CaptureSlot
+{
+    Handle<render::Buffer> hBuffer;
+    std::atomic<u32> state = CAPTURE_SLOT_FREE;
+    u32 width = 0;
+    u32 height = 0;
+    u32 captureIndex = 0;
+    i32 retireFrame = 0;
+    u8* data = NULL;            // Mapped while encoding
+};
+
+struct CaptureStats
+{
+    u32 requested = 0;
+    u32 dropped = 0;            // No free slot when requested
+    std::atomic<u32> written = 0;
+    std::atomic<u32> failed = 0;
+    std::atomic<u64> bytesWritten = 0;
+    std::atomic<u64> encodeUS = 0;  // Encoder thread busy time
+};
+
+inline CaptureSettings captureSettings = {};
+inline CaptureStats captureStats;
+inline CaptureSlot captureSlots[CAPTURE_SLOT_COUNT];
+inline i32 captureRecordSlot = -1;  // Slot copied into by this frame's capture pass
+inline u32 captureFrameCount = 0;
+inline SpscQueue<i32, CAPTURE_SLOT_COUNT> captureQueue;
+inline std::thread captureThread;
+inline std::atomic<bool> captureQuit = false;
+inline time::Timer captureTimer = {};
+
+void ParseCaptureSettings(const wchar_t* cmdLine);
+// Readback buffers hold full window resolution frames
+void InitCapture(u32 width, u32 height);
+// Frames still in flight are dropped
+void ShutdownCapture();
+// Render side, while building frame. Returns true if frame should record a capture copy.
+bool BeginCaptureFrame(i32 frame, u32 width, u32 height);
+// Inside capture pass, texture is in transfer source layout
+void RecordCaptureCopy(Handle<render::CommandBuffer> hCmd, Handle<render::Texture> hTexture);
+// Call right after frame fence wait, hands finished copies to encoder and recycles written slots
+void MarkCaptureRetired(i32 frame);
+void UpdateCaptureUI();
+bool WriteImagePNG(const char* path, u8* rgba, u32 width, u32 height);
+
+};  // namespace Grass
+};  // namespace ty
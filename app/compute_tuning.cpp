@@ -0,0 +1,164 @@
+#include "app/compute_tuning.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/time.hpp"
+
+#include <stdio.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void RegisterComputeKernel(ComputeKernel kernel, ComputeKernelRebuildFunc rebuild, ComputeKernelRunFunc run)
+{
+    ASSERT(kernel < COMPUTE_KERNEL_COUNT);
+    computeKernels[kernel].rebuild = rebuild;
+    computeKernels[kernel].run = run;
+}
+
+WorkgroupSize GetWorkgroupSize(ComputeKernel kernel)
+{
+    ASSERT(kernel < COMPUTE_KERNEL_COUNT);
+    return computeKernels[kernel].size;
+}
+
+void SetWorkgroupSpecialization(render::ComputePipelineDesc* desc, ComputeKernel kernel)
+{
+    WorkgroupSize size = GetWorkgroupSize(kernel);
+    desc->specializationConstantCount = 3;
+    desc->specializationConstants[0] = { .id = 0, .value = size.x };
+    desc->specializationConstants[1] = { .id = 1, .value = size.y };
+    desc->specializationConstants[2] = { .id = 2, .value = size.z };
+}
+
+u32 GetWorkgroupCount(u32 count, u32 workgroupSize)
+{
+    return (count + workgroupSize - 1) / workgroupSize;
+}
+
+void GetComputeTuningPath(render::DeviceInfo& device, char* buffer, u64 bufferSize)
+{
+    // Driver version is part of the key, software drivers change a lot between versions
+    snprintf(buffer, bufferSize, COMPUTE_TUNING_PATH "compute_%04x_%04x_%08x.tune",
+            device.vendorID, device.deviceID, device.driverVersion);
+}
+
+bool LoadComputeTuning()
+{
+    render::DeviceInfo device = render::GetDeviceInfo();
+    char path[256];
+    GetComputeTuningPath(device, path, sizeof(path));
+    FILE* file = fopen(path, "rb");
+    if(!file) return false;
+
+    ComputeTuningHeader header = {};
+    WorkgroupSize sizes[COMPUTE_KERNEL_COUNT];
+    bool result = fread(&header, sizeof(ComputeTuningHeader), 1, file) == 1
+        && header.magic == computeTuningMagic
+        && header.version == computeTuningVersion
+        && header.vendorID == device.vendorID
+        && header.deviceID == device.deviceID
+        && header.driverVersion == device.driverVersion
+        && header.kernelCount == COMPUTE_KERNEL_COUNT
+        && fread(sizes, sizeof(WorkgroupSize), COMPUTE_KERNEL_COUNT, file) == COMPUTE_KERNEL_COUNT;
+    fclose(file);
+    if(!result)
+    {
+        LOGF("Ignoring stale compute tuning file: %s\n", path);
+        return false;
+    }
+
+    for(i32 i = 0; i < COMPUTE_KERNEL_COUNT; i++)
+    {
+        WorkgroupSize size = sizes[i];
+        if(size.x * size.y * size.z > device.maxComputeWorkGroupInvocations) return false;
+        computeKernels[i].size = size;
+        LOGF("Compute tuning: %s %ux%ux%u\n", computeKernels[i].name, size.x, size.y, size.z);
+    }
+    return true;
+}
+
+bool SaveComputeTuning()
+{
+    render::DeviceInfo device = render::GetDeviceInfo();
+    char path[256];
+    GetComputeTuningPath(device, path, sizeof(path));
+    // Tuning files are per machine, directory isn't checked in
+    CreateDirectoryA(COMPUTE_TUNING_DIRECTORY, NULL);
+    FILE* file = fopen(path, "wb");
+    if(!file)
+    {
+        LOGF("Failed to open compute tuning file for writing: %s\n", path);
+        return false;
+    }
+
+    ComputeTuningHeader header = {};
+    header.vendorID = device.vendorID;
+    header.deviceID = device.deviceID;
+    header.driverVersion = device.driverVersion;
+    header.kernelCount = COMPUTE_KERNEL_COUNT;
+    WorkgroupSize sizes[COMPUTE_KERNEL_COUNT];
+    for(i32 i = 0; i < COMPUTE_KERNEL_COUNT; i++)
+    {
+        sizes[i] = computeKernels[i].size;
+    }
+    bool result = fwrite(&header, sizeof(ComputeTuningHeader), 1, file) == 1
+        && fwrite(sizes, sizeof(WorkgroupSize), COMPUTE_KERNEL_COUNT, file) == COMPUTE_KERNEL_COUNT;
+    fclose(file);
+    if(!result) LOGF("Failed to write compute tuning file: %s\n", path);
+    return result;
+}
+
+f64 TimeComputeKernel(ComputeKernelTuning& kernel)
+{
+    // Immediate submit and wait per iteration, like bench timings. Submit overhead is
+    // the same for every candidate, so it doesn't change which one wins.
+    time::Timer timer;
+    timer.Start();
+    for(i32 it = 0; it < computeTuningIterations; it++)
+    {
+        Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_IMMEDIATE);
+        render::BeginCommandBuffer(hCmd);
+        kernel.run(hCmd);
+        render::EndCommandBuffer(hCmd);
+        render::SubmitImmediate(hCmd);
+    }
+    timer.Stop();
+    return timer.GetElapsedMS() / computeTuningIterations;
+}
+
+void AutotuneCompute()
+{
+    render::DeviceInfo device = render::GetDeviceInfo();
+    LOGF("Autotuning compute workgroup sizes on %s (%d iterations, avg ms)\n", device.name, computeTuningIterations);
+    for(i32 i = 0; i < COMPUTE_KERNEL_COUNT; i++)
+    {
+        ComputeKernelTuning& kernel = computeKernels[i];
+        if(!kernel.rebuild || !kernel.run) continue;
+
+        WorkgroupSize bestSize = kernel.size;
+        f64 bestMS = 0;
+        for(u32 c = 0; c < kernel.candidateCount; c++)
+        {
+            WorkgroupSize candidate = kernel.candidates[c];
+            if(candidate.x * candidate.y * candidate.z > device.maxComputeWorkGroupInvocations) continue;
+            kernel.size = candidate;
+            kernel.rebuild();
+            // First run pays for pipeline compilation and cache warmup
+            TimeComputeKernel(kernel);
+            f64 ms = TimeComputeKernel(kernel);
+            LOGF("%20s %4ux%-4u %10.3f\n", kernel.name, candidate.x, candidate.y, ms);
+            if(bestMS == 0 || ms < bestMS)
+            {
+                bestMS = ms;
+                bestSize = candidate;
+            }
+        }
+        kernel.size = bestSize;
+        kernel.rebuild();
+        LOGF("%20s best %ux%ux%u\n", kernel.name, bestSize.x, bestSize.y, bestSize.z);
+    }
+}
+
+};  // namespace Grass
+};  // namespace ty
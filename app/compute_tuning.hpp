@@ -0,0 +1,96 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// Compute workgroup sizes come from specialization constants 0, 1, 2 (local_size_x_id etc.),
+// so they are chosen at pipeline creation instead of being hardcoded in shader and dispatch.
+// Sizes are autotuned per device by timing each candidate on the kernel's real workload, and the
+// winners are persisted per vendor/device/driver. Tuning runs at startup when no file exists
+// for the current device, or when forced with --autotune.
+// New compute passes add a ComputeKernel entry, with candidates plus rebuild/run callbacks.
+
+#define COMPUTE_TUNING_DIRECTORY "resources/tuning"
+#define COMPUTE_TUNING_PATH COMPUTE_TUNING_DIRECTORY"/"
+
+namespace ty
+{
+namespace Grass
+{
+
+enum ComputeKernel
+{
+    COMPUTE_KERNEL_GRASS_POSITIONS,
+    COMPUTE_KERNEL_GRASS_CULL,
+    COMPUTE_KERNEL_COUNT,
+};
+
+struct WorkgroupSize
+{
+    u32 x = 1;
+    u32 y = 1;
+    u32 z = 1;
+};
+
+typedef void (*ComputeKernelRebuildFunc)();                                 // Recreates pipeline with current size
+typedef void (*ComputeKernelRunFunc)(Handle<render::CommandBuffer> hCmd);   // Records representative workload
+
+#define MAX_WORKGROUP_CANDIDATES 8
+
+struct ComputeKernelTuning
+{
+    const char* name = NULL;
+    WorkgroupSize size = {};        // Current, used for pipeline creation and dispatch counts
+    WorkgroupSize candidates[MAX_WORKGROUP_CANDIDATES];
+    u32 candidateCount = 0;
+    ComputeKernelRebuildFunc rebuild = NULL;
+    ComputeKernelRunFunc run = NULL;
+};
+
+const u32 computeTuningMagic = 0x4E555443;     // "CTUN"
+const u32 computeTuningVersion = 1;
+const i32 computeTuningIterations = 16;
+
+struct ComputeTuningHeader
+{
+    u32 magic = computeTuningMagic;
+    u32 version = computeTuningVersion;
+    u32 vendorID = 0;
+    u32 deviceID = 0;
+    u32 driverVersion = 0;
+    u32 kernelCount = 0;
+};
+// One WorkgroupSize per kernel follows header, in ComputeKernel order
+
+inline bool computeAutotuneForced = false;    // --autotune
+
+inline ComputeKernelTuning computeKernels[COMPUTE_KERNEL_COUNT] =
+{
+    {
+        .name = "grass_positions",
+        .size = { 16, 16, 1 },
+        .candidates = { { 8, 8, 1 }, { 16, 8, 1 }, { 16, 16, 1 }, { 32, 8, 1 }, { 32, 16, 1 }, { 32, 32, 1 } },
+        .candidateCount = 6,
+    },
+    {
+        .name = "grass_cull",
+        .size = { 64, 1, 1 },
+        .candidates = { { 32, 1, 1 }, { 64, 1, 1 }, { 128, 1, 1 }, { 256, 1, 1 }, { 512, 1, 1 } },
+        .candidateCount = 5,
+    },
+};
+
+void RegisterComputeKernel(ComputeKernel kernel, ComputeKernelRebuildFunc rebuild, ComputeKernelRunFunc run);
+WorkgroupSize GetWorkgroupSize(ComputeKernel kernel);
+// Fills specialization constants 0..2 with kernel's workgroup size
+void SetWorkgroupSpecialization(render::ComputePipelineDesc* desc, ComputeKernel kernel);
+// Workgroup count covering count invocations along one axis
+u32 GetWorkgroupCount(u32 count, u32 workgroupSize);
+
+// Returns false when there is no valid tuning file for current device
+bool LoadComputeTuning();
+bool SaveComputeTuning();
+// Times every candidate of every registered kernel and keeps the fastest. Pipelines are rebuilt.
+void AutotuneCompute();
+
+};  // namespace Grass
+};  // namespace ty
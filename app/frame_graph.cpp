@@ -0,0 +1,549 @@
+#include "app/frame_graph.hpp"
+#include "engine/src/core/debug.hpp"
+
+#include "app/render_utils.hpp"
+#include "app/gpu_memory.hpp"
+
+namespace ty
+{
+namespace Grass
+{
+
+struct FrameGraphUsageInfo
+{
+    render::MemoryAccess srcAccess;     // Made available when this usage is a barrier source
+    render::MemoryAccess dstAccess;     // Made visible when this usage is a barrier destination
+    render::MemoryAccess dstWriteAccess;    // Also made visible for usages that read and write, by a second barrier
+    render::PipelineStage stage;
+    render::ImageLayout layout;         // Undefined for buffer only usages
+    bool read;
+    bool write;
+    const char* name;
+};
+
+const FrameGraphUsageInfo frameGraphUsageInfos[FRAME_GRAPH_USAGE_COUNT] =
+{
+    { render::MEMORY_ACCESS_TRANSFER_WRITE, render::MEMORY_ACCESS_TRANSFER_WRITE, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_TRANSFER, render::IMAGE_LAYOUT_TRANSFER_DST, false, true, "transfer write" },
+    { render::MEMORY_ACCESS_NONE, render::MEMORY_ACCESS_TRANSFER_READ, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_TRANSFER, render::IMAGE_LAYOUT_TRANSFER_SRC, true, false, "transfer read" },
+    { render::MEMORY_ACCESS_COLOR_OUTPUT_WRITE, render::MEMORY_ACCESS_COLOR_OUTPUT_WRITE, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_COLOR_OUTPUT, render::IMAGE_LAYOUT_COLOR_OUTPUT, true, true, "color output" },
+    { render::MEMORY_ACCESS_NONE, render::MEMORY_ACCESS_SHADER_READ, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_COMPUTE_SHADER, render::IMAGE_LAYOUT_SHADER_READ_ONLY, true, false, "compute read" },
+    { render::MEMORY_ACCESS_SHADER_WRITE, render::MEMORY_ACCESS_SHADER_READ, render::MEMORY_ACCESS_SHADER_WRITE, render::PIPELINE_STAGE_COMPUTE_SHADER, render::IMAGE_LAYOUT_UNDEFINED, true, true, "compute write" },
+    { render::MEMORY_ACCESS_NONE, render::MEMORY_ACCESS_SHADER_READ, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_VERTEX_SHADER, render::IMAGE_LAYOUT_SHADER_READ_ONLY, true, false, "vertex read" },
+    { render::MEMORY_ACCESS_NONE, render::MEMORY_ACCESS_INDIRECT_READ, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_DRAW_INDIRECT, render::IMAGE_LAYOUT_UNDEFINED, true, false, "indirect read" },
+    { render::MEMORY_ACCESS_NONE, render::MEMORY_ACCESS_SHADER_READ, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_FRAGMENT_SHADER, render::IMAGE_LAYOUT_SHADER_READ_ONLY, true, false, "fragment read" },
+    { render::MEMORY_ACCESS_SHADER_WRITE, render::MEMORY_ACCESS_SHADER_READ, render::MEMORY_ACCESS_SHADER_WRITE, render::PIPELINE_STAGE_FRAGMENT_SHADER, render::IMAGE_LAYOUT_UNDEFINED, true, true, "fragment write" },
+    { render::MEMORY_ACCESS_DEPTH_OUTPUT_WRITE, render::MEMORY_ACCESS_DEPTH_OUTPUT_WRITE, render::MEMORY_ACCESS_NONE, render::PIPELINE_STAGE_DEPTH_OUTPUT, render::IMAGE_LAYOUT_DEPTH_OUTPUT, true, true, "depth output" },
+};
+
+// Resource state while walking passes during compile
+struct FrameGraphResourceState
+{
+    FrameGraphUsage lastWrite = FRAME_GRAPH_USAGE_NONE;
+    u32 readsSinceWrite = 0;    // Usage bits
+    u32 visibleUsages = 0;      // Usage bits already synchronized against lastWrite
+    render::ImageLayout layout = render::IMAGE_LAYOUT_UNDEFINED;
+};
+
+void BeginFrameGraph(FrameGraph* graph)
+{
+    ASSERT(graph);
+    graph->passCount = 0;
+    graph->resourceCount = 0;
+    graph->transientSlotCount = 0;
+}
+
+FrameGraphResource AddFrameGraphResource(FrameGraph* graph, FrameGraphResourceDesc desc)
+{
+    ASSERT(graph->resourceCount < MAX_FRAME_GRAPH_RESOURCES);
+    graph->resources[graph->resourceCount] = desc;
+    return graph->resourceCount++;
+}
+
+FrameGraphResource ImportFrameGraphBuffer(FrameGraph* graph, const char* name, Handle<render::Buffer> hBuffer, FrameGraphUsage initialUsage)
+{
+    FrameGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.type = FRAME_GRAPH_RESOURCE_BUFFER;
+    desc.hBuffer = hBuffer;
+    desc.initialUsage = initialUsage;
+    return AddFrameGraphResource(graph, desc);
+}
+
+FrameGraphResource ImportFrameGraphTexture(FrameGraph* graph, const char* name, Handle<render::Texture> hTexture, FrameGraphUsage initialUsage)
+{
+    FrameGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.type = FRAME_GRAPH_RESOURCE_TEXTURE;
+    desc.hTexture = hTexture;
+    desc.initialUsage = initialUsage;
+    return AddFrameGraphResource(graph, desc);
+}
+
+FrameGraphResource CreateFrameGraphBuffer(FrameGraph* graph, const char* name, u64 size)
+{
+    FrameGraphResourceDesc desc = {};
+    desc.name = name;
+    desc.type = FRAME_GRAPH_RESOURCE_BUFFER;
+    desc.transient = true;
+    desc.size = size;
+    return AddFrameGraphResource(graph, desc);
+}
+
+i32 AddFrameGraphPass(FrameGraph* graph, const char* name, FrameGraphPassFunc execute, bool hasSideEffects)
+{
+    ASSERT(graph->passCount < MAX_FRAME_GRAPH_PASSES);
+    FrameGraphPass& pass = graph->passes[graph->passCount];
+    pass = {};
+    pass.name = name;
+    pass.execute = execute;
+    pass.hasSideEffects = hasSideEffects;
+    return graph->passCount++;
+}
+
+void UseFrameGraphResource(FrameGraph* graph, i32 pass, FrameGraphResource resource, FrameGraphUsage usage)
+{
+    ASSERT(pass >= 0 && pass < graph->passCount);
+    ASSERT(resource >= 0 && resource < graph->resourceCount);
+    ASSERT(usage < FRAME_GRAPH_USAGE_COUNT);
+    // Buffer only usages have no image layout
+    ASSERT(graph->resources[resource].type == FRAME_GRAPH_RESOURCE_BUFFER
+            || frameGraphUsageInfos[usage].layout != render::IMAGE_LAYOUT_UNDEFINED);
+    FrameGraphPass& p = graph->passes[pass];
+    ASSERT(p.useCount < MAX_FRAME_GRAPH_PASS_USES);
+    p.uses[p.useCount++] = { resource, usage };
+}
+
+void CullFrameGraphPasses(FrameGraph* graph)
+{
+    // Walk back from passes with side effects, keeping passes that write something read later
+    bool needed[MAX_FRAME_GRAPH_RESOURCES] = {};
+    for(i32 p = graph->passCount - 1; p >= 0; p--)
+    {
+        FrameGraphPass& pass = graph->passes[p];
+        pass.culled = !pass.hasSideEffects;
+        for(i32 u = 0; u < pass.useCount && pass.culled; u++)
+        {
+            if(frameGraphUsageInfos[pass.uses[u].usage].write && needed[pass.uses[u].resource]) pass.culled = false;
+        }
+        if(pass.culled) continue;
+
+        // Pure writes overwrite earlier contents, so earlier writers are only needed if read here
+        for(i32 u = 0; u < pass.useCount; u++)
+        {
+            const FrameGraphUsageInfo& info = frameGraphUsageInfos[pass.uses[u].usage];
+            if(info.write && !info.read) needed[pass.uses[u].resource] = false;
+        }
+        for(i32 u = 0; u < pass.useCount; u++)
+        {
+            if(frameGraphUsageInfos[pass.uses[u].usage].read) needed[pass.uses[u].resource] = true;
+        }
+    }
+}
+
+void AssignFrameGraphTransients(FrameGraph* graph)
+{
+    for(i32 p = 0; p < graph->passCount; p++)
+    {
+        FrameGraphPass& pass = graph->passes[p];
+        if(pass.culled) continue;
+        for(i32 u = 0; u < pass.useCount; u++)
+        {
+            FrameGraphResourceDesc& resource = graph->resources[pass.uses[u].resource];
+            if(resource.firstPass < 0) resource.firstPass = p;
+            resource.lastPass = p;
+        }
+    }
+
+    // Greedy in first use order, a slot is free once its previous resource's last pass is before this one's first
+    i32 slotLastPass[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS];
+    i32 slotFirstResource[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS];
+    u64 slotSize[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS] = {};
+    for(i32 p = 0; p < graph->passCount; p++)
+    {
+        for(i32 r = 0; r < graph->resourceCount; r++)
+        {
+            FrameGraphResourceDesc& resource = graph->resources[r];
+            if(!resource.transient || resource.firstPass != p) continue;
+            i32 slot = -1;
+            for(i32 s = 0; s < graph->transientSlotCount; s++)
+            {
+                if(slotLastPass[s] < resource.firstPass)
+                {
+                    slot = s;
+                    break;
+                }
+            }
+            if(slot < 0)
+            {
+                ASSERT(graph->transientSlotCount < MAX_FRAME_GRAPH_TRANSIENT_BUFFERS);
+                slot = graph->transientSlotCount++;
+                slotFirstResource[slot] = r;
+            }
+            resource.transientSlot = slot;
+            slotLastPass[slot] = resource.lastPass;
+            slotSize[slot] = MAX(slotSize[slot], resource.size);
+        }
+    }
+
+    // Physical buffers persist across frames and only grow. Slots unused this frame release theirs,
+    // e.g. splat buffer once splatting is off.
+    for(i32 s = graph->transientSlotCount; s < graph->transientBufferCount; s++)
+    {
+        DeferDestroyBuffer(graph->transientBuffers[s].hBuffer);
+        graph->transientBuffers[s] = {};
+    }
+    graph->transientBufferCount = graph->transientSlotCount;
+    for(i32 s = 0; s < graph->transientSlotCount; s++)
+    {
+        FrameGraphTransientBuffer& buffer = graph->transientBuffers[s];
+        if(buffer.size < slotSize[s])
+        {
+            if(buffer.hBuffer.IsValid()) DeferDestroyBuffer(buffer.hBuffer);
+            buffer.size = slotSize[s];
+            buffer.hBuffer = MakeGpuBuffer("Frame graph transient", render::BUFFER_TYPE_STORAGE, buffer.size, buffer.size);
+            buffer.lastUsage = FRAME_GRAPH_USAGE_NONE;
+        }
+        // Previous frame's last use of the physical buffer, whichever resource it was
+        graph->resources[slotFirstResource[s]].initialUsage = buffer.lastUsage;
+    }
+}
+
+i32 GetPipelineStageOrder(render::PipelineStage stage)
+{
+    // Graphics stages in pipeline order. A dependency from a stage also covers earlier ones.
+    switch(stage)
+    {
+        case render::PIPELINE_STAGE_DRAW_INDIRECT: return 1;
+        case render::PIPELINE_STAGE_VERTEX_SHADER: return 2;
+        case render::PIPELINE_STAGE_FRAGMENT_SHADER: return 3;
+        case render::PIPELINE_STAGE_COLOR_OUTPUT: return 4;
+        default: return 0;
+    }
+}
+
+void AddFrameGraphBarrier(FrameGraphPass& pass, FrameGraphBarrier barrier)
+{
+    // Global barriers apply to all buffers, so identical ones from different resources merge
+    if(!barrier.hTexture.IsValid())
+    {
+        for(i32 i = 0; i < pass.barrierCount; i++)
+        {
+            render::Barrier& other = pass.barriers[i].barrier;
+            if(pass.barriers[i].hTexture.IsValid()) continue;
+            if(other.srcAccess == barrier.barrier.srcAccess && other.dstAccess == barrier.barrier.dstAccess
+                    && other.srcStage == barrier.barrier.srcStage && other.dstStage == barrier.barrier.dstStage)
+            {
+                return;
+            }
+        }
+    }
+    ASSERT(pass.barrierCount < MAX_FRAME_GRAPH_PASS_BARRIERS);
+    pass.barriers[pass.barrierCount++] = barrier;
+}
+
+// Engine barriers make a single access visible, so usages that also write get a second barrier
+// for it, otherwise writes after writes would only be visible to reads
+void AddFrameGraphUsageBarrier(FrameGraphPass& pass, FrameGraphBarrier barrier, const FrameGraphUsageInfo& info)
+{
+    AddFrameGraphBarrier(pass, barrier);
+    if(info.dstWriteAccess == render::MEMORY_ACCESS_NONE) return;
+    barrier.barrier.dstAccess = info.dstWriteAccess;
+    // Layout was already transitioned by first barrier
+    barrier.hTexture = {};
+    barrier.layout = render::IMAGE_LAYOUT_UNDEFINED;
+    AddFrameGraphBarrier(pass, barrier);
+}
+
+bool IsExecutionOnlyBarrier(FrameGraphBarrier& barrier)
+{
+    return !barrier.hTexture.IsValid()
+        && barrier.barrier.srcAccess == render::MEMORY_ACCESS_NONE
+        && barrier.barrier.dstAccess == render::MEMORY_ACCESS_NONE;
+}
+
+void MergeFrameGraphBarriers(FrameGraphPass& pass)
+{
+    // Execution only barriers are dropped when another barrier to the same stage
+    // starts at the same or a later graphics stage
+    i32 i = 0;
+    while(i < pass.barrierCount)
+    {
+        FrameGraphBarrier& barrier = pass.barriers[i];
+        i32 order = GetPipelineStageOrder(barrier.barrier.srcStage);
+        bool covered = false;
+        for(i32 j = 0; j < pass.barrierCount && IsExecutionOnlyBarrier(barrier) && !covered; j++)
+        {
+            if(j == i) continue;
+            FrameGraphBarrier& other = pass.barriers[j];
+            if(other.barrier.dstStage != barrier.barrier.dstStage) continue;
+            bool sameStage = other.barrier.srcStage == barrier.barrier.srcStage;
+            bool laterStage = order > 0 && GetPipelineStageOrder(other.barrier.srcStage) > order;
+            // Identical execution only barriers were already merged when added
+            covered = laterStage || (sameStage && !IsExecutionOnlyBarrier(other));
+        }
+        if(covered)
+        {
+            // Keep order, barriers are few
+            for(i32 j = i; j < pass.barrierCount - 1; j++) pass.barriers[j] = pass.barriers[j + 1];
+            pass.barrierCount--;
+            continue;
+        }
+        i++;
+    }
+}
+
+void ComputeFrameGraphBarriers(FrameGraph* graph)
+{
+    FrameGraphResourceState states[MAX_FRAME_GRAPH_RESOURCES] = {};
+    for(i32 r = 0; r < graph->resourceCount; r++)
+    {
+        FrameGraphResourceDesc& resource = graph->resources[r];
+        FrameGraphUsage initialUsage = resource.initialUsage;
+        if(initialUsage == FRAME_GRAPH_USAGE_NONE) continue;
+        if(frameGraphUsageInfos[initialUsage].write) states[r].lastWrite = initialUsage;
+        else states[r].readsSinceWrite = 1u << initialUsage;
+        // Engine tracks actual image layouts, this only decides when a transition is needed
+        states[r].layout = frameGraphUsageInfos[initialUsage].layout;
+    }
+
+    // Aliased transients inherit hazards from the slot's previous resource
+    i32 slotOwner[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS];
+    FrameGraphUsage slotLastUsage[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS];
+    for(i32 s = 0; s < MAX_FRAME_GRAPH_TRANSIENT_BUFFERS; s++)
+    {
+        slotOwner[s] = -1;
+        slotLastUsage[s] = FRAME_GRAPH_USAGE_NONE;
+    }
+
+    for(i32 p = 0; p < graph->passCount; p++)
+    {
+        FrameGraphPass& pass = graph->passes[p];
+        pass.barrierCount = 0;
+        if(pass.culled) continue;
+        for(i32 u = 0; u < pass.useCount; u++)
+        {
+            FrameGraphResource r = pass.uses[u].resource;
+            FrameGraphUsage usage = pass.uses[u].usage;
+            FrameGraphResourceDesc& resource = graph->resources[r];
+            FrameGraphResourceState& state = states[r];
+            if(resource.transient)
+            {
+                if(resource.firstPass == p && slotOwner[resource.transientSlot] != r)
+                {
+                    if(slotOwner[resource.transientSlot] >= 0) state = states[slotOwner[resource.transientSlot]];
+                    state.visibleUsages = 0;
+                    slotOwner[resource.transientSlot] = r;
+                }
+                slotLastUsage[resource.transientSlot] = usage;
+            }
+            const FrameGraphUsageInfo& info = frameGraphUsageInfos[usage];
+
+            bool isTexture = resource.type == FRAME_GRAPH_RESOURCE_TEXTURE;
+            bool layoutChange = isTexture && state.layout != info.layout;
+            // Attachment writes in consecutive render passes are ordered by render pass dependencies
+            bool attachmentChain = (usage == FRAME_GRAPH_USAGE_COLOR_OUTPUT || usage == FRAME_GRAPH_USAGE_DEPTH_OUTPUT)
+                && state.lastWrite == usage;
+            bool readAfterWrite = state.lastWrite != FRAME_GRAPH_USAGE_NONE && !(state.visibleUsages & (1u << usage)) && !attachmentChain;
+            bool writeAfterRead = info.write && state.readsSinceWrite;
+
+            if(isTexture && (layoutChange || readAfterWrite || writeAfterRead))
+            {
+                FrameGraphBarrier barrier = {};
+                barrier.resource = r;
+                barrier.barrier.srcAccess = render::MEMORY_ACCESS_NONE;
+                barrier.barrier.srcStage = render::PIPELINE_STAGE_TOP;
+                if(state.lastWrite != FRAME_GRAPH_USAGE_NONE)
+                {
+                    barrier.barrier.srcAccess = frameGraphUsageInfos[state.lastWrite].srcAccess;
+                    barrier.barrier.srcStage = frameGraphUsageInfos[state.lastWrite].stage;
+                }
+                if((layoutChange || writeAfterRead) && state.readsSinceWrite)
+                {
+                    // Every read since last write finishes before transition or write. Each read stage gets an
+                    // execution only barrier into first read's stage, which the transition then waits on.
+                    // Last write was already made available to first read, so chain carries it along.
+                    i32 firstRead = -1;
+                    for(i32 b = 0; b < FRAME_GRAPH_USAGE_COUNT; b++)
+                    {
+                        if(!(state.readsSinceWrite & (1u << b))) continue;
+                        if(firstRead < 0)
+                        {
+                            firstRead = b;
+                            continue;
+                        }
+                        FrameGraphBarrier readBarrier = {};
+                        readBarrier.resource = r;
+                        readBarrier.barrier.srcAccess = render::MEMORY_ACCESS_NONE;
+                        readBarrier.barrier.srcStage = frameGraphUsageInfos[b].stage;
+                        readBarrier.barrier.dstAccess = render::MEMORY_ACCESS_NONE;
+                        readBarrier.barrier.dstStage = frameGraphUsageInfos[firstRead].stage;
+                        AddFrameGraphBarrier(pass, readBarrier);
+                    }
+                    barrier.barrier.srcAccess = render::MEMORY_ACCESS_NONE;
+                    barrier.barrier.srcStage = frameGraphUsageInfos[firstRead].stage;
+                }
+                barrier.barrier.dstAccess = info.dstAccess;
+                barrier.barrier.dstStage = info.stage;
+                if(layoutChange)
+                {
+                    barrier.hTexture = resource.hTexture;
+                    barrier.layout = info.layout;
+                    state.layout = info.layout;
+                }
+                AddFrameGraphUsageBarrier(pass, barrier, info);
+            }
+            else if(!isTexture)
+            {
+                if(readAfterWrite)
+                {
+                    FrameGraphBarrier barrier = {};
+                    barrier.resource = r;
+                    barrier.barrier.srcAccess = frameGraphUsageInfos[state.lastWrite].srcAccess;
+                    barrier.barrier.srcStage = frameGraphUsageInfos[state.lastWrite].stage;
+                    barrier.barrier.dstAccess = info.dstAccess;
+                    barrier.barrier.dstStage = info.stage;
+                    AddFrameGraphUsageBarrier(pass, barrier, info);
+                }
+                if(writeAfterRead)
+                {
+                    // Only needs execution ordering, reads don't make anything available
+                    for(i32 b = 0; b < FRAME_GRAPH_USAGE_COUNT; b++)
+                    {
+                        if(!(state.readsSinceWrite & (1u << b))) continue;
+                        FrameGraphBarrier barrier = {};
+                        barrier.resource = r;
+                        barrier.barrier.srcAccess = render::MEMORY_ACCESS_NONE;
+                        barrier.barrier.srcStage = frameGraphUsageInfos[b].stage;
+                        barrier.barrier.dstAccess = render::MEMORY_ACCESS_NONE;
+                        barrier.barrier.dstStage = info.stage;
+                        AddFrameGraphBarrier(pass, barrier);
+                    }
+                }
+            }
+
+            if(info.write)
+            {
+                state.lastWrite = usage;
+                state.readsSinceWrite = 0;
+                state.visibleUsages = 0;
+            }
+            else
+            {
+                state.readsSinceWrite |= 1u << usage;
+                state.visibleUsages |= 1u << usage;
+            }
+        }
+        MergeFrameGraphBarriers(pass);
+    }
+
+    for(i32 s = 0; s < graph->transientSlotCount; s++)
+    {
+        graph->transientBuffers[s].lastUsage = slotLastUsage[s];
+    }
+}
+
+void CompileFrameGraph(FrameGraph* graph)
+{
+    ASSERT(graph);
+    CullFrameGraphPasses(graph);
+    AssignFrameGraphTransients(graph);
+    ComputeFrameGraphBarriers(graph);
+    if(graph->printNext)
+    {
+        PrintFrameGraph(graph);
+        graph->printNext = false;
+    }
+}
+
+void ExecuteFrameGraph(FrameGraph* graph, Handle<render::CommandBuffer> hCmd)
+{
+    for(i32 p = 0; p < graph->passCount; p++)
+    {
+        FrameGraphPass& pass = graph->passes[p];
+        if(pass.culled) continue;
+        for(i32 b = 0; b < pass.barrierCount; b++)
+        {
+            FrameGraphBarrier& barrier = pass.barriers[b];
+            if(barrier.hTexture.IsValid())
+            {
+                render::CmdPipelineBarrierTextureLayout(hCmd, barrier.hTexture, barrier.layout, barrier.barrier);
+            }
+            else
+            {
+                render::CmdPipelineBarrier(hCmd, barrier.barrier);
+            }
+        }
+        pass.execute(hCmd);
+    }
+}
+
+Handle<render::Buffer> GetFrameGraphBuffer(FrameGraph* graph, FrameGraphResource resource)
+{
+    ASSERT(resource >= 0 && resource < graph->resourceCount);
+    FrameGraphResourceDesc& desc = graph->resources[resource];
+    ASSERT(desc.type == FRAME_GRAPH_RESOURCE_BUFFER);
+    if(!desc.transient) return desc.hBuffer;
+    ASSERT(desc.transientSlot >= 0);
+    return graph->transientBuffers[desc.transientSlot].hBuffer;
+}
+
+const char* GetPipelineStageName(render::PipelineStage stage)
+{
+    switch(stage)
+    {
+        case render::PIPELINE_STAGE_TOP: return "top";
+        case render::PIPELINE_STAGE_TRANSFER: return "transfer";
+        case render::PIPELINE_STAGE_COLOR_OUTPUT: return "color output";
+        case render::PIPELINE_STAGE_DEPTH_OUTPUT: return "depth output";
+        case render::PIPELINE_STAGE_COMPUTE_SHADER: return "compute";
+        case render::PIPELINE_STAGE_VERTEX_SHADER: return "vertex";
+        case render::PIPELINE_STAGE_FRAGMENT_SHADER: return "fragment";
+        case render::PIPELINE_STAGE_DRAW_INDIRECT: return "draw indirect";
+        default: return "?";
+    }
+}
+
+void PrintFrameGraph(FrameGraph* graph)
+{
+    LOGF("Frame graph: %d passes, %d resources, %d transient slots\n",
+            graph->passCount, graph->resourceCount, graph->transientSlotCount);
+    for(i32 p = 0; p < graph->passCount; p++)
+    {
+        FrameGraphPass& pass = graph->passes[p];
+        LOGF("  [%d] %s%s\n", p, pass.name, pass.culled ? " (culled)" : "");
+        if(pass.culled) continue;
+        for(i32 b = 0; b < pass.barrierCount; b++)
+        {
+            FrameGraphBarrier& barrier = pass.barriers[b];
+            LOGF("      barrier %s -> %s%s (%s)\n",
+                    GetPipelineStageName(barrier.barrier.srcStage),
+                    GetPipelineStageName(barrier.barrier.dstStage),
+                    barrier.hTexture.IsValid() ? ", layout transition" : "",
+                    graph->resources[barrier.resource].name);
+        }
+        for(i32 u = 0; u < pass.useCount; u++)
+        {
+            LOGF("      %-14s %s\n", frameGraphUsageInfos[pass.uses[u].usage].name, graph->resources[pass.uses[u].resource].name);
+        }
+    }
+    for(i32 r = 0; r < graph->resourceCount; r++)
+    {
+        FrameGraphResourceDesc& resource = graph->resources[r];
+        if(!resource.transient) continue;
+        LOGF("  transient %s: %llu bytes, passes %d-%d, slot %d\n",
+                resource.name, resource.size, resource.firstPass, resource.lastPass, resource.transientSlot);
+    }
+}
+
+void DestroyFrameGraph(FrameGraph* graph)
+{
+    for(i32 s = 0; s < graph->transientBufferCount; s++)
+    {
+        if(graph->transientBuffers[s].hBuffer.IsValid()) DeferDestroyBuffer(graph->transientBuffers[s].hBuffer);
+        graph->transientBuffers[s] = {};
+    }
+    graph->transientBufferCount = 0;
+}
+
+};  // namespace Grass
+};  // namespace ty
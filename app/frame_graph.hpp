@@ -0,0 +1,129 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// Small frame graph. Passes are added in execution order each frame, declaring how they use
+// each resource. Compile culls passes whose results nothing reads, computes the barriers
+// each pass needs from the last use of every resource, drops duplicate and already satisfied
+// barriers, and assigns transient buffers with disjoint lifetimes to shared physical buffers.
+// Transient contents are undefined at their first use in a frame, so that use has to overwrite them.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum FrameGraphUsage
+{
+    FRAME_GRAPH_USAGE_TRANSFER_WRITE,
+    FRAME_GRAPH_USAGE_TRANSFER_READ,
+    FRAME_GRAPH_USAGE_COLOR_OUTPUT,     // Render pass attachment, loaded and stored
+    FRAME_GRAPH_USAGE_COMPUTE_READ,
+    FRAME_GRAPH_USAGE_COMPUTE_WRITE,    // Includes atomics, so also reads
+    FRAME_GRAPH_USAGE_VERTEX_READ,
+    FRAME_GRAPH_USAGE_INDIRECT_READ,
+    FRAME_GRAPH_USAGE_FRAGMENT_READ,
+    FRAME_GRAPH_USAGE_FRAGMENT_WRITE,   // Includes atomics, so also reads
+    FRAME_GRAPH_USAGE_DEPTH_OUTPUT,     // Render pass depth attachment, loaded and stored
+    FRAME_GRAPH_USAGE_COUNT,
+    FRAME_GRAPH_USAGE_NONE = FRAME_GRAPH_USAGE_COUNT,
+};
+
+enum FrameGraphResourceType
+{
+    FRAME_GRAPH_RESOURCE_BUFFER,
+    FRAME_GRAPH_RESOURCE_TEXTURE,
+};
+
+typedef i32 FrameGraphResource;
+typedef void (*FrameGraphPassFunc)(Handle<render::CommandBuffer> hCmd);
+
+#define MAX_FRAME_GRAPH_PASSES 32
+#define MAX_FRAME_GRAPH_RESOURCES 32
+#define MAX_FRAME_GRAPH_PASS_USES 8
+#define MAX_FRAME_GRAPH_PASS_BARRIERS 16
+#define MAX_FRAME_GRAPH_TRANSIENT_BUFFERS 16
+
+struct FrameGraphResourceDesc
+{
+    const char* name = NULL;
+    FrameGraphResourceType type = FRAME_GRAPH_RESOURCE_BUFFER;
+    Handle<render::Buffer> hBuffer;
+    Handle<render::Texture> hTexture;
+    FrameGraphUsage initialUsage = FRAME_GRAPH_USAGE_NONE;  // Last use in previous frame
+    bool transient = false;
+    u64 size = 0;                   // Transient buffers only
+
+    // Compiled
+    i32 firstPass = -1;
+    i32 lastPass = -1;
+    i32 transientSlot = -1;
+};
+
+struct FrameGraphPassUse
+{
+    FrameGraphResource resource = -1;
+    FrameGraphUsage usage = FRAME_GRAPH_USAGE_NONE;
+};
+
+struct FrameGraphBarrier
+{
+    render::Barrier barrier = {};
+    Handle<render::Texture> hTexture;   // Valid when barrier is a layout transition
+    render::ImageLayout layout = render::IMAGE_LAYOUT_UNDEFINED;
+    FrameGraphResource resource = -1;
+};
+
+struct FrameGraphPass
+{
+    const char* name = NULL;
+    FrameGraphPassFunc execute = NULL;
+    bool hasSideEffects = false;    // Never culled, e.g. present
+    FrameGraphPassUse uses[MAX_FRAME_GRAPH_PASS_USES];
+    i32 useCount = 0;
+
+    // Compiled
+    bool culled = false;
+    FrameGraphBarrier barriers[MAX_FRAME_GRAPH_PASS_BARRIERS];
+    i32 barrierCount = 0;
+};
+
+struct FrameGraphTransientBuffer
+{
+    Handle<render::Buffer> hBuffer;
+    u64 size = 0;
+    FrameGraphUsage lastUsage = FRAME_GRAPH_USAGE_NONE;     // Last use in previous frame, by any resource in slot
+};
+
+struct FrameGraph
+{
+    FrameGraphPass passes[MAX_FRAME_GRAPH_PASSES];
+    i32 passCount = 0;
+    FrameGraphResourceDesc resources[MAX_FRAME_GRAPH_RESOURCES];
+    i32 resourceCount = 0;
+
+    // Physical buffers backing transient resources, kept across frames while slots are used
+    FrameGraphTransientBuffer transientBuffers[MAX_FRAME_GRAPH_TRANSIENT_BUFFERS];
+    i32 transientBufferCount = 0;
+    i32 transientSlotCount = 0;     // Used this frame
+
+    bool printNext = false;         // Log next compiled graph
+};
+
+inline FrameGraph frameGraph = {};
+
+void BeginFrameGraph(FrameGraph* graph);
+FrameGraphResource ImportFrameGraphBuffer(FrameGraph* graph, const char* name, Handle<render::Buffer> hBuffer, FrameGraphUsage initialUsage = FRAME_GRAPH_USAGE_NONE);
+FrameGraphResource ImportFrameGraphTexture(FrameGraph* graph, const char* name, Handle<render::Texture> hTexture, FrameGraphUsage initialUsage = FRAME_GRAPH_USAGE_NONE);
+FrameGraphResource CreateFrameGraphBuffer(FrameGraph* graph, const char* name, u64 size);
+i32 AddFrameGraphPass(FrameGraph* graph, const char* name, FrameGraphPassFunc execute, bool hasSideEffects = false);
+void UseFrameGraphResource(FrameGraph* graph, i32 pass, FrameGraphResource resource, FrameGraphUsage usage);
+void CompileFrameGraph(FrameGraph* graph);
+void ExecuteFrameGraph(FrameGraph* graph, Handle<render::CommandBuffer> hCmd);
+// Valid after compile, for both imported and transient buffers
+Handle<render::Buffer> GetFrameGraphBuffer(FrameGraph* graph, FrameGraphResource resource);
+void PrintFrameGraph(FrameGraph* graph);
+void DestroyFrameGraph(FrameGraph* graph);
+
+};  // namespace Grass
+};  // namespace ty
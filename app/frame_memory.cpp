@@ -0,0 +1,139 @@
+#include "app/frame_memory.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/memory.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/state.hpp"
+
+namespace ty
+{
+namespace Grass
+{
+
+// Size is kept in front of each heap allocation, so frees can be accounted for
+const u64 appHeapHeaderSize = 16;
+
+void TrackAlloc(MemoryStats* stats, u64 size)
+{
+    stats->liveBytes += size;
+    stats->highWaterBytes = MAX(stats->highWaterBytes, stats->liveBytes);
+    stats->liveAllocations++;
+    stats->totalAllocations++;
+}
+
+void TrackFree(MemoryStats* stats, u64 size)
+{
+    ASSERT(stats->liveBytes >= size && stats->liveAllocations > 0);
+    stats->liveBytes -= size;
+    stats->liveAllocations--;
+}
+
+void* AppHeapAlloc(u64 size)
+{
+    mem::SetContext(&appHeap);
+    u8* data = (u8*)mem::Alloc(size + appHeapHeaderSize);
+    ASSERT(data);
+    *(u64*)data = size;
+    TrackAlloc(&appHeapStats, size);
+    return data + appHeapHeaderSize;
+}
+
+void AppHeapFree(void* data)
+{
+    if(!data) return;
+    u8* header = (u8*)data - appHeapHeaderSize;
+    TrackFree(&appHeapStats, *(u64*)header);
+    mem::SetContext(&appHeap);
+    mem::Free(header);
+}
+
+LinearArena MakeLinearArena(u64 capacity)
+{
+    LinearArena result = {};
+    result.data = (u8*)AppHeapAlloc(capacity);
+    result.capacity = capacity;
+    return result;
+}
+
+void DestroyLinearArena(LinearArena* arena)
+{
+    ASSERT(arena);
+    AppHeapFree(arena->data);
+    *arena = {};
+}
+
+void* ArenaAlloc(LinearArena* arena, u64 size, u64 alignment)
+{
+    ASSERT(arena && arena->data);
+    ASSERT(alignment && (alignment & (alignment - 1)) == 0);
+    u64 start = (arena->offset + alignment - 1) & ~(alignment - 1);
+    // Running out means capacity is undersized for a frame, not something to recover from
+    ASSERT(start + size <= arena->capacity);
+    arena->offset = start + size;
+    TrackAlloc(&arena->stats, size);
+    // High water follows used space including alignment padding
+    arena->stats.highWaterBytes = MAX(arena->stats.highWaterBytes, arena->offset);
+    return arena->data + start;
+}
+
+void ResetArena(LinearArena* arena)
+{
+    ASSERT(arena);
+    arena->offset = 0;
+    arena->stats.liveBytes = 0;
+    arena->stats.liveAllocations = 0;
+}
+
+void InitFrameMemory()
+{
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        frameArenas[i] = MakeLinearArena(frameArenaCapacity);
+    }
+}
+
+void ShutdownFrameMemory()
+{
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        DestroyLinearArena(&frameArenas[i]);
+    }
+    // Anything left here is a leak
+    if(appHeapStats.liveAllocations)
+    {
+        LOGF("App heap: %llu allocations (%llu bytes) still live at shutdown\n",
+                appHeapStats.liveAllocations, appHeapStats.liveBytes);
+    }
+}
+
+void BeginFrameMemory(i32 frame)
+{
+    ResetArena(&frameArenas[frame % RENDER_CONCURRENT_FRAMES]);
+}
+
+LinearArena* GetFrameArena()
+{
+    return &frameArenas[currentFrame % RENDER_CONCURRENT_FRAMES];
+}
+
+void MemoryStatsText(const char* name, MemoryStats stats, u64 capacity)
+{
+    egui::Text("%-10s %8.2f / %8.2f KB, peak %8.2f KB, %llu live / %llu total allocs",
+            name,
+            stats.liveBytes / 1024.0, capacity / 1024.0, stats.highWaterBytes / 1024.0,
+            stats.liveAllocations, stats.totalAllocations);
+}
+
+void UpdateMemoryUI()
+{
+    MemoryStatsText("App heap", appHeapStats, appHeapCapacity);
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "Frame %d", i);
+        MemoryStatsText(name, frameArenas[i].stats, frameArenas[i].capacity);
+    }
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,59 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// App side CPU memory tracking on top of appHeap.
+// Transient per frame data goes into a linear arena per frame in flight, reset once that
+// frame's fence has retired in BeginFrame, so the frame loop never touches the general heap.
+// Longer lived allocations go through AppHeapAlloc/AppHeapFree so they show up in telemetry.
+
+namespace ty
+{
+namespace Grass
+{
+
+const u64 appHeapCapacity = MB(128);        // Frame arenas + init staging (~17 MB splat clear) + map tile staging + bench bakes
+const u64 frameArenaCapacity = MB(8);
+const u64 frameArenaDefaultAlignment = 16;
+
+struct MemoryStats
+{
+    u64 liveBytes = 0;
+    u64 highWaterBytes = 0;
+    u64 liveAllocations = 0;
+    u64 totalAllocations = 0;
+};
+
+struct LinearArena
+{
+    u8* data = NULL;
+    u64 capacity = 0;
+    u64 offset = 0;
+    MemoryStats stats = {};
+};
+
+inline MemoryStats appHeapStats = {};
+inline LinearArena frameArenas[RENDER_CONCURRENT_FRAMES];
+
+void* AppHeapAlloc(u64 size);
+void AppHeapFree(void* data);
+
+LinearArena MakeLinearArena(u64 capacity);
+void DestroyLinearArena(LinearArena* arena);
+void* ArenaAlloc(LinearArena* arena, u64 size, u64 alignment = frameArenaDefaultAlignment);
+void ResetArena(LinearArena* arena);
+template <typename T>
+T* ArenaPush(LinearArena* arena, u64 count = 1)
+{
+    return (T*)ArenaAlloc(arena, sizeof(T) * count, MAX(alignof(T), frameArenaDefaultAlignment));
+}
+
+void InitFrameMemory();
+void ShutdownFrameMemory();
+// Call after BeginFrame, once the frame's previous use has retired
+void BeginFrameMemory(i32 frame);
+LinearArena* GetFrameArena();
+void UpdateMemoryUI();
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,97 @@
+#include "app/governor.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/math.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/state.hpp"
+
+namespace ty
+{
+namespace Grass
+{
+
+void UpdateGovernor(f32 cpuS, f32 gpuS)
+{
+    GovernorSettings& settings = governorSettings;
+    GovernorState& state = governorState;
+
+    f32 cpuMS = cpuS * 1000.f;
+    f32 gpuMS = gpuS * 1000.f;
+    if(state.frameMS == 0)
+    {
+        state.cpuMS = cpuMS;
+        state.gpuMS = gpuMS;
+    }
+    state.cpuMS = math::Lerp(state.cpuMS, cpuMS, settings.smoothing);
+    state.gpuMS = math::Lerp(state.gpuMS, gpuMS, settings.smoothing);
+    state.frameMS = MAX(state.cpuMS, state.gpuMS);
+    state.framesSinceChange++;
+
+    if(settings.targetFrameMS <= 0)
+    {
+        // Disabled, go back to full quality
+        state.densityScale = 1.f;
+        state.renderScaleLevel = 0;
+        return;
+    }
+
+    if(state.frameMS > settings.targetFrameMS * settings.overBudget
+            && state.framesSinceChange >= settings.degradeCooldownFrames)
+    {
+        if(state.densityScale > settings.minDensityScale)
+        {
+            f32 newDensityScale = MAX(settings.minDensityScale, state.densityScale * settings.densityStep);
+            LOGF("Governor (frame %d): %.2f ms (cpu %.2f ms, gpu %.2f ms) over %.2f ms budget, density scale %.2f -> %.2f\n",
+                    currentFrame, state.frameMS, state.cpuMS, state.gpuMS, settings.targetFrameMS, state.densityScale, newDensityScale);
+            state.densityScale = newDensityScale;
+            state.framesSinceChange = 0;
+        }
+        else if(state.renderScaleLevel < settings.maxRenderScaleLevel)
+        {
+            LOGF("Governor (frame %d): %.2f ms (cpu %.2f ms, gpu %.2f ms) over %.2f ms budget, render scale %.2f -> %.2f\n",
+                    currentFrame, state.frameMS, state.cpuMS, state.gpuMS, settings.targetFrameMS,
+                    governorRenderScales[state.renderScaleLevel], governorRenderScales[state.renderScaleLevel + 1]);
+            state.renderScaleLevel++;
+            state.framesSinceChange = 0;
+        }
+    }
+    else if(state.frameMS < settings.targetFrameMS * settings.underBudget
+            && state.framesSinceChange >= settings.restoreCooldownFrames)
+    {
+        if(state.renderScaleLevel > 0)
+        {
+            LOGF("Governor (frame %d): %.2f ms (cpu %.2f ms, gpu %.2f ms) under %.2f ms budget, render scale %.2f -> %.2f\n",
+                    currentFrame, state.frameMS, state.cpuMS, state.gpuMS, settings.targetFrameMS,
+                    governorRenderScales[state.renderScaleLevel], governorRenderScales[state.renderScaleLevel - 1]);
+            state.renderScaleLevel--;
+            state.framesSinceChange = 0;
+        }
+        else if(state.densityScale < 1.f)
+        {
+            f32 newDensityScale = MIN(1.f, state.densityScale / settings.densityStep);
+            LOGF("Governor (frame %d): %.2f ms (cpu %.2f ms, gpu %.2f ms) under %.2f ms budget, density scale %.2f -> %.2f\n",
+                    currentFrame, state.frameMS, state.cpuMS, state.gpuMS, settings.targetFrameMS, state.densityScale, newDensityScale);
+            state.densityScale = newDensityScale;
+            state.framesSinceChange = 0;
+        }
+    }
+}
+
+void UpdateGovernorUI()
+{
+    egui::SliderF32(IStr("Governor Target (ms, 0 = off)"), &governorSettings.targetFrameMS, 0, 50);
+    egui::Text("Governor cost %.2f ms (cpu %.2f ms, gpu %.2f ms)", governorState.frameMS, governorState.cpuMS, governorState.gpuMS);
+}
+
+f32 GetGovernorDensityScale()
+{
+    return governorState.densityScale;
+}
+
+f32 GetGovernorRenderScale()
+{
+    return governorRenderScales[governorState.renderScaleLevel];
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,50 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+
+// Frame time governor. Lowers effective grass density first, then internal render scale,
+// to hold a target frame time, and restores them in reverse order once there is headroom.
+// Hysteresis comes from separate over/under budget thresholds plus a cooldown between steps.
+// Frame cost is the larger of GPU frame duration (timestamps) and CPU recording time. Total frame time
+// isn't used, under FIFO present it's pinned at the vsync interval and never shows headroom.
+
+namespace ty
+{
+namespace Grass
+{
+
+const f32 governorRenderScales[] = { 1.f, 0.85f, 0.7f, 0.5f };
+
+struct GovernorSettings
+{
+    f32 targetFrameMS = 1000.f / 60.f;  // 0 disables governor
+    f32 overBudget = 1.05f;             // Degrade when smoothed frame cost is above target * overBudget
+    f32 underBudget = 0.8f;             // Restore when smoothed frame cost is below target * underBudget
+    f32 smoothing = 0.1f;               // Frame cost exponential moving average factor
+    i32 degradeCooldownFrames = 30;
+    i32 restoreCooldownFrames = 120;    // Restore slower than degrade, so a restored step isn't undone right away
+    f32 minDensityScale = 0.1f;
+    f32 densityStep = 0.8f;
+    i32 maxRenderScaleLevel = ARR_LEN(governorRenderScales) - 1;
+};
+
+struct GovernorState
+{
+    f32 frameMS = 0;        // Smoothed frame cost, larger of CPU and GPU
+    f32 cpuMS = 0;          // Smoothed render thread recording time, excludes fence and present waits
+    f32 gpuMS = 0;          // Smoothed GPU frame duration
+    f32 densityScale = 1.f;
+    i32 renderScaleLevel = 0;
+    i32 framesSinceChange = 0;
+};
+
+inline GovernorSettings governorSettings = {};
+inline GovernorState governorState = {};
+
+// CPU time is render side work between frame fence wait and present, GPU time the timestamped frame duration
+void UpdateGovernor(f32 cpuS, f32 gpuS);
+void UpdateGovernorUI();
+f32 GetGovernorDensityScale();
+f32 GetGovernorRenderScale();
+
+};  // namespace Grass
+};  // namespace ty
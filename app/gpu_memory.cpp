@@ -0,0 +1,472 @@
+#include "app/gpu_memory.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/state.hpp"
+#include "app/frame_memory.hpp"
+
+#include <string.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+const char* gpuMemoryTypeNames[] = { "device", "host" };
+const char* gpuResourceTypeNames[] = { "buffer", "texture", "target" };
+const char* gpuAllocationKindNames[] = { "dedicated", "block", "transient" };
+
+GpuMemoryType GetGpuMemoryType(render::BufferType type)
+{
+    return type == render::BUFFER_TYPE_UNIFORM
+            || type == render::BUFFER_TYPE_STAGING
+            || type == render::BUFFER_TYPE_READBACK
+        ? GPU_MEMORY_HOST_VISIBLE
+        : GPU_MEMORY_DEVICE_LOCAL;
+}
+
+// Block size sub-allocated buffers of a type share, 0 when every buffer of that type is dedicated
+u64 GetGpuBlockSize(render::BufferType type)
+{
+    switch(type)
+    {
+        case render::BUFFER_TYPE_STORAGE: return MB(64);
+        case render::BUFFER_TYPE_VERTEX:
+        case render::BUFFER_TYPE_INDEX: return MB(8);
+        case render::BUFFER_TYPE_STAGING: return MB(16);
+        case render::BUFFER_TYPE_UNIFORM:
+        case render::BUFFER_TYPE_INDIRECT: return MB(1);
+        // Readback buffers are mapped whole by callers
+        default: return 0;
+    }
+}
+
+const char* GetGpuBufferTypeName(render::BufferType type)
+{
+    switch(type)
+    {
+        case render::BUFFER_TYPE_VERTEX: return "vertex";
+        case render::BUFFER_TYPE_INDEX: return "index";
+        case render::BUFFER_TYPE_UNIFORM: return "uniform";
+        case render::BUFFER_TYPE_STORAGE: return "storage";
+        case render::BUFFER_TYPE_STAGING: return "staging";
+        case render::BUFFER_TYPE_INDIRECT: return "indirect";
+        case render::BUFFER_TYPE_READBACK: return "readback";
+        default: return "unknown";
+    }
+}
+
+void UpdateGpuMemoryHeaps()
+{
+    // Storage and staging buffers live in same heaps as every other device local and host visible resource
+    render::MemoryHeapBudget device = render::GetMemoryHeapBudget(render::BUFFER_TYPE_STORAGE);
+    render::MemoryHeapBudget host = render::GetMemoryHeapBudget(render::BUFFER_TYPE_STAGING);
+    gpuMemoryHeaps[GPU_MEMORY_DEVICE_LOCAL] = { device.size, device.budget };
+    gpuMemoryHeaps[GPU_MEMORY_HOST_VISIBLE] = { host.size, host.budget };
+}
+
+// Driver side allocation, a block or a dedicated resource
+void CommitGpuMemory(GpuMemoryType memoryType, u64 size, const char* name)
+{
+    u64 previousCommitted = gpuMemoryCommitted[memoryType];
+    gpuMemoryCommitted[memoryType] += size;
+    gpuAllocationCount++;
+    // Only log when crossing budget, not for every allocation after that
+    u64 budget = gpuMemoryHeaps[memoryType].budget;
+    if(previousCommitted <= budget && gpuMemoryCommitted[memoryType] > budget)
+    {
+        LOGF("GPU memory: %s committed %.2f MB over %.2f MB heap budget after %s\n",
+                gpuMemoryTypeNames[memoryType],
+                gpuMemoryCommitted[memoryType] / (1024.0 * 1024.0),
+                budget / (1024.0 * 1024.0),
+                name);
+    }
+    if(gpuAllocationCount == gpuAllocationLimit)
+    {
+        LOGF("GPU memory: %u allocations, reached allocation count limit\n", gpuAllocationCount);
+    }
+}
+
+void ReleaseGpuMemory(GpuMemoryType memoryType, u64 size)
+{
+    ASSERT(gpuMemoryCommitted[memoryType] >= size && gpuAllocationCount > 0);
+    gpuMemoryCommitted[memoryType] -= size;
+    gpuAllocationCount--;
+}
+
+GpuResourceEntry* TrackGpuResource(const char* name, GpuResourceType type, GpuMemoryType memoryType, i32 handle, u64 size)
+{
+    ASSERT(gpuResourceCount < MAX_GPU_RESOURCES);
+    GpuResourceEntry& entry = gpuResources[gpuResourceCount++];
+    entry = {};
+    entry.name = name;
+    entry.type = type;
+    entry.memoryType = memoryType;
+    entry.handle = handle;
+    entry.size = size;
+    gpuMemoryUsage[memoryType] += size;
+    return &entry;
+}
+
+i32 FindGpuResource(GpuResourceType type, i32 handle)
+{
+    for(i32 i = 0; i < gpuResourceCount; i++)
+    {
+        if(gpuResources[i].type == type && gpuResources[i].handle == handle) return i;
+    }
+    return -1;
+}
+
+void RemoveGpuResource(i32 index)
+{
+    GpuResourceEntry& entry = gpuResources[index];
+    gpuMemoryUsage[entry.memoryType] -= entry.size;
+    // Swap remove
+    gpuResources[index] = gpuResources[gpuResourceCount - 1];
+    gpuResourceCount--;
+}
+
+bool IsGpuBuddyNodeFree(GpuBlock* block, u32 order, u64 node)
+{
+    return (block->freeNodes[block->freeNodesWordOffsets[order] + node / 64] >> (node % 64)) & 1;
+}
+
+void SetGpuBuddyNodeFree(GpuBlock* block, u32 order, u64 node, bool free)
+{
+    u64& word = block->freeNodes[block->freeNodesWordOffsets[order] + node / 64];
+    u64 mask = 1ull << (node % 64);
+    ASSERT(((word & mask) != 0) != free);
+    if(free)
+    {
+        word |= mask;
+        block->freeCounts[order]++;
+    }
+    else
+    {
+        word &= ~mask;
+        block->freeCounts[order]--;
+    }
+}
+
+u32 GetGpuBuddyOrder(u64 size)
+{
+    u32 order = 0;
+    while((gpuBuddyMinSize << order) < size) order++;
+    return order;
+}
+
+i32 MakeGpuBlock(render::BufferType type, u64 size)
+{
+    i32 index = -1;
+    for(i32 i = 0; i < MAX_GPU_BLOCKS && index < 0; i++)
+    {
+        if(!gpuBlocks[i].hBuffer.IsValid()) index = i;
+    }
+    if(index < 0) return -1;
+
+    GpuBlock& block = gpuBlocks[index];
+    block = {};
+    block.type = type;
+    block.size = size;
+    block.orderCount = GetGpuBuddyOrder(size) + 1;
+    ASSERT((gpuBuddyMinSize << (block.orderCount - 1)) == size && block.orderCount <= MAX_GPU_BUDDY_ORDERS);
+    // Each order's bits start on a word, so free nodes are found a word at a time
+    u32 wordCount = 0;
+    for(u32 order = 0; order < block.orderCount; order++)
+    {
+        block.freeNodesWordOffsets[order] = wordCount;
+        wordCount += (u32)((((size / gpuBuddyMinSize) >> order) + 63) / 64);
+    }
+    block.freeNodes = (u64*)AppHeapAlloc(wordCount * sizeof(u64));
+    memset(block.freeNodes, 0, wordCount * sizeof(u64));
+    SetGpuBuddyNodeFree(&block, block.orderCount - 1, 0, true);
+
+    block.hBuffer = render::MakeBuffer(type, size, size);
+    CommitGpuMemory(GetGpuMemoryType(type), size, "GPU block");
+    return index;
+}
+
+void DestroyGpuBlock(i32 index)
+{
+    GpuBlock& block = gpuBlocks[index];
+    ASSERT(block.used == 0);
+    render::DestroyBuffer(block.hBuffer);
+    ReleaseGpuMemory(GetGpuMemoryType(block.type), block.size);
+    AppHeapFree(block.freeNodes);
+    block = {};
+}
+
+// Offset of node in block, -1 when no node of that order can be made free
+i64 AllocGpuBuddyNode(GpuBlock* block, u32 order)
+{
+    u32 splitOrder = order;
+    while(splitOrder < block->orderCount && block->freeCounts[splitOrder] == 0) splitOrder++;
+    if(splitOrder >= block->orderCount) return -1;
+
+    u64* words = block->freeNodes + block->freeNodesWordOffsets[splitOrder];
+    u64 node = 0;
+    for(u32 i = 0; ; i++)
+    {
+        if(!words[i]) continue;
+        node = (u64)i * 64 + (u64)__builtin_ctzll(words[i]);
+        break;
+    }
+    SetGpuBuddyNodeFree(block, splitOrder, node, false);
+    // Split down to requested order, keeping left half and freeing right half each time
+    while(splitOrder > order)
+    {
+        splitOrder--;
+        node *= 2;
+        SetGpuBuddyNodeFree(block, splitOrder, node + 1, true);
+    }
+    block->used += gpuBuddyMinSize << order;
+    return (i64)(node * (gpuBuddyMinSize << order));
+}
+
+void FreeGpuBuddyNode(GpuBlock* block, u64 offset, u32 order)
+{
+    block->used -= gpuBuddyMinSize << order;
+    u64 node = offset / (gpuBuddyMinSize << order);
+    // Merge with free buddies, up to whole block
+    while(order + 1 < block->orderCount && IsGpuBuddyNodeFree(block, order, node ^ 1))
+    {
+        SetGpuBuddyNodeFree(block, order, node ^ 1, false);
+        node /= 2;
+        order++;
+    }
+    SetGpuBuddyNodeFree(block, order, node, true);
+}
+
+Handle<render::Buffer> MakeDedicatedGpuBuffer(const char* name, render::BufferType type, u64 size, u64 stride, void* data)
+{
+    Handle<render::Buffer> result = render::MakeBuffer(type, size, stride, data);
+    GpuMemoryType memoryType = GetGpuMemoryType(type);
+    TrackGpuResource(name, GPU_RESOURCE_BUFFER, memoryType, result.value, size);
+    CommitGpuMemory(memoryType, size, name);
+    return result;
+}
+
+// Destroys buffer and returns its memory, whatever it was allocated from
+void ReleaseGpuBuffer(Handle<render::Buffer> hBuffer)
+{
+    i32 index = FindGpuResource(GPU_RESOURCE_BUFFER, hBuffer.value);
+    ASSERT(index >= 0);
+    GpuResourceEntry& entry = gpuResources[index];
+    render::DestroyBuffer(hBuffer);
+    switch(entry.allocation)
+    {
+        case GPU_ALLOCATION_DEDICATED: ReleaseGpuMemory(entry.memoryType, entry.size); break;
+        case GPU_ALLOCATION_BLOCK:
+        {
+            GpuBlock& block = gpuBlocks[entry.block];
+            FreeGpuBuddyNode(&block, entry.offset, entry.order);
+            // Last block of a type is kept empty, so a buffer remade right after doesn't make a new one
+            bool lastOfType = true;
+            for(i32 i = 0; i < MAX_GPU_BLOCKS && lastOfType; i++)
+            {
+                lastOfType = i == entry.block || !gpuBlocks[i].hBuffer.IsValid() || gpuBlocks[i].type != block.type;
+            }
+            if(block.used == 0 && !lastOfType) DestroyGpuBlock(entry.block);
+        } break;
+        // Transient pool's block is reused, not released
+        case GPU_ALLOCATION_TRANSIENT: break;
+        default: ASSERT(0);
+    }
+    RemoveGpuResource(index);
+}
+
+void InitGpuMemory()
+{
+    UpdateGpuMemoryHeaps();
+    LOGF("GPU memory: device heap %.2f MB (budget %.2f MB), host heap %.2f MB (budget %.2f MB)\n",
+            gpuMemoryHeaps[GPU_MEMORY_DEVICE_LOCAL].size / (1024.0 * 1024.0),
+            gpuMemoryHeaps[GPU_MEMORY_DEVICE_LOCAL].budget / (1024.0 * 1024.0),
+            gpuMemoryHeaps[GPU_MEMORY_HOST_VISIBLE].size / (1024.0 * 1024.0),
+            gpuMemoryHeaps[GPU_MEMORY_HOST_VISIBLE].budget / (1024.0 * 1024.0));
+}
+
+void ResetGpuTransientPool(GpuTransientPool* pool)
+{
+    for(i32 i = 0; i < pool->bufferCount; i++)
+    {
+        ReleaseGpuBuffer(pool->buffers[i]);
+    }
+    pool->bufferCount = 0;
+    pool->offset = 0;
+}
+
+void ShutdownGpuMemory()
+{
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        GpuTransientPool& pool = gpuTransientPools[i];
+        ResetGpuTransientPool(&pool);
+        if(pool.hBlock.IsValid())
+        {
+            render::DestroyBuffer(pool.hBlock);
+            ReleaseGpuMemory(GPU_MEMORY_HOST_VISIBLE, gpuTransientBlockSize);
+        }
+        pool = {};
+    }
+    // Buffers still live go with render device, only CPU side of their blocks is freed here
+    for(i32 i = 0; i < MAX_GPU_BLOCKS; i++)
+    {
+        AppHeapFree(gpuBlocks[i].freeNodes);
+        gpuBlocks[i] = {};
+    }
+}
+
+void BeginGpuMemoryFrame(i32 frame)
+{
+    ResetGpuTransientPool(&gpuTransientPools[frame % RENDER_CONCURRENT_FRAMES]);
+    // Budget follows other processes' usage, so it is queried again every frame
+    UpdateGpuMemoryHeaps();
+}
+
+Handle<render::Buffer> MakeGpuBuffer(const char* name, render::BufferType type, u64 size, u64 stride, void* data)
+{
+    // Buffer over half a block would waste most of a block
+    u64 blockSize = GetGpuBlockSize(type);
+    if(size > blockSize / 2) return MakeDedicatedGpuBuffer(name, type, size, stride, data);
+
+    u32 order = GetGpuBuddyOrder(size);
+    i32 blockIndex = -1;
+    i64 offset = -1;
+    for(i32 i = 0; i < MAX_GPU_BLOCKS && offset < 0; i++)
+    {
+        GpuBlock& block = gpuBlocks[i];
+        if(!block.hBuffer.IsValid() || block.type != type) continue;
+        offset = AllocGpuBuddyNode(&block, order);
+        blockIndex = i;
+    }
+    if(offset < 0)
+    {
+        blockIndex = MakeGpuBlock(type, blockSize);
+        // Out of block slots, still better than failing
+        if(blockIndex < 0) return MakeDedicatedGpuBuffer(name, type, size, stride, data);
+        offset = AllocGpuBuddyNode(&gpuBlocks[blockIndex], order);
+        ASSERT(offset >= 0);
+    }
+
+    Handle<render::Buffer> result = render::MakeSubBuffer(gpuBlocks[blockIndex].hBuffer, (u64)offset, size, stride);
+    if(data) render::CopyMemoryToBuffer(result, 0, size, data);
+    GpuResourceEntry* entry = TrackGpuResource(name, GPU_RESOURCE_BUFFER, GetGpuMemoryType(type), result.value, size);
+    entry->allocation = GPU_ALLOCATION_BLOCK;
+    entry->block = blockIndex;
+    entry->offset = (u64)offset;
+    entry->order = order;
+    return result;
+}
+
+Handle<render::Buffer> MakeGpuTransientBuffer(const char* name, u64 size, void* data)
+{
+    GpuTransientPool& pool = gpuTransientPools[currentFrame % RENDER_CONCURRENT_FRAMES];
+    ASSERT(pool.bufferCount < MAX_GPU_TRANSIENT_BUFFERS);
+    if(!pool.hBlock.IsValid())
+    {
+        pool.hBlock = render::MakeBuffer(render::BUFFER_TYPE_STAGING, gpuTransientBlockSize, gpuTransientBlockSize);
+        CommitGpuMemory(GPU_MEMORY_HOST_VISIBLE, gpuTransientBlockSize, "GPU transient block");
+    }
+
+    Handle<render::Buffer> result = {};
+    u64 start = (pool.offset + gpuBuddyMinSize - 1) & ~(gpuBuddyMinSize - 1);
+    if(start + size <= gpuTransientBlockSize)
+    {
+        result = render::MakeSubBuffer(pool.hBlock, start, size, size);
+        if(data) render::CopyMemoryToBuffer(result, 0, size, data);
+        pool.offset = start + size;
+        GpuResourceEntry* entry = TrackGpuResource(name, GPU_RESOURCE_BUFFER, GPU_MEMORY_HOST_VISIBLE, result.value, size);
+        entry->allocation = GPU_ALLOCATION_TRANSIENT;
+        entry->offset = start;
+        entry->transient = true;
+    }
+    else
+    {
+        // Doesn't fit what is left of block this frame, released with pool all the same
+        result = MakeDedicatedGpuBuffer(name, render::BUFFER_TYPE_STAGING, size, size, data);
+        gpuResources[gpuResourceCount - 1].transient = true;
+    }
+    pool.buffers[pool.bufferCount++] = result;
+    return result;
+}
+
+void DestroyGpuBuffer(Handle<render::Buffer> hBuffer)
+{
+    i32 index = FindGpuResource(GPU_RESOURCE_BUFFER, hBuffer.value);
+    ASSERT(index >= 0 && !gpuResources[index].transient);
+    ReleaseGpuBuffer(hBuffer);
+}
+
+void TrackGpuTexture(const char* name, Handle<render::Texture> hTexture, u64 size)
+{
+    TrackGpuResource(name, GPU_RESOURCE_TEXTURE, GPU_MEMORY_DEVICE_LOCAL, hTexture.value, size);
+    CommitGpuMemory(GPU_MEMORY_DEVICE_LOCAL, size, name);
+}
+
+void TrackGpuRenderTarget(const char* name, Handle<render::RenderTarget> hRenderTarget, u64 size)
+{
+    TrackGpuResource(name, GPU_RESOURCE_RENDER_TARGET, GPU_MEMORY_DEVICE_LOCAL, hRenderTarget.value, size);
+    CommitGpuMemory(GPU_MEMORY_DEVICE_LOCAL, size, name);
+}
+
+void UntrackGpuResource(GpuResourceType type, i32 handle)
+{
+    // Buffers own their memory here, they are released through DestroyGpuBuffer
+    ASSERT(type != GPU_RESOURCE_BUFFER);
+    i32 index = FindGpuResource(type, handle);
+    if(index < 0) return;
+    ReleaseGpuMemory(gpuResources[index].memoryType, gpuResources[index].size);
+    RemoveGpuResource(index);
+}
+
+u64 GetTextureMemorySize(u32 width, u32 height, u32 mipLevels, u32 bytesPerPixel)
+{
+    u64 result = 0;
+    for(u32 i = 0; i < mipLevels; i++)
+    {
+        result += (u64)MAX(width >> i, 1u) * MAX(height >> i, 1u) * bytesPerPixel;
+    }
+    return result;
+}
+
+void UpdateGpuMemoryUI()
+{
+    for(i32 i = 0; i < GPU_MEMORY_TYPE_COUNT; i++)
+    {
+        egui::Text("GPU %-6s %8.2f used, %8.2f committed / %8.2f MB budget, %8.2f MB heap", gpuMemoryTypeNames[i],
+                gpuMemoryUsage[i] / (1024.0 * 1024.0),
+                gpuMemoryCommitted[i] / (1024.0 * 1024.0),
+                gpuMemoryHeaps[i].budget / (1024.0 * 1024.0),
+                gpuMemoryHeaps[i].size / (1024.0 * 1024.0));
+    }
+    egui::Text("GPU allocations %u / %u, %d resources", gpuAllocationCount, gpuAllocationLimit, gpuResourceCount);
+    for(i32 i = 0; i < MAX_GPU_BLOCKS; i++)
+    {
+        GpuBlock& block = gpuBlocks[i];
+        if(!block.hBuffer.IsValid()) continue;
+        egui::Text("  Block %-8s %8.2f / %8.2f MB", GetGpuBufferTypeName(block.type),
+                block.used / (1024.0 * 1024.0),
+                block.size / (1024.0 * 1024.0));
+    }
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        GpuTransientPool& pool = gpuTransientPools[i];
+        if(!pool.hBlock.IsValid()) continue;
+        egui::Text("  Transient frame %d %8.2f / %8.2f MB, %d buffers", i,
+                pool.offset / (1024.0 * 1024.0),
+                gpuTransientBlockSize / (1024.0 * 1024.0),
+                pool.bufferCount);
+    }
+    for(i32 i = 0; i < gpuResourceCount; i++)
+    {
+        GpuResourceEntry& entry = gpuResources[i];
+        egui::Text("  %-24s %-7s %-6s %-9s %10.2f KB", entry.name,
+                gpuResourceTypeNames[entry.type],
+                gpuMemoryTypeNames[entry.memoryType],
+                gpuAllocationKindNames[entry.allocation],
+                entry.size / 1024.0);
+    }
+}
+
+};  // namespace Grass
+};  // namespace ty
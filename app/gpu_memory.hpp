@@ -0,0 +1,121 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// App side GPU memory management and accounting.
+// Buffers don't get a driver allocation each. Long lived buffers are carved out of a few large
+// blocks per buffer type by a buddy allocator, transient upload buffers out of a linear block per
+// frame in flight that is reset once that frame retires. Requests bigger than a block, and readback
+// buffers that are mapped whole, get a dedicated buffer. Textures and render targets are made by
+// the engine and only registered here.
+// Every resource is listed with its size, and committed memory (blocks and dedicated resources)
+// is checked against the budget the driver reports for the heap backing it.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum GpuMemoryType
+{
+    GPU_MEMORY_DEVICE_LOCAL,
+    GPU_MEMORY_HOST_VISIBLE,    // Uniform and staging buffers written from CPU, readback buffers read by it
+    GPU_MEMORY_TYPE_COUNT,
+};
+
+enum GpuResourceType
+{
+    GPU_RESOURCE_BUFFER,
+    GPU_RESOURCE_TEXTURE,
+    GPU_RESOURCE_RENDER_TARGET,
+};
+
+enum GpuAllocationKind
+{
+    GPU_ALLOCATION_DEDICATED,   // Own driver allocation, every texture and render target
+    GPU_ALLOCATION_BLOCK,       // Buddy node in a block
+    GPU_ALLOCATION_TRANSIENT,   // Range of a frame's transient block
+};
+
+struct GpuResourceEntry
+{
+    const char* name = NULL;
+    GpuResourceType type = GPU_RESOURCE_BUFFER;
+    GpuMemoryType memoryType = GPU_MEMORY_DEVICE_LOCAL;
+    i32 handle = -1;
+    u64 size = 0;
+
+    GpuAllocationKind allocation = GPU_ALLOCATION_DEDICATED;
+    // Sub-allocated buffers only
+    i32 block = -1;
+    u64 offset = 0;
+    u32 order = 0;              // Buddy node order, node size is gpuBuddyMinSize << order
+    bool transient = false;     // Released by frame's transient pool, not destroyed by caller
+};
+
+// Spec minimum for maxMemoryAllocationCount. Blocks and dedicated resources count, sub-allocations don't.
+const u32 gpuAllocationLimit = 4096;
+
+// Table holds every resource up to allocation limit, so limit warning is reached before table runs out
+#define MAX_GPU_RESOURCES 4096
+static_assert(MAX_GPU_RESOURCES >= gpuAllocationLimit);
+
+// Smallest buddy node, covers offset alignment of every buffer type. Nodes are aligned to their size.
+const u64 gpuBuddyMinSize = 256;
+const u64 gpuTransientBlockSize = MB(32);
+#define MAX_GPU_BLOCKS 64
+#define MAX_GPU_BUDDY_ORDERS 24
+#define MAX_GPU_TRANSIENT_BUFFERS 64
+
+struct GpuBlock
+{
+    Handle<render::Buffer> hBuffer;
+    render::BufferType type = render::BUFFER_TYPE_STORAGE;
+    u64 size = 0;
+    u64 used = 0;
+    u32 orderCount = 0;                             // Top order is whole block
+    u64* freeNodes = NULL;                          // Bit per node and order, set when node is free
+    u32 freeNodesWordOffsets[MAX_GPU_BUDDY_ORDERS] = {};
+    u32 freeCounts[MAX_GPU_BUDDY_ORDERS] = {};
+};
+
+struct GpuTransientPool
+{
+    Handle<render::Buffer> hBlock;
+    u64 offset = 0;
+    Handle<render::Buffer> buffers[MAX_GPU_TRANSIENT_BUFFERS];  // Released when pool is reset
+    i32 bufferCount = 0;
+};
+
+struct GpuMemoryHeap
+{
+    u64 size = 0;
+    u64 budget = 0;     // What the driver currently lets this process use, follows other processes' usage
+};
+
+inline GpuResourceEntry gpuResources[MAX_GPU_RESOURCES];
+inline i32 gpuResourceCount = 0;
+inline GpuBlock gpuBlocks[MAX_GPU_BLOCKS];
+inline GpuTransientPool gpuTransientPools[RENDER_CONCURRENT_FRAMES];
+inline u32 gpuAllocationCount = 0;
+inline u64 gpuMemoryUsage[GPU_MEMORY_TYPE_COUNT] = {};          // Resource sizes
+inline u64 gpuMemoryCommitted[GPU_MEMORY_TYPE_COUNT] = {};      // Blocks and dedicated resources
+inline GpuMemoryHeap gpuMemoryHeaps[GPU_MEMORY_TYPE_COUNT] = {};
+
+void InitGpuMemory();
+void ShutdownGpuMemory();
+// Call after BeginFrame, once the frame's previous use has retired. Releases its transient buffers.
+void BeginGpuMemoryFrame(i32 frame);
+Handle<render::Buffer> MakeGpuBuffer(const char* name, render::BufferType type, u64 size, u64 stride, void* data = NULL);
+// Staging buffer valid until current frame retires, released by BeginGpuMemoryFrame, never destroyed by caller
+Handle<render::Buffer> MakeGpuTransientBuffer(const char* name, u64 size, void* data = NULL);
+// Immediately, callers that may still have it in flight go through DeferDestroyBuffer
+void DestroyGpuBuffer(Handle<render::Buffer> hBuffer);
+void TrackGpuTexture(const char* name, Handle<render::Texture> hTexture, u64 size);
+void TrackGpuRenderTarget(const char* name, Handle<render::RenderTarget> hRenderTarget, u64 size);
+void UntrackGpuResource(GpuResourceType type, i32 handle);
+u64 GetTextureMemorySize(u32 width, u32 height, u32 mipLevels, u32 bytesPerPixel);
+void UpdateGpuMemoryUI();
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,124 @@
+#include "app/gpu_stats.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/render/egui.hpp"
+#include "app/state.hpp"
+#include "app/grass.hpp"
+
+namespace ty
+{
+namespace Grass
+{
+
+const char* gpuStatsScopeNames[] = { "Terrain", "Grass cull", "Grass draw", "Grass splat", "UI" };
+static_assert(ARR_LEN(gpuStatsScopeNames) == GPU_STATS_SCOPE_COUNT);
+
+void InitGpuStats()
+{
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        gpuStatsFrames[i].hQueryPool = render::MakeQueryPool(render::QUERY_TYPE_PIPELINE_STATISTICS, GPU_STATS_SCOPE_COUNT);
+        gpuStatsFrames[i].hTimestampPool = render::MakeQueryPool(render::QUERY_TYPE_TIMESTAMP, 2);
+        gpuStatsFrames[i].scopeMask = 0;
+        gpuStatsFrames[i].timestamped = false;
+    }
+}
+
+void ShutdownGpuStats()
+{
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        render::DestroyQueryPool(gpuStatsFrames[i].hQueryPool);
+        render::DestroyQueryPool(gpuStatsFrames[i].hTimestampPool);
+        gpuStatsFrames[i] = {};
+    }
+}
+
+void BeginGpuStatsFrame(Handle<render::CommandBuffer> hCmd, i32 frame)
+{
+    GpuStatsFrame& statsFrame = gpuStatsFrames[frame % RENDER_CONCURRENT_FRAMES];
+    if(statsFrame.scopeMask)
+    {
+        GpuPipelineStats results[GPU_STATS_SCOPE_COUNT] = {};
+        if(render::GetQueryPoolResults(statsFrame.hQueryPool, 0, GPU_STATS_SCOPE_COUNT, sizeof(results), results))
+        {
+            for(i32 i = 0; i < GPU_STATS_SCOPE_COUNT; i++)
+            {
+                if(statsFrame.scopeMask & (1 << i)) gpuStats[i] = results[i];
+            }
+            gpuStatsMask = statsFrame.scopeMask;
+        }
+    }
+
+    if(statsFrame.timestamped)
+    {
+        u64 timestamps[2] = {};
+        if(render::GetQueryPoolResults(statsFrame.hTimestampPool, 0, 2, sizeof(timestamps), timestamps))
+        {
+            // Period is nanoseconds per tick
+            gpuFrameMS = (f32)((f64)(timestamps[1] - timestamps[0]) * render::GetTimestampPeriod() / 1e6);
+        }
+    }
+
+    // Queries must be reset before their first use every frame
+    render::CmdResetQueryPool(hCmd, statsFrame.hTimestampPool, 0, 2);
+    render::CmdWriteTimestamp(hCmd, statsFrame.hTimestampPool, 0, render::PIPELINE_STAGE_TOP);
+    statsFrame.timestamped = false;
+    statsFrame.scopeMask = 0;
+    if(!gpuStatsEnabled) return;
+    render::CmdResetQueryPool(hCmd, statsFrame.hQueryPool, 0, GPU_STATS_SCOPE_COUNT);
+}
+
+void EndGpuStatsFrame(Handle<render::CommandBuffer> hCmd, i32 frame)
+{
+    GpuStatsFrame& statsFrame = gpuStatsFrames[frame % RENDER_CONCURRENT_FRAMES];
+    render::CmdWriteTimestamp(hCmd, statsFrame.hTimestampPool, 1, render::PIPELINE_STAGE_BOTTOM);
+    statsFrame.timestamped = true;
+}
+
+void BeginGpuStatsScope(Handle<render::CommandBuffer> hCmd, GpuStatsScope scope)
+{
+    if(!gpuStatsEnabled) return;
+    // Pipeline statistics queries of the same pool can't be nested
+    ASSERT(gpuStatsActiveScope == -1);
+    GpuStatsFrame& statsFrame = gpuStatsFrames[currentFrame % RENDER_CONCURRENT_FRAMES];
+    ASSERT(!(statsFrame.scopeMask & (1 << scope)));
+    render::CmdBeginQuery(hCmd, statsFrame.hQueryPool, scope);
+    statsFrame.scopeMask |= 1 << scope;
+    gpuStatsActiveScope = scope;
+}
+
+void EndGpuStatsScope(Handle<render::CommandBuffer> hCmd, GpuStatsScope scope)
+{
+    if(!gpuStatsEnabled) return;
+    ASSERT(gpuStatsActiveScope == scope);
+    GpuStatsFrame& statsFrame = gpuStatsFrames[currentFrame % RENDER_CONCURRENT_FRAMES];
+    render::CmdEndQuery(hCmd, statsFrame.hQueryPool, scope);
+    gpuStatsActiveScope = -1;
+}
+
+void UpdateGpuStatsUI()
+{
+    egui::Text("GPU frame: %.2f ms", gpuFrameMS);
+    if(!gpuStatsEnabled) return;
+    // Fragments per target pixel, average overdraw of the scope's color output
+    f64 targetPixels = (f64)(u32)(appWidth * renderScale) * (u32)(appHeight * renderScale);
+    egui::Text("%-12s %12s %12s %12s %12s %8s", "GPU stats", "vertices", "primitives", "fragments", "compute", "overdraw");
+    for(i32 i = 0; i < GPU_STATS_SCOPE_COUNT; i++)
+    {
+        if(!(gpuStatsMask & (1 << i))) continue;
+        GpuPipelineStats& stats = gpuStats[i];
+        // Reduced resolution grass draws into a smaller target
+        f64 scopePixels = i == GPU_STATS_GRASS_DRAW && IsGrassLowRes()
+            ? (f64)grassLowResWidth * grassLowResHeight
+            : targetPixels;
+        egui::Text("%-12s %12llu %12llu %12llu %12llu %8.2f", gpuStatsScopeNames[i],
+                stats.vertexInvocations,
+                stats.clippingPrimitives,
+                stats.fragmentInvocations,
+                stats.computeInvocations,
+                stats.fragmentInvocations / scopePixels);
+    }
+}
+
+};  // namespace Grass
+};  // namespace ty
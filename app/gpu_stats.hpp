@@ -0,0 +1,62 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// GPU pipeline statistics per frame scope. Each scope wraps whole frame graph passes with a
+// pipeline statistics query, outside render passes. One query pool per frame in flight, read back
+// without waiting once that frame's fence has been waited on, so results lag RENDER_CONCURRENT_FRAMES frames.
+// Frame GPU duration comes from a timestamp pair around the whole frame command buffer, read back the
+// same way. It's recorded even with stats off, governor decides from it.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum GpuStatsScope
+{
+    GPU_STATS_TERRAIN,
+    GPU_STATS_GRASS_CULL,
+    GPU_STATS_GRASS_DRAW,
+    GPU_STATS_GRASS_SPLAT_RESOLVE,
+    GPU_STATS_UI,
+    GPU_STATS_SCOPE_COUNT,
+};
+
+// Matches query result layout, counters in pipeline statistics pool creation order
+struct GpuPipelineStats
+{
+    u64 vertexInvocations = 0;
+    u64 clippingPrimitives = 0;     // Primitives output by clipping, i.e. reaching rasterization
+    u64 fragmentInvocations = 0;
+    u64 computeInvocations = 0;
+};
+
+struct GpuStatsFrame
+{
+    Handle<render::QueryPool> hQueryPool;
+    Handle<render::QueryPool> hTimestampPool;   // Frame begin and end
+    u32 scopeMask = 0;              // Scopes begun in this frame, others have no results
+    bool timestamped = false;       // Both timestamps written in this frame
+};
+
+inline bool gpuStatsEnabled = true;
+inline GpuStatsFrame gpuStatsFrames[RENDER_CONCURRENT_FRAMES];
+inline GpuPipelineStats gpuStats[GPU_STATS_SCOPE_COUNT];   // Latest read back results
+inline u32 gpuStatsMask = 0;                                // Scopes with valid results in gpuStats
+inline i32 gpuStatsActiveScope = -1;
+inline f32 gpuFrameMS = 0;                                  // Latest read back frame duration on GPU
+
+void InitGpuStats();
+void ShutdownGpuStats();
+// Reads back results of the frame previously recorded in this slot, then resets its queries.
+// Call after frame fence wait, outside render passes.
+void BeginGpuStatsFrame(Handle<render::CommandBuffer> hCmd, i32 frame);
+// Call right before ending frame command buffer
+void EndGpuStatsFrame(Handle<render::CommandBuffer> hCmd, i32 frame);
+void BeginGpuStatsScope(Handle<render::CommandBuffer> hCmd, GpuStatsScope scope);
+void EndGpuStatsScope(Handle<render::CommandBuffer> hCmd, GpuStatsScope scope);
+void UpdateGpuStatsUI();
+
+};  // namespace Grass
+};  // namespace ty
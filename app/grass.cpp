@@ -11,6 +11,14 @@
 #include "app/state.hpp"
 #include "app/render_utils.hpp"
 #include "app/terrain.hpp"
+#include "app/grass_bake.hpp"
+#include "app/governor.hpp"
+#include "app/frame_memory.hpp"
+#include "app/gpu_memory.hpp"
+#include "app/trace.hpp"
+#include "app/map_stream.hpp"
+
+#include <string.h>
 
 namespace ty
 {
@@ -23,42 +31,201 @@ void InitGrass(Handle<render::RenderTarget> hRenderTarget)
 
     // Loading assets
     hAssetCsGrassPositions = asset::LoadShader(file::MakePath(IStr("app/shaders/grass_positions.comp")));
-    hAssetVsGrass = asset::LoadShader(file::MakePath(IStr("app/shaders/grass.vert")));
-    hAssetPsGrass = asset::LoadShader(file::MakePath(IStr("app/shaders/grass.frag")));
-    hAssetModelGrass = asset::LoadModelOBJ(file::MakePath(IStr("resources/models/grass/grass.obj")));
+    hAssetCsGrassDrawArgsReset = asset::LoadShader(file::MakePath(IStr("app/shaders/grass_draw_args_reset.comp")));
+    hAssetVsGrassSplatResolve = asset::LoadShader(file::MakePath(IStr("app/shaders/grass_splat_resolve.vert")));
+    hAssetPsGrassSplatResolve = asset::LoadShader(file::MakePath(IStr("app/shaders/grass_splat_resolve.frag")));
+    hAssetPsGrassUpsample = asset::LoadShader(file::MakePath(IStr("app/shaders/grass_upsample.frag")));
+    for(u32 i = 0; i < grassSpeciesCount; i++)
+    {
+        // Species sharing a model share its asset, missing models fall back to the first species' one.
+        // Probed at the path the load resolves, not relative to working directory.
+        const char* modelPath = grassSpeciesDescs[i].modelPath;
+        if(!file::PathExists(file::MakePath(IStr(modelPath))))
+        {
+            LOGF("Grass species %s model not found: %s, using %s\n", grassSpeciesDescs[i].name, modelPath, grassSpeciesDescs[0].modelPath);
+            modelPath = grassSpeciesDescs[0].modelPath;
+        }
+        for(u32 j = 0; j < i; j++)
+        {
+            if(strcmp(modelPath, grassSpeciesDescs[j].modelPath) == 0) hAssetModelsGrassSpecies[i] = hAssetModelsGrassSpecies[j];
+        }
+        if(!hAssetModelsGrassSpecies[i].IsValid())
+        {
+            hAssetModelsGrassSpecies[i] = asset::LoadModelOBJ(file::MakePath(IStr(modelPath)));
+        }
+    }
     hAssetWindNoise = asset::LoadImageFile(file::MakePath(IStr("resources/textures/wind_noise.png")));
+    hAssetGrassDensity = asset::LoadImageFile(file::MakePath(IStr("resources/textures/grass_density.png")));
 
     // Initializing graphics resources
     hCsGrassPositions = MakeShaderFromAsset(hAssetCsGrassPositions, render::SHADER_TYPE_COMPUTE);
-    hVsGrass = MakeShaderFromAsset(hAssetVsGrass, render::SHADER_TYPE_VERTEX);
-    hPsGrass = MakeShaderFromAsset(hAssetPsGrass, render::SHADER_TYPE_PIXEL);
-    hVbGrass = MakeVbFromAsset(hAssetModelGrass);
-    hIbGrass = MakeIbFromAsset(hAssetModelGrass);
+    hCsGrassDrawArgsReset = MakeShaderFromAsset(hAssetCsGrassDrawArgsReset, render::SHADER_TYPE_COMPUTE);
+    hVsGrassSplatResolve = MakeShaderFromAsset(hAssetVsGrassSplatResolve, render::SHADER_TYPE_VERTEX);
+    hPsGrassSplatResolve = MakeShaderFromAsset(hAssetPsGrassSplatResolve, render::SHADER_TYPE_PIXEL);
+    hPsGrassUpsample = MakeShaderFromAsset(hAssetPsGrassUpsample, render::SHADER_TYPE_PIXEL);
+    // Blade meshes are instanced up to a million times per frame. grass.vert only reads positions,
+    // so normals and uvs are stripped and positions fetched as 8 byte quantized vertices.
+    // Species meshes are appended into one vertex and index buffer, draw args address their ranges.
+    // Species sharing a model share its range, each model is quantized and appended once.
+    QuantizedMesh speciesMeshes[grassSpeciesCount];
+    u32 meshOwners[grassSpeciesCount];     // First species using same model, owns its QuantizedMesh
+    u32 vertexStride = 0;
+    u32 vertexCount = 0;
+    u32 indexCount = 0;
+    f32 bladeHeight = 0;
+    grassSpeciesUniforms = {};
+    for(u32 i = 0; i < grassSpeciesCount; i++)
+    {
+        meshOwners[i] = i;
+        for(u32 j = 0; j < i; j++)
+        {
+            if(hAssetModelsGrassSpecies[j].value == hAssetModelsGrassSpecies[i].value)
+            {
+                meshOwners[i] = j;
+                break;
+            }
+        }
+        QuantizedMesh& mesh = speciesMeshes[meshOwners[i]];
+        if(meshOwners[i] == i)
+        {
+            mesh = MakeQuantizedMesh(hAssetModelsGrassSpecies[i], MESH_ATTRIBUTE_POSITION);
+            ASSERT(i == 0 || mesh.vertexStride == vertexStride);
+            vertexStride = mesh.vertexStride;
+            grassSpeciesMeshes[i].firstIndex = indexCount;
+            grassSpeciesMeshes[i].indexCount = mesh.indexCount;
+            grassSpeciesMeshes[i].vertexOffset = (i32)vertexCount;
+            vertexCount += mesh.vertexCount;
+            indexCount += mesh.indexCount;
+        }
+        else
+        {
+            grassSpeciesMeshes[i] = grassSpeciesMeshes[meshOwners[i]];
+        }
+
+        // Height scale is folded into dequantization
+        f32 heightScale = grassSpeciesDescs[i].heightScale;
+        GrassSpeciesBlock& species = grassSpeciesUniforms.species[i];
+        species.positionMin = mesh.positionMin;
+        species.positionMin.y *= heightScale;
+        species.positionExtent = mesh.positionExtent;
+        species.positionExtent.y *= heightScale;
+        species.height = species.positionMin.y + species.positionExtent.y;
+        species.tipColor = grassSpeciesDescs[i].tipColor;
+        bladeHeight = MAX(bladeHeight, species.height);
+    }
+    u8* vertices = (u8*)AppHeapAlloc((u64)vertexCount * vertexStride);
+    u32* indices = (u32*)AppHeapAlloc(indexCount * sizeof(u32));
+    for(u32 i = 0; i < grassSpeciesCount; i++)
+    {
+        if(meshOwners[i] != i) continue;
+        QuantizedMesh& mesh = speciesMeshes[i];
+        memcpy(vertices + (u64)grassSpeciesMeshes[i].vertexOffset * vertexStride, mesh.vertices, (u64)mesh.vertexCount * vertexStride);
+        memcpy(indices + grassSpeciesMeshes[i].firstIndex, mesh.indices, mesh.indexCount * sizeof(u32));
+        DestroyQuantizedMesh(&mesh);
+    }
+    hVbGrass = MakeGpuBuffer("Grass vertices", render::BUFFER_TYPE_VERTEX,
+            (u64)vertexCount * vertexStride,
+            vertexStride,
+            vertices);
+    hIbGrass = MakeGpuBuffer("Grass indices", render::BUFFER_TYPE_INDEX,
+            indexCount * sizeof(u32),
+            sizeof(u32),
+            indices);
+    AppHeapFree(vertices);
+    AppHeapFree(indices);
+    hUbGrassSpecies = MakeGpuBuffer("Grass species", render::BUFFER_TYPE_UNIFORM,
+            sizeof(GrassSpeciesUniformBlock), sizeof(GrassSpeciesUniformBlock), &grassSpeciesUniforms);
     hTexWindNoise = MakeTextureFromAsset(hAssetWindNoise,
-            ENUM_FLAGS(render::ImageUsageFlags, render::IMAGE_USAGE_SAMPLED | render::IMAGE_USAGE_TRANSFER_DST));
+            ENUM_FLAGS(render::ImageUsageFlags, render::IMAGE_USAGE_SAMPLED | render::IMAGE_USAGE_TRANSFER_DST),
+            "Wind noise");
+    // Mask is a probability, not a color, so it's read as authored without sRGB decode
+    hTexGrassDensity = MakeTextureFromAsset(hAssetGrassDensity,
+            ENUM_FLAGS(render::ImageUsageFlags, render::IMAGE_USAGE_SAMPLED | render::IMAGE_USAGE_TRANSFER_DST),
+            "Grass density", render::FORMAT_RGBA8_UNORM);
+    // Placement reads density from the streamed tiled map, texture above remains for debug view and CPU bakes
+    if(!OpenStreamedMap(&streamedGrassDensity, "Grass density", GRASS_DENSITY_MAP_PATH))
+    {
+        // First run converts authored image
+        BuildGrassDensityMapFile(hAssetGrassDensity);
+        bool opened = OpenStreamedMap(&streamedGrassDensity, "Grass density", GRASS_DENSITY_MAP_PATH);
+        ASSERT(opened);
+    }
+    if(!OpenStreamedMap(&streamedGrassSpecies, "Grass species", GRASS_SPECIES_MAP_PATH))
+    {
+        BuildGrassSpeciesMapFile();
+        bool opened = OpenStreamedMap(&streamedGrassSpecies, "Grass species", GRASS_SPECIES_MAP_PATH);
+        ASSERT(opened);
+    }
 
-    hSbGrassInstanceData = render::MakeBuffer(render::BUFFER_TYPE_STORAGE, 
-            sizeof(GrassInstanceDataBlock) * maxGrassInstances, 
-            sizeof(GrassInstanceDataBlock) * maxGrassInstances);
+    // Instance counts are filled by cull compute after discarding blades,
+    // so only species mesh ranges are known up front. First instances are set by reset compute.
+    GrassDrawArgsBlock grassDrawArgs[maxGrassViews * grassSpeciesCount] = {};
+    for(u32 i = 0; i < ARR_LEN(grassDrawArgs); i++)
+    {
+        GrassSpeciesMesh& mesh = grassSpeciesMeshes[i % grassSpeciesCount];
+        grassDrawArgs[i].indexCount = mesh.indexCount;
+        grassDrawArgs[i].firstIndex = mesh.firstIndex;
+        grassDrawArgs[i].vertexOffset = mesh.vertexOffset;
+    }
+    hSbGrassDrawArgs = MakeGpuBuffer("Grass draw args", render::BUFFER_TYPE_INDIRECT,
+            sizeof(grassDrawArgs),
+            sizeof(GrassDrawArgsBlock),
+            grassDrawArgs);
 
     grassConstants = {};
     grassUniforms = {};
-    hUbGrass = render::MakeBuffer(render::BUFFER_TYPE_UNIFORM, sizeof(GrassUniformBlock), sizeof(GrassUniformBlock), &grassUniforms);
+    grassUniforms.terrainSize = terrainConstants.terrainSize;
+    grassUniforms.bladeHeight = bladeHeight;
+    grassUniforms.bladesPerSide = GetGrassBladesPerSide();
+    u32 grassTilesPerSide = GetGrassTilesPerSide();
+    grassInstanceCapacity = MAX(grassMinInstanceCapacity,
+            (u32)(grassTilesPerSide * grassTilesPerSide * grassCapacityGrowFactor) * grassTileBladeCapacity);
+    grassUniforms.instanceCapacity = grassInstanceCapacity;
+    hSbGrassInstanceData = MakeGpuBuffer("Grass instances", render::BUFFER_TYPE_STORAGE,
+            sizeof(GrassInstanceDataBlock) * grassInstanceCapacity, 
+            sizeof(GrassInstanceDataBlock) * grassInstanceCapacity);
+    hSbGrassVisible = MakeGpuBuffer("Grass visible indices", render::BUFFER_TYPE_STORAGE,
+            sizeof(u32) * grassInstanceCapacity * maxGrassViews,
+            sizeof(u32) * grassInstanceCapacity * maxGrassViews);
+    MakeGrassTileBuffers();
+
+    hUbGrass = MakeGpuBuffer("Grass uniforms", render::BUFFER_TYPE_UNIFORM, sizeof(GrassUniformBlock), sizeof(GrassUniformBlock), &grassUniforms);
+    grassViewsUniforms = {};
+    hUbGrassViews = MakeGpuBuffer("Grass views", render::BUFFER_TYPE_UNIFORM, sizeof(GrassViewsBlock), sizeof(GrassViewsBlock), &grassViewsUniforms);
 
     render::VertexAttribute vertexAttributesGrass[] =
     {
-        render::VERTEX_ATTR_V3F,
-        render::VERTEX_ATTR_V3F,
-        render::VERTEX_ATTR_V2F,
+        render::VERTEX_ATTR_RGBA16_UNORM,     // Quantized position, see MakeQuantizedMesh
     };
     hVertexLayoutGrassRender = render::MakeVertexLayout(ARR_LEN(vertexAttributesGrass), vertexAttributesGrass);
 
-    render::RenderPassDesc renderPassGrassDesc = {};
-    renderPassGrassDesc.loadOp = render::LOAD_OP_LOAD;
-    renderPassGrassDesc.storeOp = render::STORE_OP_STORE;
-    renderPassGrassDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
-    renderPassGrassDesc.finalLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
-    hRenderPassGrassRender = render::MakeRenderPass(renderPassGrassDesc, hRenderTarget);
+    SetGrassRenderTarget(hRenderTarget);
+
+    render::ResourceSetLayout::Entry grassDrawArgsResetResourceLayoutEntries[] =
+    {
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+    };
+    hResourceLayoutGrassDrawArgsReset = render::MakeResourceSetLayout(ARR_LEN(grassDrawArgsResetResourceLayoutEntries),
+            grassDrawArgsResetResourceLayoutEntries);
 
     render::ResourceSetLayout::Entry grassPositionsResourceLayoutEntries[] =
     {
@@ -70,28 +237,99 @@ void InitGrass(Handle<render::RenderTarget> hRenderTarget)
             .resourceType = render::RESOURCE_UNIFORM_BUFFER,
             .shaderStages = render::SHADER_TYPE_COMPUTE
         },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
     };
     hResourceLayoutGrassPositions = render::MakeResourceSetLayout(ARR_LEN(grassPositionsResourceLayoutEntries), 
             grassPositionsResourceLayoutEntries);
-    render::ResourceSet::Entry grassPositionsResourceSetEntries[] =
+    render::ResourceSetLayout::Entry grassCullResourceLayoutEntries[] =
     {
         {
-            .binding = 0,
             .resourceType = render::RESOURCE_STORAGE_BUFFER,
-            .hBuffer = hSbGrassInstanceData
+            .shaderStages = render::SHADER_TYPE_COMPUTE
         },
         {
-            .binding = 1,
             .resourceType = render::RESOURCE_UNIFORM_BUFFER,
-            .hBuffer = hUbGrass
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
+        },
+        // Splat buffer, splat variant only
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_COMPUTE
         },
     };
-    hResourceSetGrassPositions = render::MakeResourceSet(hResourceLayoutGrassPositions, 
-            ARR_LEN(grassPositionsResourceSetEntries), 
-            grassPositionsResourceSetEntries);
-
+    hResourceLayoutGrassCull = render::MakeResourceSetLayout(ARR_LEN(grassCullResourceLayoutEntries) - 1,
+            grassCullResourceLayoutEntries);
+    hResourceLayoutGrassCullSplat = render::MakeResourceSetLayout(ARR_LEN(grassCullResourceLayoutEntries),
+            grassCullResourceLayoutEntries);
     render::ResourceSetLayout::Entry grassRenderResourceLayoutEntries[] =
     {
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_VERTEX
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_VERTEX
+        },
         {
             .resourceType = render::RESOURCE_STORAGE_BUFFER,
             .shaderStages = render::SHADER_TYPE_VERTEX
@@ -104,113 +342,900 @@ void InitGrass(Handle<render::RenderTarget> hRenderTarget)
             .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
             .shaderStages = render::SHADER_TYPE_VERTEX
         },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_VERTEX
+        },
     };
     hResourceLayoutGrassRender = render::MakeResourceSetLayout(ARR_LEN(grassRenderResourceLayoutEntries), 
             grassRenderResourceLayoutEntries);
-    render::ResourceSet::Entry grassRenderResourceSetEntries[] =
+    MakeGrassResourceSets();
+
+    render::ResourceSetLayout::Entry grassSplatResolveResourceLayoutEntries[] =
     {
         {
-            .binding = 0,
             .resourceType = render::RESOURCE_STORAGE_BUFFER,
-            .hBuffer = hSbGrassInstanceData
+            .shaderStages = render::SHADER_TYPE_PIXEL
         },
         {
-            .binding = 1,
             .resourceType = render::RESOURCE_UNIFORM_BUFFER,
-            .hBuffer = hUbGrass
+            .shaderStages = render::SHADER_TYPE_PIXEL
         },
+    };
+    hResourceLayoutGrassSplatResolve = render::MakeResourceSetLayout(ARR_LEN(grassSplatResolveResourceLayoutEntries),
+            grassSplatResolveResourceLayoutEntries);
+
+    // Set is made with the reduced resolution target it samples
+    render::ResourceSetLayout::Entry grassUpsampleResourceLayoutEntries[] =
+    {
         {
-            .binding = 2,
             .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
-            .hTexture = hTexWindNoise,
-            .hSampler = hSamplerLinear
+            .shaderStages = render::SHADER_TYPE_PIXEL
+        },
+        {
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .shaderStages = render::SHADER_TYPE_PIXEL
         },
     };
-    hResourceSetGrassRender = render::MakeResourceSet(hResourceLayoutGrassRender, 
-            ARR_LEN(grassRenderResourceSetEntries), 
-            grassRenderResourceSetEntries);
+    hResourceLayoutGrassUpsample = render::MakeResourceSetLayout(ARR_LEN(grassUpsampleResourceLayoutEntries),
+            grassUpsampleResourceLayoutEntries);
+
+    render::ComputePipelineDesc pipelineGrassDrawArgsResetDesc = {};
+    pipelineGrassDrawArgsResetDesc.pushConstantRangeCount = 1;
+    pipelineGrassDrawArgsResetDesc.pushConstantRanges[0] =
+    {
+        .offset = 0,
+        .size = sizeof(GrassDrawArgsResetConstantBlock),
+        .shaderStages = render::SHADER_TYPE_COMPUTE,
+    };
+    pipelineGrassDrawArgsResetDesc.hShaderCompute = hCsGrassDrawArgsReset;
+    hComputePipelineGrassDrawArgsReset = render::MakeComputePipeline(pipelineGrassDrawArgsResetDesc, 1, &hResourceLayoutGrassDrawArgsReset);
+
+    // Every feature combination is compiled up front, pipelines for them are still made on first use
+    PrecompileShaderVariants("app/shaders/grass.vert", render::SHADER_TYPE_VERTEX, grassRenderFeatures);
+    PrecompileShaderVariants("app/shaders/grass.frag", render::SHADER_TYPE_PIXEL, grassRenderFeatures);
+    PrecompileShaderVariants("app/shaders/grass_cull.comp", render::SHADER_TYPE_COMPUTE, grassCullFeatures);
+
+    // Workgroup sizes are specialized, autotuning rebuilds these
+    MakeGrassPositionsPipeline();
+    MakeGrassCullPipeline();
+    // Tuned on the whole grid, per frame tile lists may be empty at startup
+    RegisterComputeKernel(COMPUTE_KERNEL_GRASS_POSITIONS, MakeGrassPositionsPipeline, PlaceAllGrassTiles);
+    RegisterComputeKernel(COMPUTE_KERNEL_GRASS_CULL, MakeGrassCullPipeline, CullAllGrassTiles);
+
+    // Other variants are built when settings first ask for them
+    GetGrassRenderPipeline(GetGrassRenderFeatures(), grassDebugMode == GRASS_DEBUG_OVERDRAW);
 
+    render::GraphicsPipelineDesc pipelineGrassSplatResolveDesc = {};
+    pipelineGrassSplatResolveDesc.hVertexLayout = hVertexLayoutDefault;
+    pipelineGrassSplatResolveDesc.hShaderVertex = hVsGrassSplatResolve;
+    pipelineGrassSplatResolveDesc.hShaderPixel = hPsGrassSplatResolve;
+    pipelineGrassSplatResolveDesc.cullMode = render::CULL_MODE_NONE;
+    hGraphicsPipelineGrassSplatResolve = render::MakeGraphicsPipeline(hRenderPassGrassRender, pipelineGrassSplatResolveDesc, 1, &hResourceLayoutGrassSplatResolve);
+
+    // Same fullscreen triangle as splat resolve, blended by upsampled blade coverage
+    render::GraphicsPipelineDesc pipelineGrassUpsampleDesc = {};
+    pipelineGrassUpsampleDesc.hVertexLayout = hVertexLayoutDefault;
+    pipelineGrassUpsampleDesc.hShaderVertex = hVsGrassSplatResolve;
+    pipelineGrassUpsampleDesc.hShaderPixel = hPsGrassUpsample;
+    pipelineGrassUpsampleDesc.cullMode = render::CULL_MODE_NONE;
+    pipelineGrassUpsampleDesc.blendMode = render::BLEND_MODE_ALPHA;
+    pipelineGrassUpsampleDesc.pushConstantRangeCount = 1;
+    pipelineGrassUpsampleDesc.pushConstantRanges[0] =
+    {
+        .offset = 0,
+        .size = sizeof(GrassUpsampleConstantBlock),
+        .shaderStages = render::SHADER_TYPE_PIXEL,
+    };
+    hGraphicsPipelineGrassUpsample = render::MakeGraphicsPipeline(hRenderPassGrassRender, pipelineGrassUpsampleDesc, 1, &hResourceLayoutGrassUpsample);
+
+    InitGrassPositions();
+}
+
+void ShutdownGrass()
+{
+    DestroyGrassTileBounds(&grassTileBounds);
+    AppHeapFree(grassTilePlaced);
+}
+
+void MakeGrassPositionsPipeline()
+{
+    if(hComputePipelineGrassPositions.IsValid())
+    {
+        render::DestroyComputePipeline(hComputePipelineGrassPositions);
+    }
     render::ComputePipelineDesc pipelineGrassPositionsDesc = {};
     pipelineGrassPositionsDesc.pushConstantRangeCount = 1;
     pipelineGrassPositionsDesc.pushConstantRanges[0] =
     {
         .offset = 0,
-        .size = sizeof(GrassConstantBlock),
+        .size = sizeof(GrassPlacementConstantBlock),
         .shaderStages = render::SHADER_TYPE_COMPUTE,
     };
     pipelineGrassPositionsDesc.hShaderCompute = hCsGrassPositions;
+    SetWorkgroupSpecialization(&pipelineGrassPositionsDesc, COMPUTE_KERNEL_GRASS_POSITIONS);
     hComputePipelineGrassPositions = render::MakeComputePipeline(pipelineGrassPositionsDesc, 1, &hResourceLayoutGrassPositions);
+}
 
-    render::GraphicsPipelineDesc pipelineGrassRenderDesc = {};
-    pipelineGrassRenderDesc.hVertexLayout = hVertexLayoutGrassRender;
-    pipelineGrassRenderDesc.hShaderVertex = hVsGrass;
-    pipelineGrassRenderDesc.hShaderPixel = hPsGrass;
-    pipelineGrassRenderDesc.pushConstantRangeCount = 1;
-    pipelineGrassRenderDesc.pushConstantRanges[0] =
+void MakeGrassCullPipeline()
+{
+    if(hComputePipelineGrassCull.IsValid())
+    {
+        render::DestroyComputePipeline(hComputePipelineGrassCull);
+    }
+    if(hComputePipelineGrassCullSplat.IsValid())
+    {
+        render::DestroyComputePipeline(hComputePipelineGrassCullSplat);
+        hComputePipelineGrassCullSplat = {};
+    }
+    hComputePipelineGrassCull = MakeGrassCullVariantPipeline(0);
+    // Splat variant needs 64-bit buffer atomics, so it's only created once splatting has a buffer
+    if(hSbGrassSplat.IsValid())
+    {
+        hComputePipelineGrassCullSplat = MakeGrassCullVariantPipeline(SHADER_FEATURE_SPLAT);
+    }
+}
+
+Handle<render::ComputePipeline> MakeGrassCullVariantPipeline(u32 features)
+{
+    ASSERT((features & ~grassCullFeatures) == 0);
+    render::ComputePipelineDesc pipelineGrassCullDesc = {};
+    pipelineGrassCullDesc.pushConstantRangeCount = 1;
+    pipelineGrassCullDesc.pushConstantRanges[0] =
     {
         .offset = 0,
         .size = sizeof(GrassConstantBlock),
-        .shaderStages = render::SHADER_TYPE_VERTEX,
+        .shaderStages = render::SHADER_TYPE_COMPUTE,
     };
-    hGraphicsPipelineGrassRender = render::MakeGraphicsPipeline(hRenderPassGrassRender, pipelineGrassRenderDesc, 1, &hResourceLayoutGrassRender);
+    pipelineGrassCullDesc.hShaderCompute = GetShaderVariant("app/shaders/grass_cull.comp", render::SHADER_TYPE_COMPUTE, features);
+    SetWorkgroupSpecialization(&pipelineGrassCullDesc, COMPUTE_KERNEL_GRASS_CULL);
+    Handle<render::ResourceSetLayout>* hLayout = (features & SHADER_FEATURE_SPLAT)
+        ? &hResourceLayoutGrassCullSplat
+        : &hResourceLayoutGrassCull;
+    return render::MakeComputePipeline(pipelineGrassCullDesc, 1, hLayout);
+}
 
-    InitGrassPositions();
+void SetGrassRenderTarget(Handle<render::RenderTarget> hRenderTarget)
+{
+    // Pipeline stays valid, new render pass is compatible as long as target formats match
+    if(hRenderPassGrassRender.IsValid())
+    {
+        DeferDestroyRenderPass(hRenderPassGrassRender);
+    }
+    render::RenderPassDesc renderPassGrassDesc = {};
+    renderPassGrassDesc.loadOp = render::LOAD_OP_LOAD;
+    renderPassGrassDesc.storeOp = render::STORE_OP_STORE;
+    renderPassGrassDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    renderPassGrassDesc.finalLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    hRenderPassGrassRender = render::MakeRenderPass(renderPassGrassDesc, hRenderTarget);
+    // Reduced resolution target follows main target size on next update
+    grassViews[grassMainView].hRenderPass = hRenderPassGrassRender;
+    grassLowResWidth = 0;
+    grassLowResHeight = 0;
 }
 
-void ShutdownGrass()
+bool IsGrassLowRes()
+{
+    return hRenderTargetGrassLowRes.IsValid();
+}
+
+void DestroyGrassLowResTarget()
+{
+    if(!hRenderTargetGrassLowRes.IsValid()) return;
+    DeferDestroyResourceSet(hResourceSetGrassUpsample);
+    DeferDestroyRenderPass(hRenderPassGrassLowRes);
+    DeferDestroyRenderTarget(hRenderTargetGrassLowRes);
+    hResourceSetGrassUpsample = {};
+    hRenderPassGrassLowRes = {};
+    hRenderTargetGrassLowRes = {};
+}
+
+void UpdateGrassLowResTarget()
+{
+    f32 scale = grassResolutionScales[grassResolutionLevel];
+    u32 width = MAX(1u, (u32)(grassUniforms.targetWidth * scale));
+    u32 height = MAX(1u, (u32)(grassUniforms.targetHeight * scale));
+    if(scale == 1.f)
+    {
+        DestroyGrassLowResTarget();
+        grassViews[grassMainView].hRenderPass = hRenderPassGrassRender;
+        return;
+    }
+    if(IsGrassLowRes() && width == grassLowResWidth && height == grassLowResHeight)
+    {
+        grassViews[grassMainView].hRenderPass = hRenderPassGrassLowRes;
+        return;
+    }
+
+    // Same formats as main target, so grass pipelines are compatible with its render pass
+    DestroyGrassLowResTarget();
+    render::RenderTargetDesc renderTargetDesc = {};
+    renderTargetDesc.width = width;
+    renderTargetDesc.height = height;
+    renderTargetDesc.colorImageCount = 1;
+    renderTargetDesc.colorImageFormats[0] = render::FORMAT_RGBA8_SRGB;
+    renderTargetDesc.depthImageFormat = render::FORMAT_D32_FLOAT;
+    hRenderTargetGrassLowRes = render::MakeRenderTarget(renderTargetDesc);
+    TrackGpuRenderTarget("Grass low res target", hRenderTargetGrassLowRes, (u64)width * height * 8);
+
+    render::RenderPassDesc renderPassDesc = {};
+    renderPassDesc.loadOp = render::LOAD_OP_LOAD;
+    renderPassDesc.storeOp = render::STORE_OP_STORE;
+    renderPassDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    renderPassDesc.finalLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    hRenderPassGrassLowRes = render::MakeRenderPass(renderPassDesc, hRenderTargetGrassLowRes);
+
+    render::ResourceSet::Entry grassUpsampleResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .hTexture = render::GetColorOutput(hRenderTargetGrassLowRes, 0),
+            .hSampler = hSamplerLinear
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .hTexture = render::GetDepthOutput(hRenderTargetGrassLowRes),
+            .hSampler = hSamplerLinear
+        },
+    };
+    hResourceSetGrassUpsample = render::MakeResourceSet(hResourceLayoutGrassUpsample,
+            ARR_LEN(grassUpsampleResourceSetEntries),
+            grassUpsampleResourceSetEntries);
+
+    grassLowResWidth = width;
+    grassLowResHeight = height;
+    grassLowResFresh = true;
+    grassViews[grassMainView].hRenderPass = hRenderPassGrassLowRes;
+}
+
+void MakeGrassResourceSets()
+{
+    // These sets reference instance, visible and tile buffers, so they are rebuilt whenever those are reallocated
+    render::ResourceSet::Entry grassDrawArgsResetResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassDrawArgs
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrass
+        },
+        {
+            .binding = 2,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrassViews
+        },
+        {
+            .binding = 3,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileCounts
+        },
+        {
+            .binding = 4,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileLists
+        },
+    };
+    hResourceSetGrassDrawArgsReset = render::MakeResourceSet(hResourceLayoutGrassDrawArgsReset,
+            ARR_LEN(grassDrawArgsResetResourceSetEntries),
+            grassDrawArgsResetResourceSetEntries);
+
+    render::ResourceSet::Entry grassPositionsResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassInstanceData
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrass
+        },
+        {
+            .binding = 2,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileCounts
+        },
+        {
+            .binding = 3,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = streamedGrassDensity.hUbMap
+        },
+        {
+            .binding = 4,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = streamedGrassDensity.hSbPageTable
+        },
+        {
+            .binding = 5,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = streamedGrassDensity.hSbTilePool
+        },
+        {
+            .binding = 6,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileLists
+        },
+        {
+            .binding = 7,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = streamedGrassSpecies.hUbMap
+        },
+        {
+            .binding = 8,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = streamedGrassSpecies.hSbPageTable
+        },
+        {
+            .binding = 9,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = streamedGrassSpecies.hSbTilePool
+        },
+    };
+    hResourceSetGrassPositions = render::MakeResourceSet(hResourceLayoutGrassPositions, 
+            ARR_LEN(grassPositionsResourceSetEntries), 
+            grassPositionsResourceSetEntries);
+
+    MakeGrassCullResourceSets();
+
+    render::ResourceSet::Entry grassRenderResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassInstanceData
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrass
+        },
+        {
+            .binding = 2,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassVisible
+        },
+        {
+            .binding = 3,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrassViews
+        },
+        {
+            .binding = 4,
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .hTexture = hTexGrassDensity,
+            .hSampler = hSamplerLinear
+        },
+        {
+            .binding = 5,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrassSpecies
+        },
+    };
+    hResourceSetGrassRender = render::MakeResourceSet(hResourceLayoutGrassRender, 
+            ARR_LEN(grassRenderResourceSetEntries), 
+            grassRenderResourceSetEntries);
+}
+
+void MakeGrassCullResourceSets()
 {
+    // Same entries for both variants, splat buffer is the last binding
+    render::ResourceSet::Entry grassCullResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassInstanceData
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrass
+        },
+        {
+            .binding = 2,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassDrawArgs
+        },
+        {
+            .binding = 3,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassVisible
+        },
+        {
+            .binding = 4,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrassViews
+        },
+        {
+            .binding = 5,
+            .resourceType = render::RESOURCE_SAMPLED_TEXTURE,
+            .hTexture = hTexWindNoise,
+            .hSampler = hSamplerLinear
+        },
+        {
+            .binding = 6,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileCounts
+        },
+        {
+            .binding = 7,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassTileLists
+        },
+        {
+            .binding = 8,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrassSpecies
+        },
+        {
+            .binding = 9,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassSplat
+        },
+    };
+    hResourceSetGrassCull = render::MakeResourceSet(hResourceLayoutGrassCull,
+            ARR_LEN(grassCullResourceSetEntries) - 1,
+            grassCullResourceSetEntries);
+    hResourceSetGrassCullSplat = {};
+    if(hSbGrassSplat.IsValid())
+    {
+        hResourceSetGrassCullSplat = render::MakeResourceSet(hResourceLayoutGrassCullSplat,
+                ARR_LEN(grassCullResourceSetEntries),
+                grassCullResourceSetEntries);
+    }
 }
 
 void InitGrassPositions()
 {
-    // Submit once at init time to populate SSBO with all grass positions
-    // TODO(caio): For dynamic grass density, will need to populate these every frame
-    Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_IMMEDIATE);
-    render::BeginCommandBuffer(hCmd);
-    PopulateGrassPositions(hCmd);
-    render::EndCommandBuffer(hCmd);
-    render::SubmitImmediate(hCmd);
+    // Baked blades are uploaded from the mapped file when available, every tile starts out placed
+    GrassBakeFile bake = {};
+    if(MapGrassBakeFile(GRASS_BAKE_PATH, &bake))
+    {
+        UploadGrassBake(&bake);
+        UnmapGrassBakeFile(&bake);
+        return;
+    }
+
+    // Otherwise tiles are placed as they become visible, and again whenever grid or terrain changes
+    grassPositionsDirty = true;
 }
 
 void UpdateGrassConstants()
 {
-    grassConstants.view = math::Transpose(appCamera.GetView());
-    grassConstants.proj = math::Transpose(appCamera.GetProjection());
+    SetGrassView(grassMainView, appCamera.GetView(), appCamera.GetProjection(), appCamera.position);
     grassConstants.worldTime = worldTime;
     grassConstants.deltaTime = deltaTime;
 }
 
+u32 AddGrassView(Handle<render::RenderPass> hRenderPass)
+{
+    // Extra views must target passes compatible with main grass pass
+    ASSERT(grassViewCount < maxGrassViews);
+    u32 viewIndex = grassViewCount++;
+    grassViews[viewIndex] = {};
+    grassViews[viewIndex].hRenderPass = hRenderPass;
+    return viewIndex;
+}
+
+void SetGrassView(u32 viewIndex, math::m4f view, math::m4f proj, math::v3f position)
+{
+    ASSERT(viewIndex < grassViewCount);
+    grassViews[viewIndex].view = view;
+    grassViews[viewIndex].proj = proj;
+    grassViews[viewIndex].position = position;
+}
+
+void UpdateGrassViews()
+{
+    grassViewsUniforms.viewCount = grassViewCount;
+    for(u32 i = 0; i < grassViewCount; i++)
+    {
+        grassViewsUniforms.views[i].viewProj = math::Transpose(grassViews[i].proj * grassViews[i].view);
+        grassViewsUniforms.views[i].position = grassViews[i].position;
+    }
+    render::CopyMemoryToBuffer(hUbGrassViews, 0, sizeof(GrassViewsBlock), &grassViewsUniforms);
+}
+
 void UpdateGrassUniforms()
 {
     //TODO(caio): CONTINUE:
     // - Add color uniforms
-    egui::DragF32(IStr("Grass Density"), &grassUniforms.grassDensity, 0.1f, 0.1f, 10.f);
+    egui::DragF32(IStr("Grass Density"), &grassDensityRequested, 0.1f, 0.1f, 10.f);
     egui::SliderAngle(IStr("Wind Angle"), &grassUniforms.windAngle);
     egui::SliderF32(IStr("Wind Strength"), &grassUniforms.windStrength, 0, 10);
+    egui::SliderF32(IStr("Grass Far Distance"), &grassUniforms.farDistance, 10, 400);
+    egui::SliderF32(IStr("Grass Far Fade Band"), &grassUniforms.farFadeBand, 1, 100);
+    egui::SliderF32(IStr("Grass Splat Pixel Size (0 = off)"), &grassSplatPixelSize, 0, 16);
+    egui::SliderI32(IStr("Grass Debug View"), &grassDebugMode, 0, GRASS_DEBUG_COUNT - 1);
+    egui::Text("Grass debug view: %s", grassDebugModeNames[grassDebugMode]);
+    egui::SliderI32(IStr("Grass Resolution Level"), &grassResolutionLevel, 0, ARR_LEN(grassResolutionScales) - 1);
+    egui::Text("Grass resolution scale: %.2f", grassResolutionScales[grassResolutionLevel]);
+    for(u32 i = 0; i < grassSpeciesCount; i++)
+    {
+        egui::Text("Grass species %u: %s", i, grassSpeciesDescs[i].name);
+    }
+    UpdateTraceSettings();
+    grassUniforms.grassDensity = grassDensityRequested * GetGovernorDensityScale();
     grassUniforms.terrainSize = terrainConstants.terrainSize;
+    grassUniforms.targetWidth = (u32)(appWidth * renderScale);
+    grassUniforms.targetHeight = (u32)(appHeight * renderScale);
+    // Distance where blade height projects to grassSplatPixelSize pixels
+    f32 projectionScaleY = 1.f / tanf(appCamera.fov * 0.5f);
+    grassUniforms.splatDistance = grassSplatPixelSize > 0
+        ? grassUniforms.bladeHeight * projectionScaleY * 0.5f * grassUniforms.targetHeight / grassSplatPixelSize
+        : 1e30f;
+    grassUniforms.bladesPerSide = GetGrassBladesPerSide();
+    UpdateGrassInstanceCapacity();
+    grassUniforms.instanceCapacity = grassInstanceCapacity;
+    // Placement only depends on grid and terrain, so it is reused until either changes
+    if(grassUniforms.bladesPerSide != grassPlacedBladesPerSide || grassUniforms.terrainSize != grassPlacedTerrainSize)
+    {
+        grassPositionsDirty = true;
+    }
+    // Streamed density or species tiles changed. Baked blades came from full resolution maps and stay valid.
+    if(!grassPositionsDirty && !grassPlacedFromBake)
+    {
+        InvalidateGrassTilesOverMapPages(&streamedGrassDensity);
+        InvalidateGrassTilesOverMapPages(&streamedGrassSpecies);
+    }
     render::CopyMemoryToBuffer(hUbGrass, 0, sizeof(GrassUniformBlock), &grassUniforms);
+    UpdateGrassLowResTarget();
+    UpdateGrassViews();
+    UpdateGrassTiles();
 }
 
-void PopulateGrassPositions(Handle<render::CommandBuffer> hCmd)
+u32 GetGrassBladesPerSide()
 {
+    u32 grassInstanceCount = (u32)(grassUniforms.grassDensity * grassUniforms.terrainSize * grassUniforms.terrainSize);
+    return (u32)sqrt((f64)grassInstanceCount);
+}
+
+u32 GetGrassTilesPerSide()
+{
+    return (grassUniforms.bladesPerSide + grassTileBladesPerSide - 1) / grassTileBladesPerSide;
+}
+
+u32 GetGrassTileOrderIndex(u32 cellX, u32 cellY)
+{
+    if(grassInstanceOrder == GRASS_INSTANCE_ORDER_ROW_MAJOR)
+    {
+        return cellY * grassTileBladesPerSide + cellX;
+    }
+    // Interleaves cell bits, x in even bits, same as grass_positions.comp
+    u32 result = 0;
+    for(u32 bit = 0; (1u << bit) < grassTileBladesPerSide; bit++)
+    {
+        result |= ((cellX >> bit) & 1) << (2 * bit);
+        result |= ((cellY >> bit) & 1) << (2 * bit + 1);
+    }
+    return result;
+}
+
+void MakeGrassTileBuffers()
+{
+    // Tile ranges cover instance buffer, so capacity in tiles follows instance capacity
+    grassTileListCapacity = grassInstanceCapacity / grassTileBladeCapacity;
+    hSbGrassTileCounts = MakeGpuBuffer("Grass tile counts", render::BUFFER_TYPE_STORAGE,
+            sizeof(u32) * grassTileCountStride * grassTileListCapacity,
+            sizeof(u32) * grassTileCountStride * grassTileListCapacity);
+    u32 listsCount = (RENDER_CONCURRENT_FRAMES * 2 + 1) * grassTileListCapacity;
+    u32* lists = (u32*)AppHeapAlloc(listsCount * sizeof(u32));
+    memset(lists, 0, listsCount * sizeof(u32));
+    u32* allTiles = lists + RENDER_CONCURRENT_FRAMES * 2 * grassTileListCapacity;
+    for(u32 i = 0; i < grassTileListCapacity; i++)
+    {
+        allTiles[i] = i;
+    }
+    hSbGrassTileLists = MakeGpuBuffer("Grass tile lists", render::BUFFER_TYPE_STORAGE,
+            listsCount * sizeof(u32),
+            listsCount * sizeof(u32),
+            lists);
+    AppHeapFree(lists);
+
+    AppHeapFree(grassTilePlaced);
+    grassTilePlaced = (u8*)AppHeapAlloc(grassTileListCapacity);
+    memset(grassTilePlaced, 0, grassTileListCapacity);
+    grassTilePlaceCount = 0;
+    grassTileVisibleCount = 0;
+}
+
+u32 GetGrassAllTilesListOffset()
+{
+    return RENDER_CONCURRENT_FRAMES * 2 * grassTileListCapacity;
+}
+
+void UpdateGrassInstanceCapacity()
+{
+    // Whole tiles, every tile owns a full range even if density mask discards most of it
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    u32 requiredCount = tilesPerSide * tilesPerSide * grassTileBladeCapacity;
+    bool grow = requiredCount > grassInstanceCapacity;
+    bool shrink = grassInstanceCapacity > grassMinInstanceCapacity
+        && requiredCount < (u32)(grassInstanceCapacity * grassCapacityShrinkThreshold);
+    if(!grow && !shrink) return;
+
+    u32 newCapacity = MAX(grassMinInstanceCapacity,
+            (u32)(tilesPerSide * tilesPerSide * grassCapacityGrowFactor) * grassTileBladeCapacity);
+    LOGF("Grass instance capacity: %u -> %u blades (%u required)\n", grassInstanceCapacity, newCapacity, requiredCount);
+
+    // Old buffers and sets may still be in use by frames in flight
+    DeferDestroyBuffer(hSbGrassInstanceData);
+    DeferDestroyBuffer(hSbGrassVisible);
+    DeferDestroyBuffer(hSbGrassTileCounts);
+    DeferDestroyBuffer(hSbGrassTileLists);
+    DeferDestroyResourceSet(hResourceSetGrassDrawArgsReset);
+    DeferDestroyResourceSet(hResourceSetGrassPositions);
+    DeferDestroyResourceSet(hResourceSetGrassCull);
+    if(hResourceSetGrassCullSplat.IsValid()) DeferDestroyResourceSet(hResourceSetGrassCullSplat);
+    DeferDestroyResourceSet(hResourceSetGrassRender);
+
+    grassInstanceCapacity = newCapacity;
+    hSbGrassInstanceData = MakeGpuBuffer("Grass instances", render::BUFFER_TYPE_STORAGE,
+            sizeof(GrassInstanceDataBlock) * grassInstanceCapacity, 
+            sizeof(GrassInstanceDataBlock) * grassInstanceCapacity);
+    hSbGrassVisible = MakeGpuBuffer("Grass visible indices", render::BUFFER_TYPE_STORAGE,
+            sizeof(u32) * grassInstanceCapacity * maxGrassViews,
+            sizeof(u32) * grassInstanceCapacity * maxGrassViews);
+    MakeGrassTileBuffers();
+    MakeGrassResourceSets();
+    // New instance buffer starts out empty
+    grassPositionsDirty = true;
+}
+
+void ResetGrassTiles(bool placed)
+{
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    ASSERT(tilesPerSide * tilesPerSide <= grassTileListCapacity);
+    memset(grassTilePlaced, placed ? 1 : 0, tilesPerSide * tilesPerSide);
+}
+
+void InvalidateGrassTilesOverMapPages(const StreamedMap* map)
+{
+    if(!map->header || !map->residencyChanged || grassUniforms.bladesPerSide == 0) return;
+    // Blade in cell c reads texel floor(uv * size) with uv in [c, c + 1) / bladesPerSide
+    TiledMapHeader& header = *map->header;
+    TiledMapMip& finest = header.mips[0];
+    u32 bladesPerSide = grassUniforms.bladesPerSide;
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    for(u32 pageY = 0; pageY < finest.tilesY; pageY++)
+    {
+        for(u32 pageX = 0; pageX < finest.tilesX; pageX++)
+        {
+            if(!map->pagesChanged[pageY * finest.tilesX + pageX]) continue;
+            // Page texel rect in cells, widened by a cell for rounding at its edges
+            u32 texelMaxX = MIN((pageX + 1) * header.tileSize, header.width);
+            u32 texelMaxY = MIN((pageY + 1) * header.tileSize, header.height);
+            u32 cellMinX = (u32)MAX((i64)pageX * header.tileSize * bladesPerSide / header.width - 1, (i64)0);
+            u32 cellMinY = (u32)MAX((i64)pageY * header.tileSize * bladesPerSide / header.height - 1, (i64)0);
+            u32 cellMaxX = (u32)MIN((u64)texelMaxX * bladesPerSide / header.width + 1, (u64)bladesPerSide - 1);
+            u32 cellMaxY = (u32)MIN((u64)texelMaxY * bladesPerSide / header.height + 1, (u64)bladesPerSide - 1);
+            for(u32 tileY = cellMinY / grassTileBladesPerSide; tileY <= cellMaxY / grassTileBladesPerSide; tileY++)
+            {
+                for(u32 tileX = cellMinX / grassTileBladesPerSide; tileX <= cellMaxX / grassTileBladesPerSide; tileX++)
+                {
+                    grassTilePlaced[tileY * tilesPerSide + tileX] = 0;
+                }
+            }
+        }
+    }
+}
+
+void UpdateGrassTiles()
+{
+    // Placement inputs changed, tiles are placed again as they become visible
+    if(grassPositionsDirty)
+    {
+        ResetGrassTiles(false);
+        grassPositionsDirty = false;
+        grassPlacedFromBake = false;
+        grassPlacedBladesPerSide = grassUniforms.bladesPerSide;
+        grassPlacedTerrainSize = grassUniforms.terrainSize;
+    }
+
+    // Wind can push blade tip up to windStrength * height sideways, same bounds as grass_cull.comp
+    u32 bladesPerSide = grassUniforms.bladesPerSide;
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    f32 radius = grassUniforms.bladeHeight * (0.5f + grassUniforms.windStrength);
+    if(bladesPerSide != grassTileBoundsBladesPerSide
+            || grassUniforms.terrainSize != grassTileBoundsTerrainSize
+            || radius != grassTileBoundsRadius)
+    {
+        ResizeGrassTileBounds(&grassTileBounds, tilesPerSide * tilesPerSide);
+        f32 cellSize = grassUniforms.terrainSize / (f32)bladesPerSide;
+        f32 centerY = grassUniforms.bladeHeight * 0.5f;
+        for(u32 y = 0; y < tilesPerSide; y++)
+        {
+            for(u32 x = 0; x < tilesPerSide; x++)
+            {
+                // Edge tiles are partial, grid needn't be a multiple of tile size
+                u32 tile = y * tilesPerSide + x;
+                grassTileBounds.minX[tile] = x * grassTileBladesPerSide * cellSize - radius;
+                grassTileBounds.maxX[tile] = MIN((x + 1) * grassTileBladesPerSide, bladesPerSide) * cellSize + radius;
+                grassTileBounds.minY[tile] = centerY - radius;
+                grassTileBounds.maxY[tile] = centerY + radius;
+                grassTileBounds.minZ[tile] = y * grassTileBladesPerSide * cellSize - radius;
+                grassTileBounds.maxZ[tile] = MIN((y + 1) * grassTileBladesPerSide, bladesPerSide) * cellSize + radius;
+            }
+        }
+        grassTileBoundsBladesPerSide = bladesPerSide;
+        grassTileBoundsTerrainSize = grassUniforms.terrainSize;
+        grassTileBoundsRadius = radius;
+    }
+
+    GrassFrustum frusta[maxGrassViews];
+    for(u32 i = 0; i < grassViewCount; i++)
+    {
+        frusta[i] = MakeGrassFrustum(grassViews[i].proj * grassViews[i].view, grassViews[i].position, grassUniforms.farDistance);
+    }
+    // Lists only live until they are copied into this frame's region below
+    u32* visibleList = ArenaPush<u32>(GetFrameArena(), grassTileListCapacity);
+    u32* placeList = ArenaPush<u32>(GetFrameArena(), grassTileListCapacity);
+    grassTileVisibleCount = CullGrassTiles(grassTileBounds, frusta, grassViewCount,
+            visibleList, grassTileViewVisibleCounts);
+    grassTilePlaceCount = 0;
+    for(u32 i = 0; i < grassTileVisibleCount; i++)
+    {
+        u32 tile = visibleList[i];
+        if(grassTilePlaced[tile]) continue;
+        grassTilePlaced[tile] = 1;
+        placeList[grassTilePlaceCount++] = tile;
+    }
+
+    // Lists of frames in flight stay intact until those frames retire
+    u32 region = (u32)(currentFrame % RENDER_CONCURRENT_FRAMES);
+    grassTilePlaceListOffset = region * 2 * grassTileListCapacity;
+    grassTileVisibleListOffset = grassTilePlaceListOffset + grassTileListCapacity;
+    if(grassTilePlaceCount > 0)
+    {
+        render::CopyMemoryToBuffer(hSbGrassTileLists, grassTilePlaceListOffset * sizeof(u32),
+                grassTilePlaceCount * sizeof(u32), placeList);
+    }
+    if(grassTileVisibleCount > 0)
+    {
+        render::CopyMemoryToBuffer(hSbGrassTileLists, grassTileVisibleListOffset * sizeof(u32),
+                grassTileVisibleCount * sizeof(u32), visibleList);
+    }
+}
+
+void ResetGrassDrawArgs(Handle<render::CommandBuffer> hCmd, u32 listOffset, u32 tileCount)
+{
+    // Resets view and species args, and splits views' visible list regions between species
+    GrassDrawArgsResetConstantBlock constants = {};
+    constants.tileListOffset = listOffset;
+    constants.tileCount = tileCount;
+    render::CmdBindComputePipeline(hCmd, hComputePipelineGrassDrawArgsReset);
+    render::CmdUpdatePushConstantRange(hCmd, 0, &constants, hComputePipelineGrassDrawArgsReset);
+    render::CmdBindComputeResources(hCmd, hComputePipelineGrassDrawArgsReset, hResourceSetGrassDrawArgsReset, 0);
+    render::CmdDispatch(hCmd, 1, 1, 1);
+}
+
+void ResetVisibleGrassDrawArgs(Handle<render::CommandBuffer> hCmd)
+{
+    ResetGrassDrawArgs(hCmd, grassTileVisibleListOffset, grassTileVisibleCount);
+}
+
+void DispatchGrassPlacement(Handle<render::CommandBuffer> hCmd, u32 listOffset, u32 tileCount)
+{
+    GrassPlacementConstantBlock constants = {};
+    constants.placeListOffset = listOffset;
+    constants.instanceOrder = (u32)grassInstanceOrder;
     render::CmdBindComputePipeline(hCmd, hComputePipelineGrassPositions);
-    render::CmdUpdatePushConstantRange(hCmd, 0, &grassConstants, hComputePipelineGrassPositions);
+    render::CmdUpdatePushConstantRange(hCmd, 0, &constants, hComputePipelineGrassPositions);
     render::CmdBindComputeResources(hCmd, hComputePipelineGrassPositions, hResourceSetGrassPositions, 0);
+    // Workgroup per listed tile, its invocations stride over the tile's cells in instance order,
+    // then compact survivors keeping that order and write the tile's blade count
+    render::CmdDispatch(hCmd, tileCount, 1, 1);
+}
 
-    i32 grassInstanceCount = grassUniforms.grassDensity * terrainConstants.terrainSize * terrainConstants.terrainSize;
-    i32 bladesPerSide = (i32)(sqrt(grassInstanceCount));
-    i32 localSizeX = 16;
-    i32 localSizeY = 16;
-    render::CmdDispatch(hCmd, bladesPerSide/localSizeX, bladesPerSide/localSizeY, 1);
+void PopulateGrassPositions(Handle<render::CommandBuffer> hCmd)
+{
+    if(grassTilePlaceCount == 0) return;
+    DispatchGrassPlacement(hCmd, grassTilePlaceListOffset, grassTilePlaceCount);
 }
 
-void RenderGrassInstances(Handle<render::CommandBuffer> hCmd)
+void PlaceAllGrassTiles(Handle<render::CommandBuffer> hCmd)
 {
-    render::BeginRenderPass(hCmd, hRenderPassGrassRender);
-    render::CmdBindGraphicsPipeline(hCmd, hGraphicsPipelineGrassRender);
-    render::CmdUpdatePushConstantRange(hCmd, 0, &grassConstants, hGraphicsPipelineGrassRender);
-    render::CmdSetViewport(hCmd, hRenderPassGrassRender);
-    render::CmdSetScissor(hCmd, hRenderPassGrassRender);
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    ASSERT(tilesPerSide * tilesPerSide <= grassTileListCapacity);
+    DispatchGrassPlacement(hCmd, GetGrassAllTilesListOffset(), tilesPerSide * tilesPerSide);
+}
+
+void DispatchGrassCull(Handle<render::CommandBuffer> hCmd, u32 listOffset, u32 tileCount)
+{
+    // One pass over blades of listed tiles for all views, caller orders it after placement and draw args reset
+    if(tileCount == 0) return;
+
+    GrassConstantBlock constants = grassConstants;
+    constants.tileListOffset = listOffset;
+    // Splat set only exists while frame graph gives splat a buffer
+    bool splat = hResourceSetGrassCullSplat.IsValid();
+    Handle<render::ComputePipeline> hPipeline = splat ? hComputePipelineGrassCullSplat : hComputePipelineGrassCull;
+    render::CmdBindComputePipeline(hCmd, hPipeline);
+    render::CmdUpdatePushConstantRange(hCmd, 0, &constants, hPipeline);
+    render::CmdBindComputeResources(hCmd, hPipeline, splat ? hResourceSetGrassCullSplat : hResourceSetGrassCull, 0);
+
+    // Placed count per tile is only known on GPU, so cover the tile's whole range and let shader discard the rest
+    WorkgroupSize workgroupSize = GetWorkgroupSize(COMPUTE_KERNEL_GRASS_CULL);
+    render::CmdDispatch(hCmd, GetWorkgroupCount(grassTileBladeCapacity, workgroupSize.x), tileCount, 1);
+}
+
+void CullGrassInstances(Handle<render::CommandBuffer> hCmd)
+{
+    DispatchGrassCull(hCmd, grassTileVisibleListOffset, grassTileVisibleCount);
+}
+
+void CullAllGrassTiles(Handle<render::CommandBuffer> hCmd)
+{
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    ASSERT(tilesPerSide * tilesPerSide <= grassTileListCapacity);
+    ResetGrassDrawArgs(hCmd, GetGrassAllTilesListOffset(), tilesPerSide * tilesPerSide);
+    // Runs outside frame graph, so it orders cull after reset itself
+    render::Barrier barrier = {};
+    barrier.srcAccess = render::MEMORY_ACCESS_SHADER_WRITE;
+    barrier.dstAccess = render::MEMORY_ACCESS_SHADER_READ;
+    barrier.srcStage = render::PIPELINE_STAGE_COMPUTE_SHADER;
+    barrier.dstStage = render::PIPELINE_STAGE_COMPUTE_SHADER;
+    render::CmdPipelineBarrier(hCmd, barrier);
+    DispatchGrassCull(hCmd, GetGrassAllTilesListOffset(), tilesPerSide * tilesPerSide);
+}
+
+u32 GetGrassRenderFeatures()
+{
+    u32 result = 0;
+    if(grassUniforms.windStrength > 0) result |= SHADER_FEATURE_WIND;
+    if(grassDebugMode != GRASS_DEBUG_NONE) result |= SHADER_FEATURE_DEBUG_VIEW;
+    return result & grassRenderFeatures;
+}
+
+Handle<render::GraphicsPipeline> GetGrassRenderPipeline(u32 features, bool overdraw)
+{
+    ASSERT((features & ~grassRenderFeatures) == 0);
+    Handle<render::GraphicsPipeline>* hPipeline = overdraw ?
+        &hGraphicsPipelinesGrassOverdraw[features] :
+        &hGraphicsPipelinesGrassRender[features];
+    if(hPipeline->IsValid()) return *hPipeline;
+
+    render::GraphicsPipelineDesc desc = {};
+    desc.hVertexLayout = hVertexLayoutGrassRender;
+    desc.hShaderVertex = GetShaderVariant("app/shaders/grass.vert", render::SHADER_TYPE_VERTEX, features);
+    desc.hShaderPixel = GetShaderVariant("app/shaders/grass.frag", render::SHADER_TYPE_PIXEL, features);
+    desc.pushConstantRangeCount = 1;
+    desc.pushConstantRanges[0] =
+    {
+        .offset = 0,
+        .size = sizeof(GrassConstantBlock),
+        .shaderStages = render::SHADER_TYPE_VERTEX,
+    };
+    if(overdraw) desc.blendMode = render::BLEND_MODE_ADDITIVE;
+    *hPipeline = render::MakeGraphicsPipeline(hRenderPassGrassRender, desc, 1, &hResourceLayoutGrassRender);
+    return *hPipeline;
+}
+
+void RenderGrassInstances(Handle<render::CommandBuffer> hCmd, u32 viewIndex)
+{
+    ASSERT(viewIndex < grassViewCount);
+    // Every tile is outside the view, so cull compute left its draw empty
+    if(grassTileViewVisibleCounts[viewIndex] == 0) return;
+    GrassView& view = grassViews[viewIndex];
+    grassConstants.view = math::Transpose(view.view);
+    grassConstants.proj = math::Transpose(view.proj);
+    grassConstants.viewIndex = viewIndex;
+    grassConstants.debugMode = (u32)grassDebugMode;
+    // Same layout and resources, variants differ in compiled features and blending
+    Handle<render::GraphicsPipeline> hPipeline = GetGrassRenderPipeline(GetGrassRenderFeatures(), grassDebugMode == GRASS_DEBUG_OVERDRAW);
+
+    render::BeginRenderPass(hCmd, view.hRenderPass);
+    render::CmdBindGraphicsPipeline(hCmd, hPipeline);
+    render::CmdUpdatePushConstantRange(hCmd, 0, &grassConstants, hPipeline);
+    render::CmdSetViewport(hCmd, view.hRenderPass);
+    render::CmdSetScissor(hCmd, view.hRenderPass);
     render::CmdBindVertexBuffer(hCmd, hVbGrass);
     render::CmdBindIndexBuffer(hCmd, hIbGrass);
     //u32 resourceDynamicOffsets[] =
@@ -218,12 +1243,107 @@ void RenderGrassInstances(Handle<render::CommandBuffer> hCmd)
         //(frame % RENDER_CONCURRENT_FRAMES) * maxGrassInstances * (u32)sizeof(GrassInstanceDataBlock),
     //};
     render::CmdBindGraphicsResources(hCmd, 
-            hGraphicsPipelineGrassRender, 
+            hPipeline, 
             hResourceSetGrassRender, 0,
             0, NULL);
     //render::CmdDrawIndexed(hCmd, hIbGrass, maxGrassInstances);
-    i32 grassInstanceCount = grassUniforms.grassDensity * terrainConstants.terrainSize * terrainConstants.terrainSize;
-    render::CmdDrawIndexed(hCmd, hIbGrass, grassInstanceCount);
+    // Instance counts come from blades that survived the density mask and view's cull. Every species
+    // is one draw of a single multi draw indirect call, args give its mesh range and visible list range.
+    render::CmdDrawIndexedIndirect(hCmd, hIbGrass, hSbGrassDrawArgs,
+            viewIndex * grassSpeciesCount * sizeof(GrassDrawArgsBlock), grassSpeciesCount);
+    render::EndRenderPass(hCmd, view.hRenderPass);
+}
+
+bool IsGrassSplatEnabled()
+{
+    return grassSplatPixelSize > 0;
+}
+
+u64 GetGrassSplatSize()
+{
+    // Sized for full resolution, render scale only shrinks what is addressed
+    return (u64)appWidth * appHeight * sizeof(u64);
+}
+
+void SetGrassSplatBuffer(Handle<render::Buffer> hBuffer)
+{
+    if(hBuffer.value == hSbGrassSplat.value) return;
+
+    // Cull sets reference splat buffer, frames in flight may still use old ones.
+    // Buffer itself belongs to frame graph.
+    DeferDestroyResourceSet(hResourceSetGrassCull);
+    if(hResourceSetGrassCullSplat.IsValid()) DeferDestroyResourceSet(hResourceSetGrassCullSplat);
+    if(hResourceSetGrassSplatResolve.IsValid()) DeferDestroyResourceSet(hResourceSetGrassSplatResolve);
+    hResourceSetGrassSplatResolve = {};
+    hSbGrassSplat = hBuffer;
+    MakeGrassCullResourceSets();
+    if(!hSbGrassSplat.IsValid()) return;
+
+    render::ResourceSet::Entry grassSplatResolveResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = hSbGrassSplat
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbGrass
+        },
+    };
+    hResourceSetGrassSplatResolve = render::MakeResourceSet(hResourceLayoutGrassSplatResolve,
+            ARR_LEN(grassSplatResolveResourceSetEntries),
+            grassSplatResolveResourceSetEntries);
+    if(!hComputePipelineGrassCullSplat.IsValid())
+    {
+        hComputePipelineGrassCullSplat = MakeGrassCullVariantPipeline(SHADER_FEATURE_SPLAT);
+    }
+}
+
+void ClearGrassSplat(Handle<render::CommandBuffer> hCmd)
+{
+    // Transient contents are undefined, every pixel starts out empty at max depth
+    render::CmdFillBuffer(hCmd, hSbGrassSplat, 0xFFFFFFFF);
+}
+
+void ResolveGrassSplat(Handle<render::CommandBuffer> hCmd)
+{
+    // Writes splatted blades with their depth, so they are depth tested against terrain and near blades
+    render::BeginRenderPass(hCmd, hRenderPassGrassRender);
+    render::CmdBindGraphicsPipeline(hCmd, hGraphicsPipelineGrassSplatResolve);
+    render::CmdSetViewport(hCmd, hRenderPassGrassRender);
+    render::CmdSetScissor(hCmd, hRenderPassGrassRender);
+    render::CmdBindVertexBuffer(hCmd, hVbFullscreen);
+    render::CmdBindIndexBuffer(hCmd, hIbFullscreen);
+    render::CmdBindGraphicsResources(hCmd,
+            hGraphicsPipelineGrassSplatResolve,
+            hResourceSetGrassSplatResolve, 0,
+            0, NULL);
+    render::CmdDrawIndexed(hCmd, hIbFullscreen, 1);
+    render::EndRenderPass(hCmd, hRenderPassGrassRender);
+}
+
+void UpsampleGrass(Handle<render::CommandBuffer> hCmd)
+{
+    ASSERT(IsGrassLowRes());
+    GrassUpsampleConstantBlock constants = {};
+    constants.targetSize = { (f32)grassUniforms.targetWidth, (f32)grassUniforms.targetHeight };
+    constants.lowResSize = { (f32)grassLowResWidth, (f32)grassLowResHeight };
+    constants.depthSharpness = grassUpsampleDepthSharpness;
+
+    render::BeginRenderPass(hCmd, hRenderPassGrassRender);
+    render::CmdBindGraphicsPipeline(hCmd, hGraphicsPipelineGrassUpsample);
+    render::CmdUpdatePushConstantRange(hCmd, 0, &constants, hGraphicsPipelineGrassUpsample);
+    render::CmdSetViewport(hCmd, hRenderPassGrassRender);
+    render::CmdSetScissor(hCmd, hRenderPassGrassRender);
+    render::CmdBindVertexBuffer(hCmd, hVbFullscreen);
+    render::CmdBindIndexBuffer(hCmd, hIbFullscreen);
+    render::CmdBindGraphicsResources(hCmd,
+            hGraphicsPipelineGrassUpsample,
+            hResourceSetGrassUpsample, 0,
+            0, NULL);
+    render::CmdDrawIndexed(hCmd, hIbFullscreen, 1);
     render::EndRenderPass(hCmd, hRenderPassGrassRender);
 }
 
@@ -6,21 +6,147 @@
 #include "engine/src/asset/asset.hpp"
 #include "engine/src/render/render.hpp"
 
+#include "app/state.hpp"
 #include "app/camera.hpp"
+#include "app/mesh_optimize.hpp"
+#include "app/compute_tuning.hpp"
+#include "app/shader_variants.hpp"
+#include "app/grass_tiles.hpp"
 
 namespace ty
 {
 namespace Grass
 {
 
-const i32 maxGrassInstances = 256 * 256 * 16;
+// Instance buffer capacity follows required blade count with hysteresis,
+// so small density changes don't reallocate every frame.
+const u32 grassMinInstanceCapacity = 64 * 64;
+const f32 grassCapacityGrowFactor = 1.25f;      // Headroom over required count when (re)allocating
+const f32 grassCapacityShrinkThreshold = 0.25f; // Shrink once required count falls below this fraction
+
+// Grass is rendered for up to maxGrassViews views per frame (split screen, minimap, probes).
+// Field is split into tiles of grassTileBladesPerSide^2 placement cells. Every frame tile bounds are
+// culled on CPU against all views (see grass_tiles.hpp). Visible tiles not placed yet are placed, a
+// workgroup per tile, and placed tiles stay valid until grid, terrain or streamed density changes.
+// Then a single cull dispatch over visible tiles tests their blades against every view, samples wind
+// once per blade, and appends visible blade indices to per view lists consumed by per view indirect draws.
+const u32 maxGrassViews = 4;
+const u32 grassMainView = 0;    // appCamera, also the only view distant blades are splatted for
+
+// Each tile owns a fixed range of grassTileBladeCapacity instances, starting at tile * grassTileBladeCapacity
+const u32 grassTileBladesPerSide = 32;     // Power of two, so Morton order covers a tile exactly
+const u32 grassTileBladeCapacity = grassTileBladesPerSide * grassTileBladesPerSide;
+
+// Order of surviving blades within a tile's range. Morton (Z) order keeps blades that are close on
+// the field close in instance buffer, so blade cull workgroups, their visible list chunks and
+// vertex fetches of consecutive instances touch few cache lines. Row major is kept for benchmarks.
+enum GrassInstanceOrder
+{
+    GRASS_INSTANCE_ORDER_ROW_MAJOR,
+    GRASS_INSTANCE_ORDER_MORTON,
+};
+inline GrassInstanceOrder grassInstanceOrder = GRASS_INSTANCE_ORDER_MORTON;
+
+// Species share one blade pipeline. Their meshes are merged into one vertex and index buffer, placement
+// picks a species per blade from the streamed species mask, and cull appends visible blades to per view
+// and species ranges of the visible list. A view then draws every species with one multi draw indirect
+// call, so adding species adds draw args entries, not draw calls, binds or recording cost.
+const u32 grassSpeciesCount = 3;
+// Per tile in tile counts buffer: placed blades, then placed blades of each species
+const u32 grassTileCountStride = 1 + grassSpeciesCount;
+// Width of the random band around species boundaries of the mask, same as grass_positions.comp
+const f32 grassSpeciesBlend = 0.2f;
+
+struct GrassSpeciesDesc
+{
+    const char* name = NULL;
+    const char* modelPath = NULL;       // Falls back to grass model when missing
+    f32 heightScale = 1.f;
+    math::v3f tipColor = {};
+};
+
+// Mask values select species in this order, 0 picks the first one
+inline const GrassSpeciesDesc grassSpeciesDescs[grassSpeciesCount] =
+{
+    { "Short grass", MODEL_PATH"grass/grass.obj", 0.6f, {0.15f, 0.9f, 0} },
+    { "Tall grass", MODEL_PATH"grass/grass.obj", 1.5f, {0.4f, 0.8f, 0.05f} },
+    { "Flowers", MODEL_PATH"flower/flower.obj", 0.8f, {0.95f, 0.8f, 0.2f} },
+};
+
+struct GrassSpeciesMesh
+{
+    u32 firstIndex = 0;         // Species range in merged index and vertex buffers
+    u32 indexCount = 0;
+    i32 vertexOffset = 0;
+};
+
+struct GrassSpeciesBlock
+{
+    math::v3f positionMin = {};         // Dequantizes 16 bit blade mesh positions, height scale applied
+    f32 height = 0;
+    math::v3f positionExtent = {};
+    f32 padding0 = 0;
+    math::v3f tipColor = {};
+    f32 padding1 = 0;
+};
+
+struct GrassSpeciesUniformBlock
+{
+    GrassSpeciesBlock species[grassSpeciesCount];
+};
+
+struct GrassPlacementConstantBlock
+{
+    u32 placeListOffset = 0;
+    u32 instanceOrder = 0;      // GrassInstanceOrder
+};
 
 struct GrassInstanceDataBlock
 {
     math::v3f position = {};
-    f32 padding0 = 0;
+    f32 windSample = 0;         // Wind noise at blade, written by cull compute each frame
     math::v2f uv = {};
-    f32 padding1[2];
+    u32 species = 0;            // Index into grassSpeciesDescs, picked by placement
+    u32 bakeCell = 0;           // CPU bake only, grid cell as y * bladesPerSide + x. Padding for shaders.
+};
+
+struct GrassDrawArgsBlock
+{
+    // Matches indexed indirect draw command layout
+    u32 indexCount = 0;
+    u32 instanceCount = 0;      // Visible blades
+    u32 firstIndex = 0;
+    i32 vertexOffset = 0;
+    u32 firstInstance = 0;      // Start of view and species region of visible index buffer
+    u32 padding0[3];
+};
+
+struct GrassDrawArgsResetConstantBlock
+{
+    u32 tileListOffset = 0;     // Tiles whose placed blades bound species ranges
+    u32 tileCount = 0;
+};
+
+struct GrassViewBlock
+{
+    math::m4f viewProj = {};
+    math::v3f position = {};
+    f32 padding0 = 0;
+};
+
+struct GrassViewsBlock
+{
+    GrassViewBlock views[maxGrassViews];
+    u32 viewCount = 0;
+    u32 padding0[3];
+};
+
+struct GrassView
+{
+    math::m4f view = {};
+    math::m4f proj = {};
+    math::v3f position = {};
+    Handle<render::RenderPass> hRenderPass;     // Pass the view's blades are drawn in
 };
 
 struct GrassConstantBlock
@@ -29,6 +155,9 @@ struct GrassConstantBlock
     math::m4f proj = {};
     f32 worldTime = 0;
     f32 deltaTime = 0;
+    u32 viewIndex = 0;
+    u32 debugMode = 0;          // GrassDebugMode
+    u32 tileListOffset = 0;     // Cull compute only, tile list its workgroups read
 };
 
 struct GrassUniformBlock
@@ -38,48 +167,207 @@ struct GrassUniformBlock
     //math::v2f windDirection = {1, 1};   // Wind direction and magnitude. Affects wind noise tiling and grass blade deformation.
     f32 windAngle = 0.f;        // Wind direction angle in radians.
     f32 windStrength = 1.f;     // How much leaves are affected by wind.
+    u32 bladesPerSide = 0;      // Placement grid side, computed on CPU so dispatch and shader agree.
+    u32 instanceCapacity = 0;   // Current instance buffer capacity in blades.
+    f32 farDistance = 120.f;    // Blades end here, terrain far field layer takes over.
+    f32 farFadeBand = 30.f;     // Blades thin out and shrink over this distance before farDistance.
+    f32 splatDistance = 0;      // Blades past this distance from main view are splatted by cull compute instead of drawn.
+    u32 targetWidth = 0;        // Main render target size, for splat buffer addressing.
+    u32 targetHeight = 0;
+    f32 bladeHeight = 1.f;      // Tallest species height, for cull bounds.
 };
 
+// Debug views for grass.frag, to see where shading cost goes at a given density
+enum GrassDebugMode
+{
+    GRASS_DEBUG_NONE,
+    GRASS_DEBUG_OVERDRAW,       // Additive heat per shaded fragment, drawn over a black clear
+    GRASS_DEBUG_TILE,           // Color per placement tile
+    GRASS_DEBUG_LOD,            // Far fade shrink factor, green at full size to red where blades end
+    GRASS_DEBUG_DENSITY,        // Blades per square unit at blade, blue (none) to red (10)
+    GRASS_DEBUG_ORDER,          // Position in tile's instance range, black (first) to white (last)
+    GRASS_DEBUG_SPECIES,        // Color per species
+    GRASS_DEBUG_COUNT,
+};
+inline const char* grassDebugModeNames[] = { "None", "Overdraw", "Tiles", "LOD", "Density", "Instance order", "Species" };
+inline i32 grassDebugMode = GRASS_DEBUG_NONE;
+
+// Blades whose projected height falls under grassSplatPixelSize are splatted into a 64-bit
+// depth|color buffer with atomics by cull compute, then resolved into main target
+// with depth test. Hardware raster wastes most of its work on triangles that small.
+// Needs 64-bit buffer atomics (shaderBufferInt64Atomics), available on CPU drivers such as lavapipe.
+// Splat buffer is a frame graph transient, it and the cull variant that writes it only exist while splatting is on.
+inline f32 grassSplatPixelSize = 2.f;       // 0 disables splatting
+
+// Main view blades can be drawn into a reduced resolution color and depth target, then
+// composited into main target by a depth aware upsample that is depth tested against terrain.
+// Fragment cost scales with the square of the resolution scale.
+inline const f32 grassResolutionScales[] = { 1.f, 0.75f, 0.5f, 0.25f };
+inline i32 grassResolutionLevel = 0;
+inline f32 grassUpsampleDepthSharpness = 20.f;   // Higher keeps blades at different depths from blending
+
 // Assets
-inline Handle<asset::Model> hAssetModelGrass;
+inline Handle<asset::Model> hAssetModelsGrassSpecies[grassSpeciesCount];
 inline Handle<asset::Shader> hAssetCsGrassPositions;
-inline Handle<asset::Shader> hAssetVsGrass;
-inline Handle<asset::Shader> hAssetPsGrass;
+inline Handle<asset::Shader> hAssetCsGrassDrawArgsReset;
+inline Handle<asset::Shader> hAssetVsGrassSplatResolve;
+inline Handle<asset::Shader> hAssetPsGrassSplatResolve;
+inline Handle<asset::Shader> hAssetPsGrassUpsample;
 inline Handle<asset::Image> hAssetWindNoise;
+inline Handle<asset::Image> hAssetGrassDensity;
 
 // Render resources
 inline Handle<render::Shader> hCsGrassPositions;
-inline Handle<render::Shader> hVsGrass;
-inline Handle<render::Shader> hPsGrass;
+inline Handle<render::Shader> hCsGrassDrawArgsReset;
+inline Handle<render::Shader> hVsGrassSplatResolve;
+inline Handle<render::Shader> hPsGrassSplatResolve;
+inline Handle<render::Shader> hPsGrassUpsample;
 inline Handle<render::Buffer> hVbGrass;
 inline Handle<render::Buffer> hIbGrass;
+inline GrassSpeciesMesh grassSpeciesMeshes[grassSpeciesCount];
+inline GrassSpeciesUniformBlock grassSpeciesUniforms;
+inline Handle<render::Buffer> hUbGrassSpecies;
 inline Handle<render::Buffer> hSbGrassInstanceData;
+inline u32 grassInstanceCapacity = 0;
+inline Handle<render::Buffer> hSbGrassDrawArgs;      // One entry per view and species, view major
+inline Handle<render::Buffer> hSbGrassVisible;       // Visible blade indices, instanceCapacity per view split by species
+inline Handle<render::Buffer> hSbGrassSplat;       // One packed depth|color u64 per main target pixel, owned by frame graph, invalid with splatting off
 inline GrassConstantBlock grassConstants;
 inline GrassUniformBlock grassUniforms;
+inline f32 grassDensityRequested = 0.5f;    // Density set in UI, frame time governor may scale it down
 inline Handle<render::Buffer> hUbGrass;
+inline GrassView grassViews[maxGrassViews];
+inline u32 grassViewCount = 1;
+inline GrassViewsBlock grassViewsUniforms;
+inline Handle<render::Buffer> hUbGrassViews;
+inline bool grassPositionsDirty = true;     // Placement reruns only when grid, terrain or streamed density changed
+inline bool grassPlacedFromBake = false;
+inline u32 grassPlacedBladesPerSide = 0;
+inline f32 grassPlacedTerrainSize = 0;
 inline Handle<render::Texture> hTexWindNoise;
 inline Handle<render::Buffer> hStagingTexWindNoise;
+// Tiles, CPU side lists are sized for grassTileListCapacity tiles, instance capacity divided by tile capacity
+inline GrassTileBounds grassTileBounds;
+inline u32 grassTileListCapacity = 0;
+inline u32 grassTileBoundsBladesPerSide = 0;    // Layout bounds were built for
+inline f32 grassTileBoundsTerrainSize = 0;
+inline f32 grassTileBoundsRadius = 0;
+inline u8* grassTilePlaced = NULL;          // Per tile, instances and count are written
+inline u32 grassTilePlaceCount = 0;         // Visible tiles placed this frame
+inline u32 grassTileVisibleCount = 0;       // Tiles visible from any view
+inline u32 grassTileViewVisibleCounts[maxGrassViews];
+inline u32 grassTilePlaceListOffset = 0;     // This frame's lists in tile lists buffer
+inline u32 grassTileVisibleListOffset = 0;
+inline Handle<render::Buffer> hSbGrassTileCounts;   // grassTileCountStride entries per tile
+// RENDER_CONCURRENT_FRAMES regions of place list then visible list, then a list of every tile for benchmarks
+inline Handle<render::Buffer> hSbGrassTileLists;
+inline Handle<render::Texture> hTexGrassDensity;     // Authored placement mask, R channel is blade survival probability. Placement streams it as a tiled map.
+
+// Grass draw args reset compute
+inline Handle<render::ResourceSetLayout> hResourceLayoutGrassDrawArgsReset;
+inline Handle<render::ResourceSet> hResourceSetGrassDrawArgsReset;
+inline Handle<render::ComputePipeline> hComputePipelineGrassDrawArgsReset;
 
 // Grass position compute
 inline Handle<render::ResourceSetLayout> hResourceLayoutGrassPositions;
 inline Handle<render::ResourceSet> hResourceSetGrassPositions;
 inline Handle<render::ComputePipeline> hComputePipelineGrassPositions;
 
+// Grass cull compute. Splat variant has the splat buffer as an extra last binding.
+inline Handle<render::ResourceSetLayout> hResourceLayoutGrassCull;
+inline Handle<render::ResourceSetLayout> hResourceLayoutGrassCullSplat;
+inline Handle<render::ResourceSet> hResourceSetGrassCull;
+inline Handle<render::ResourceSet> hResourceSetGrassCullSplat;   // Only while splat has a buffer
+inline Handle<render::ComputePipeline> hComputePipelineGrassCull;
+inline Handle<render::ComputePipeline> hComputePipelineGrassCullSplat;
+const u32 grassCullFeatures = SHADER_FEATURE_SPLAT;     // Supported by grass_cull.comp
+
 // Grass render pass
 inline Handle<render::VertexLayout> hVertexLayoutGrassRender;
 inline Handle<render::RenderPass> hRenderPassGrassRender;
 inline Handle<render::ResourceSetLayout> hResourceLayoutGrassRender;
 inline Handle<render::ResourceSet> hResourceSetGrassRender;
-inline Handle<render::GraphicsPipeline> hGraphicsPipelineGrassRender;
+// Indexed by shader feature mask, created on first use
+inline Handle<render::GraphicsPipeline> hGraphicsPipelinesGrassRender[SHADER_FEATURE_MASK_COUNT];
+inline Handle<render::GraphicsPipeline> hGraphicsPipelinesGrassOverdraw[SHADER_FEATURE_MASK_COUNT];   // Additive blend, for GRASS_DEBUG_OVERDRAW
+const u32 grassRenderFeatures = SHADER_FEATURE_WIND | SHADER_FEATURE_DEBUG_VIEW;     // Supported by grass.vert/.frag
+
+// Grass splat resolve pass
+inline Handle<render::ResourceSetLayout> hResourceLayoutGrassSplatResolve;
+inline Handle<render::ResourceSet> hResourceSetGrassSplatResolve;
+inline Handle<render::GraphicsPipeline> hGraphicsPipelineGrassSplatResolve;
+
+// Reduced resolution grass target and upsample pass
+struct GrassUpsampleConstantBlock
+{
+    math::v2f targetSize = {};
+    math::v2f lowResSize = {};
+    f32 depthSharpness = 0;
+};
+inline Handle<render::RenderTarget> hRenderTargetGrassLowRes;
+inline Handle<render::RenderPass> hRenderPassGrassLowRes;
+inline u32 grassLowResWidth = 0;
+inline u32 grassLowResHeight = 0;
+inline bool grassLowResFresh = false;       // Target was just made, no previous frame use to synchronize with
+inline Handle<render::ResourceSetLayout> hResourceLayoutGrassUpsample;
+inline Handle<render::ResourceSet> hResourceSetGrassUpsample;
+inline Handle<render::GraphicsPipeline> hGraphicsPipelineGrassUpsample;
 
 void InitGrass(Handle<render::RenderTarget> hRenderTarget);
 void ShutdownGrass();
+void SetGrassRenderTarget(Handle<render::RenderTarget> hRenderTarget);
+// Makes or drops reduced resolution target to match resolution level and main target size
+void UpdateGrassLowResTarget();
+bool IsGrassLowRes();
 
+void MakeGrassPositionsPipeline();
+void MakeGrassCullPipeline();
+Handle<render::ComputePipeline> MakeGrassCullVariantPipeline(u32 features);
 void InitGrassPositions();
+void MakeGrassResourceSets();
+void MakeGrassCullResourceSets();
+// Tile counts and lists, sized from instance capacity
+void MakeGrassTileBuffers();
+u32 GetGrassBladesPerSide();
+void UpdateGrassInstanceCapacity();
 void UpdateGrassConstants();
 void UpdateGrassUniforms();
+// Returns new view index, main view is always grassMainView
+u32 AddGrassView(Handle<render::RenderPass> hRenderPass);
+void SetGrassView(u32 viewIndex, math::m4f view, math::m4f proj, math::v3f position);
+void UpdateGrassViews();
+u32 GetGrassTilesPerSide();
+// Index of a tile's cell within tile's instance order, before compaction
+u32 GetGrassTileOrderIndex(u32 cellX, u32 cellY);
+// Marks every tile of current grid placed or not placed
+void ResetGrassTiles(bool placed);
+struct StreamedMap;
+// Tiles with blades reading texels of map pages that changed this frame are placed again when visible
+void InvalidateGrassTilesOverMapPages(const StreamedMap* map);
+// After views are set. Culls tiles and uploads this frame's place and visible tile lists.
+void UpdateGrassTiles();
+// Splits each view's visible list range between species, bounded by placed blades of listed tiles
+void ResetGrassDrawArgs(Handle<render::CommandBuffer> hCmd, u32 listOffset, u32 tileCount);
+// Draw args for tiles on this frame's visible list, before cull
+void ResetVisibleGrassDrawArgs(Handle<render::CommandBuffer> hCmd);
+// Places tiles on this frame's place list
 void PopulateGrassPositions(Handle<render::CommandBuffer> hCmd);
-void RenderGrassInstances(Handle<render::CommandBuffer> hCmd);
+// Culls blades of tiles on this frame's visible list
+void CullGrassInstances(Handle<render::CommandBuffer> hCmd);
+// Every tile of current grid, for autotuning and benchmarks
+void PlaceAllGrassTiles(Handle<render::CommandBuffer> hCmd);
+void CullAllGrassTiles(Handle<render::CommandBuffer> hCmd);
+// Shader features current settings need, e.g. wind is compiled out at zero strength
+u32 GetGrassRenderFeatures();
+Handle<render::GraphicsPipeline> GetGrassRenderPipeline(u32 features, bool overdraw);
+void RenderGrassInstances(Handle<render::CommandBuffer> hCmd, u32 viewIndex = grassMainView);
+bool IsGrassSplatEnabled();
+u64 GetGrassSplatSize();
+// Frame graph's buffer for splat this frame, invalid with splatting off. Remakes splat sets when it changes.
+void SetGrassSplatBuffer(Handle<render::Buffer> hBuffer);
+void ClearGrassSplat(Handle<render::CommandBuffer> hCmd);
+void ResolveGrassSplat(Handle<render::CommandBuffer> hCmd);
+void UpsampleGrass(Handle<render::CommandBuffer> hCmd);
 
 };  // namespace Grass
 };  // namespace ty
@@ -0,0 +1,431 @@
+#include "app/grass_bake.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/file.hpp"
+#include "engine/src/render/render.hpp"
+
+#include "app/state.hpp"
+#include "app/frame_memory.hpp"
+#include "app/map_stream.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace ty
+{
+namespace Grass
+{
+
+// Same hash as grass_positions.comp
+inline u32 GrassHash(u32 x)
+{
+    u32 state = x * 747796405u + 2891336453u;
+    u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+inline f32 GrassRandomFromHash(u32 h)
+{
+    return (f32)(h >> 8u) * (1.f / 16777216.f);
+}
+
+GrassDensityMap MakeGrassDensityMap(Handle<asset::Image> hAsset)
+{
+    ASSERT(hAsset.IsValid());
+    asset::Image& asset = asset::images[hAsset];
+    GrassDensityMap result = {};
+    result.data = asset.data;
+    result.width = asset.width;
+    result.height = asset.height;
+    result.channels = asset.channels;
+    return result;
+}
+
+inline f32 SampleGrassDensity(GrassDensityMap& densityMap, f32 u, f32 v)
+{
+    // Matches texelFetch at ivec2(uv * size), clamped to last texel
+    i32 x = MIN((i32)(u * (f32)densityMap.width), densityMap.width - 1);
+    i32 y = MIN((i32)(v * (f32)densityMap.height), densityMap.height - 1);
+    u8 texel = densityMap.data[(y * densityMap.width + x) * densityMap.channels];
+    return (f32)texel / 255.f;
+}
+
+#if defined(__AVX2__)
+#define GRASS_BAKE_LANES 8
+typedef __m256i GrassLaneU32;
+typedef __m256 GrassLaneF32;
+
+inline GrassLaneU32 GrassHashLanes(GrassLaneU32 x)
+{
+    GrassLaneU32 state = _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32((i32)747796405u)),
+            _mm256_set1_epi32((i32)2891336453u));
+    GrassLaneU32 shift = _mm256_add_epi32(_mm256_srli_epi32(state, 28), _mm256_set1_epi32(4));
+    GrassLaneU32 word = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srlv_epi32(state, shift), state),
+            _mm256_set1_epi32((i32)277803737u));
+    return _mm256_xor_si256(_mm256_srli_epi32(word, 22), word);
+}
+
+inline GrassLaneU32 GrassLaneIndices(u32 start)
+{
+    return _mm256_add_epi32(_mm256_set1_epi32((i32)start), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+inline GrassLaneU32 GrassLaneXor(GrassLaneU32 a, u32 b) { return _mm256_xor_si256(a, _mm256_set1_epi32((i32)b)); }
+inline GrassLaneF32 GrassLaneRandom(GrassLaneU32 h)
+{
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(1.f / 16777216.f));
+}
+inline GrassLaneF32 GrassLaneToF32(GrassLaneU32 a) { return _mm256_cvtepi32_ps(a); }
+inline GrassLaneF32 GrassLaneSet(f32 a) { return _mm256_set1_ps(a); }
+inline GrassLaneF32 GrassLaneAdd(GrassLaneF32 a, GrassLaneF32 b) { return _mm256_add_ps(a, b); }
+inline GrassLaneF32 GrassLaneDiv(GrassLaneF32 a, GrassLaneF32 b) { return _mm256_div_ps(a, b); }
+inline void GrassLaneStore(f32* dst, GrassLaneF32 a) { _mm256_storeu_ps(dst, a); }
+
+#elif defined(__SSE4_1__)
+#define GRASS_BAKE_LANES 4
+typedef __m128i GrassLaneU32;
+typedef __m128 GrassLaneF32;
+
+inline GrassLaneU32 GrassSrlvLanes(GrassLaneU32 x, GrassLaneU32 s)
+{
+    // No per-lane shift before AVX2. x >> s == mulhi(x, 2^(32 - s)),
+    // with 2^(32 - s) built from float exponent bits (s is in [4, 19] here)
+    GrassLaneU32 exponent = _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(127 + 32), s), 23);
+    GrassLaneU32 factor = _mm_cvttps_epi32(_mm_castsi128_ps(exponent));
+    GrassLaneU32 productEven = _mm_mul_epu32(x, factor);
+    GrassLaneU32 productOdd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(factor, 32));
+    return _mm_or_si128(_mm_srli_epi64(productEven, 32),
+            _mm_and_si128(productOdd, _mm_set_epi32(-1, 0, -1, 0)));
+}
+
+inline GrassLaneU32 GrassHashLanes(GrassLaneU32 x)
+{
+    GrassLaneU32 state = _mm_add_epi32(_mm_mullo_epi32(x, _mm_set1_epi32((i32)747796405u)),
+            _mm_set1_epi32((i32)2891336453u));
+    GrassLaneU32 shift = _mm_add_epi32(_mm_srli_epi32(state, 28), _mm_set1_epi32(4));
+    GrassLaneU32 word = _mm_mullo_epi32(_mm_xor_si128(GrassSrlvLanes(state, shift), state),
+            _mm_set1_epi32((i32)277803737u));
+    return _mm_xor_si128(_mm_srli_epi32(word, 22), word);
+}
+
+inline GrassLaneU32 GrassLaneIndices(u32 start)
+{
+    return _mm_add_epi32(_mm_set1_epi32((i32)start), _mm_setr_epi32(0, 1, 2, 3));
+}
+inline GrassLaneU32 GrassLaneXor(GrassLaneU32 a, u32 b) { return _mm_xor_si128(a, _mm_set1_epi32((i32)b)); }
+inline GrassLaneF32 GrassLaneRandom(GrassLaneU32 h)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.f / 16777216.f));
+}
+inline GrassLaneF32 GrassLaneToF32(GrassLaneU32 a) { return _mm_cvtepi32_ps(a); }
+inline GrassLaneF32 GrassLaneSet(f32 a) { return _mm_set1_ps(a); }
+inline GrassLaneF32 GrassLaneAdd(GrassLaneF32 a, GrassLaneF32 b) { return _mm_add_ps(a, b); }
+inline GrassLaneF32 GrassLaneDiv(GrassLaneF32 a, GrassLaneF32 b) { return _mm_div_ps(a, b); }
+inline void GrassLaneStore(f32* dst, GrassLaneF32 a) { _mm_storeu_ps(dst, a); }
+#endif
+
+// Places blades for grid rows [rowStart, rowEnd), writing compacted blades to output.
+// Returns blade count written.
+static u32 BakeGrassRows(GrassInstanceDataBlock* output,
+        u32 rowStart, u32 rowEnd,
+        u32 bladesPerSide, f32 terrainSize,
+        GrassDensityMap densityMap)
+{
+    u32 count = 0;
+    f32 bladesPerSideF = (f32)bladesPerSide;
+    for(u32 gridX = rowStart; gridX < rowEnd; gridX++)
+    {
+        u32 rowHash = GrassHash(gridX);
+        u32 gridY = 0;
+#if defined(GRASS_BAKE_LANES)
+        // Hashes and blade uvs for GRASS_BAKE_LANES cells at a time,
+        // density test and compaction are scalar since they branch per blade
+        f32 laneU[GRASS_BAKE_LANES];
+        f32 laneV[GRASS_BAKE_LANES];
+        f32 laneSurvival[GRASS_BAKE_LANES];
+        GrassLaneF32 cellX = GrassLaneSet((f32)gridX);
+        GrassLaneF32 divisor = GrassLaneSet(bladesPerSideF);
+        for(; gridY + GRASS_BAKE_LANES <= bladesPerSide; gridY += GRASS_BAKE_LANES)
+        {
+            GrassLaneU32 cellY = GrassLaneIndices(gridY);
+            GrassLaneU32 cellHash = GrassHashLanes(GrassLaneXor(cellY, rowHash));
+            GrassLaneF32 jitterX = GrassLaneRandom(GrassHashLanes(GrassLaneXor(cellHash, 0)));
+            GrassLaneF32 jitterY = GrassLaneRandom(GrassHashLanes(GrassLaneXor(cellHash, 1)));
+            GrassLaneF32 survival = GrassLaneRandom(GrassHashLanes(GrassLaneXor(cellHash, 2)));
+            GrassLaneStore(laneU, GrassLaneDiv(GrassLaneAdd(cellX, jitterX), divisor));
+            GrassLaneStore(laneV, GrassLaneDiv(GrassLaneAdd(GrassLaneToF32(cellY), jitterY), divisor));
+            GrassLaneStore(laneSurvival, survival);
+
+            for(i32 lane = 0; lane < GRASS_BAKE_LANES; lane++)
+            {
+                if(laneSurvival[lane] >= SampleGrassDensity(densityMap, laneU[lane], laneV[lane])) continue;
+                GrassInstanceDataBlock& blade = output[count++];
+                blade = {};
+                blade.position = {laneU[lane] * terrainSize, 0, laneV[lane] * terrainSize};
+                blade.uv = {laneU[lane], laneV[lane]};
+                blade.bakeCell = (gridY + lane) * bladesPerSide + gridX;
+            }
+        }
+#endif
+        // Remainder (or everything, without SIMD)
+        for(; gridY < bladesPerSide; gridY++)
+        {
+            u32 cellHash = GrassHash(rowHash ^ gridY);
+            f32 u = ((f32)gridX + GrassRandomFromHash(GrassHash(cellHash ^ 0))) / bladesPerSideF;
+            f32 v = ((f32)gridY + GrassRandomFromHash(GrassHash(cellHash ^ 1))) / bladesPerSideF;
+            f32 survival = GrassRandomFromHash(GrassHash(cellHash ^ 2));
+            if(survival >= SampleGrassDensity(densityMap, u, v)) continue;
+            GrassInstanceDataBlock& blade = output[count++];
+            blade = {};
+            blade.position = {u * terrainSize, 0, v * terrainSize};
+            blade.uv = {u, v};
+            blade.bakeCell = gridY * bladesPerSide + gridX;
+        }
+    }
+    return count;
+}
+
+u32 BakeGrassPositionsCPU(GrassInstanceDataBlock* output, u32 bladesPerSide, f32 terrainSize, GrassDensityMap densityMap, i32 threadCount)
+{
+    ASSERT(output);
+    ASSERT(densityMap.data);
+    if(bladesPerSide == 0) return 0;
+    // Cell index is stored in 32 bits
+    ASSERT((u64)bladesPerSide * bladesPerSide <= 0xFFFFFFFFull);
+
+    if(threadCount <= 0) threadCount = (i32)MAX(1u, std::thread::hardware_concurrency());
+    threadCount = MIN((u32)threadCount, bladesPerSide);
+
+    // Each thread bakes a band of rows into the output region that band would use
+    // with no blades discarded, then bands are compacted in order.
+    const i32 maxBakeThreads = 64;
+    threadCount = MIN(threadCount, maxBakeThreads);
+    u32 bandCounts[maxBakeThreads] = {};
+    u32 bandStarts[maxBakeThreads] = {};
+    std::thread threads[maxBakeThreads];
+    u32 rowsPerBand = (bladesPerSide + threadCount - 1) / threadCount;
+    for(i32 i = 0; i < threadCount; i++)
+    {
+        u32 rowStart = MIN(i * rowsPerBand, bladesPerSide);
+        u32 rowEnd = MIN(rowStart + rowsPerBand, bladesPerSide);
+        bandStarts[i] = rowStart;
+        threads[i] = std::thread([=, &bandCounts]()
+        {
+            bandCounts[i] = BakeGrassRows(output + (u64)rowStart * bladesPerSide,
+                    rowStart, rowEnd,
+                    bladesPerSide, terrainSize,
+                    densityMap);
+        });
+    }
+    for(i32 i = 0; i < threadCount; i++)
+    {
+        threads[i].join();
+    }
+
+    u32 count = 0;
+    for(i32 i = 0; i < threadCount; i++)
+    {
+        GrassInstanceDataBlock* band = output + (u64)bandStarts[i] * bladesPerSide;
+        if(band != output + count)
+        {
+            memmove(output + count, band, bandCounts[i] * sizeof(GrassInstanceDataBlock));
+        }
+        count += bandCounts[i];
+    }
+    return count;
+}
+
+bool WriteGrassBakeFile(const char* path, GrassBakeHeader header, GrassInstanceDataBlock* instances)
+{
+    // Bakes are build output, directory isn't checked in
+    CreateDirectoryA(GRASS_BAKE_DIRECTORY, NULL);
+    FILE* file = fopen(path, "wb");
+    if(!file)
+    {
+        LOGF("Failed to open grass bake file for writing: %s\n", path);
+        return false;
+    }
+    bool result = fwrite(&header, sizeof(GrassBakeHeader), 1, file) == 1;
+    if(header.instanceCount > 0)
+    {
+        result = result && fwrite(instances, sizeof(GrassInstanceDataBlock), header.instanceCount, file) == header.instanceCount;
+    }
+    fclose(file);
+    if(!result) LOGF("Failed to write grass bake file: %s\n", path);
+    return result;
+}
+
+bool MapGrassBakeFile(const char* path, GrassBakeFile* result)
+{
+    ASSERT(result);
+    *result = {};
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize = {};
+    if(!GetFileSizeEx(fileHandle, &fileSize) || (u64)fileSize.QuadPart < sizeof(GrassBakeHeader))
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mappingHandle)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    u8* view = (u8*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    result->fileHandle = fileHandle;
+    result->mappingHandle = mappingHandle;
+    result->view = view;
+    result->header = (GrassBakeHeader*)view;
+    result->instances = (GrassInstanceDataBlock*)(view + sizeof(GrassBakeHeader));
+
+    GrassBakeHeader& header = *result->header;
+    u64 expectedSize = sizeof(GrassBakeHeader) + (u64)header.instanceCount * sizeof(GrassInstanceDataBlock);
+    if(header.magic != grassBakeMagic
+            || header.version != grassBakeVersion
+            || (u64)fileSize.QuadPart < expectedSize)
+    {
+        LOGF("Invalid grass bake file: %s\n", path);
+        UnmapGrassBakeFile(result);
+        return false;
+    }
+    return true;
+}
+
+void UnmapGrassBakeFile(GrassBakeFile* file)
+{
+    ASSERT(file);
+    if(file->view) UnmapViewOfFile(file->view);
+    if(file->mappingHandle) CloseHandle(file->mappingHandle);
+    if(file->fileHandle) CloseHandle(file->fileHandle);
+    *file = {};
+}
+
+bool BakeDefaultGrassFile()
+{
+    asset::Init();
+    Handle<asset::Image> hAssetDensity = asset::LoadImageFile(file::MakePath(IStr(IMAGE_PATH"grass_density.png")));
+    GrassDensityMap densityMap = MakeGrassDensityMap(hAssetDensity);
+
+    GrassUniformBlock defaults = {};
+    u32 grassInstanceCount = (u32)(defaults.grassDensity * defaults.terrainSize * defaults.terrainSize);
+    u32 bladesPerSide = (u32)sqrt((f64)grassInstanceCount);
+    GrassInstanceDataBlock* instances = (GrassInstanceDataBlock*)AppHeapAlloc((u64)bladesPerSide * bladesPerSide * sizeof(GrassInstanceDataBlock));
+
+    GrassBakeHeader header = {};
+    header.bladesPerSide = bladesPerSide;
+    header.terrainSize = defaults.terrainSize;
+    header.grassDensity = defaults.grassDensity;
+    header.instanceCount = BakeGrassPositionsCPU(instances, bladesPerSide, defaults.terrainSize, densityMap);
+    bool result = WriteGrassBakeFile(GRASS_BAKE_PATH, header, instances);
+    LOGF("Baked %u grass blades to %s\n", header.instanceCount, GRASS_BAKE_PATH);
+
+    AppHeapFree(instances);
+    return result;
+}
+
+// Slot of blade's cell in instance buffer, tile's range then position in tile's instance order.
+// Cell comes from the bake, uv * bladesPerSide may round a blade jittered close to a cell edge into its neighbour.
+u64 GetGrassBakeSlot(const GrassInstanceDataBlock& instance, u32 bladesPerSide, u32 tilesPerSide)
+{
+    ASSERT(instance.bakeCell < bladesPerSide * bladesPerSide);
+    u32 cellX = instance.bakeCell % bladesPerSide;
+    u32 cellY = instance.bakeCell / bladesPerSide;
+    u32 tile = (cellY / grassTileBladesPerSide) * tilesPerSide + cellX / grassTileBladesPerSide;
+    return (u64)tile * grassTileBladeCapacity
+        + GetGrassTileOrderIndex(cellX % grassTileBladesPerSide, cellY % grassTileBladesPerSide);
+}
+
+// Same selection as grass_positions.comp, from finest mip of species map
+u32 GetGrassBakeSpecies(const GrassInstanceDataBlock& instance, u32 bladesPerSide)
+{
+    const TiledMapHeader& header = *streamedGrassSpecies.header;
+    u32 texelX = MIN((u32)(instance.uv.x * header.width), header.width - 1);
+    u32 texelY = MIN((u32)(instance.uv.y * header.height), header.height - 1);
+    u32 cellX = instance.bakeCell % bladesPerSide;
+    u32 cellY = instance.bakeCell / bladesPerSide;
+    u32 cellHash = GrassHash(GrassHash(cellX) ^ cellY);
+    f32 selector = ReadTiledMapTexel(&streamedGrassSpecies, texelX, texelY) / 255.f
+        + (GrassRandomFromHash(GrassHash(cellHash ^ 4)) - 0.5f) * grassSpeciesBlend;
+    selector = MIN(MAX(selector, 0.f), 1.f);
+    return MIN((u32)(selector * grassSpeciesCount), grassSpeciesCount - 1);
+}
+
+void UploadGrassBake(GrassBakeFile* file)
+{
+    ASSERT(file && file->header);
+    GrassBakeHeader& header = *file->header;
+
+    // Match settings the bake was made with, so capacity covers baked blade count
+    grassUniforms.terrainSize = header.terrainSize;
+    grassUniforms.grassDensity = header.grassDensity;
+    grassDensityRequested = header.grassDensity;
+    grassUniforms.bladesPerSide = header.bladesPerSide;
+    UpdateGrassInstanceCapacity();
+    u32 tilesPerSide = GetGrassTilesPerSide();
+    u32 tileCount = tilesPerSide * tilesPerSide;
+    ASSERT(tileCount * grassTileBladeCapacity <= grassInstanceCapacity);
+
+    // Bake is compacted over the whole grid. Blades are counting sorted by their cell's slot in its
+    // tile's range, so each tile ends up compacted in instance order like placement compute.
+    u64 slotCount = (u64)tileCount * grassTileBladeCapacity;
+    u32* slotFirst = (u32*)AppHeapAlloc((slotCount + 1) * sizeof(u32));
+    memset(slotFirst, 0, (slotCount + 1) * sizeof(u32));
+    u32* tileCounts = (u32*)AppHeapAlloc(tileCount * grassTileCountStride * sizeof(u32));
+    u32* tileFirst = (u32*)AppHeapAlloc(tileCount * sizeof(u32));
+    memset(tileCounts, 0, tileCount * grassTileCountStride * sizeof(u32));
+    for(u32 i = 0; i < header.instanceCount; i++)
+    {
+        u64 slot = GetGrassBakeSlot(file->instances[i], header.bladesPerSide, tilesPerSide);
+        slotFirst[slot + 1]++;
+        tileCounts[(slot / grassTileBladeCapacity) * grassTileCountStride]++;
+    }
+    for(u64 slot = 0; slot < slotCount; slot++)
+    {
+        slotFirst[slot + 1] += slotFirst[slot];
+    }
+    for(u32 tile = 0; tile < tileCount; tile++)
+    {
+        ASSERT(tileCounts[tile * grassTileCountStride] <= grassTileBladeCapacity);
+        tileFirst[tile] = slotFirst[(u64)tile * grassTileBladeCapacity];
+    }
+    GrassInstanceDataBlock* tileInstances = (GrassInstanceDataBlock*)AppHeapAlloc(slotCount * sizeof(GrassInstanceDataBlock));
+    for(u32 i = 0; i < header.instanceCount; i++)
+    {
+        u64 slot = GetGrassBakeSlot(file->instances[i], header.bladesPerSide, tilesPerSide);
+        u32 tile = (u32)(slot / grassTileBladeCapacity);
+        // Species isn't baked, it follows the species map like placement compute
+        GrassInstanceDataBlock& instance = tileInstances[(u64)tile * grassTileBladeCapacity + (slotFirst[slot]++ - tileFirst[tile])];
+        instance = file->instances[i];
+        instance.species = GetGrassBakeSpecies(instance, header.bladesPerSide);
+        tileCounts[tile * grassTileCountStride + 1 + instance.species]++;
+    }
+    render::CopyMemoryToBuffer(hSbGrassInstanceData, 0,
+            (u64)tileCount * grassTileBladeCapacity * sizeof(GrassInstanceDataBlock),
+            tileInstances);
+    render::CopyMemoryToBuffer(hSbGrassTileCounts, 0, tileCount * grassTileCountStride * sizeof(u32), tileCounts);
+    AppHeapFree(tileInstances);
+    AppHeapFree(slotFirst);
+    AppHeapFree(tileCounts);
+    AppHeapFree(tileFirst);
+    ResetGrassTiles(true);
+
+    grassPositionsDirty = false;
+    grassPlacedFromBake = true;
+    grassPlacedBladesPerSide = header.bladesPerSide;
+    grassPlacedTerrainSize = header.terrainSize;
+}
+
+};  // namespace Grass
+};  // namespace ty
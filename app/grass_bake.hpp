@@ -0,0 +1,79 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/asset/asset.hpp"
+
+#include "app/grass.hpp"
+
+// CPU implementation of grass_positions.comp, for offline bakes and GPU-less validation.
+// Vectorized with AVX2 when compiled with -mavx2, SSE4.1 otherwise, scalar as fallback.
+//
+// Tolerance against GPU output:
+// - Blade positions match within 1e-3 units (GPU float division may be off by a few ULP).
+// - Density mask is read as unorm on both sides, so a blade whose survival random falls within float
+//   rounding of its texel density may differ. Texels at exactly 0 or 1 always match.
+// - GPU placement reads streamed density tiles, it only matches where finest mip tiles were resident.
+// - GPU output is grouped by placement tile and ordered by grassInstanceOrder within tiles, CPU
+//   output is row major over the whole grid. UploadGrassBake reorders it the same way, so compare
+//   uploaded instances element by element, or raw bakes as sets.
+// - Species aren't baked. UploadGrassBake picks them from the species map's finest mip like placement
+//   compute, so a blade whose selector lands within float rounding of a species boundary may differ.
+
+#define GRASS_BAKE_DIRECTORY "resources/bakes"
+#define GRASS_BAKE_PATH GRASS_BAKE_DIRECTORY"/grass_positions.bake"
+
+namespace ty
+{
+namespace Grass
+{
+
+const u32 grassBakeMagic = 0x42535247;     // "GRSB"
+const u32 grassBakeVersion = 2;     // 2: blades store their grid cell
+
+struct GrassBakeHeader
+{
+    u32 magic = grassBakeMagic;
+    u32 version = grassBakeVersion;
+    u32 instanceCount = 0;
+    u32 bladesPerSide = 0;
+    f32 terrainSize = 0;
+    f32 grassDensity = 0;
+    u32 padding0[2];
+};
+// Instance data follows header directly in file
+static_assert(sizeof(GrassBakeHeader) == 32);
+
+struct GrassDensityMap
+{
+    u8* data = NULL;
+    i32 width = 0;
+    i32 height = 0;
+    i32 channels = 0;
+};
+
+struct GrassBakeFile
+{
+    void* fileHandle = NULL;
+    void* mappingHandle = NULL;
+    u8* view = NULL;
+    GrassBakeHeader* header = NULL;
+    GrassInstanceDataBlock* instances = NULL;   // Points into mapped view
+};
+
+GrassDensityMap MakeGrassDensityMap(Handle<asset::Image> hAsset);
+
+// Writes compacted blades to output, which must hold bladesPerSide * bladesPerSide blades.
+// Returns surviving blade count.
+u32 BakeGrassPositionsCPU(GrassInstanceDataBlock* output, u32 bladesPerSide, f32 terrainSize, GrassDensityMap densityMap, i32 threadCount = 0);
+
+bool WriteGrassBakeFile(const char* path, GrassBakeHeader header, GrassInstanceDataBlock* instances);
+bool MapGrassBakeFile(const char* path, GrassBakeFile* result);
+void UnmapGrassBakeFile(GrassBakeFile* file);
+
+// Offline entry point, bakes default grass settings to GRASS_BAKE_PATH without initializing rendering
+bool BakeDefaultGrassFile();
+// Uploads mapped blades into their tiles' instance ranges and marks every tile placed, placement compute
+// is skipped until grid changes
+void UploadGrassBake(GrassBakeFile* file);
+
+};  // namespace Grass
+};  // namespace ty
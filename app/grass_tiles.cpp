@@ -0,0 +1,223 @@
+#include "app/grass_tiles.hpp"
+#include "engine/src/core/debug.hpp"
+
+#include "app/frame_memory.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace ty
+{
+namespace Grass
+{
+
+void ResizeGrassTileBounds(GrassTileBounds* bounds, u32 count)
+{
+    ASSERT(bounds);
+    u32 capacity = (count + 7) & ~7u;
+    if(capacity > bounds->capacity)
+    {
+        DestroyGrassTileBounds(bounds);
+        f32** arrays[] = { &bounds->minX, &bounds->minY, &bounds->minZ, &bounds->maxX, &bounds->maxY, &bounds->maxZ };
+        for(i32 i = 0; i < (i32)ARR_LEN(arrays); i++)
+        {
+            // Padding lanes are masked out, zeroed so they never hold NaNs
+            *arrays[i] = (f32*)AppHeapAlloc(capacity * sizeof(f32));
+            memset(*arrays[i], 0, capacity * sizeof(f32));
+        }
+        bounds->capacity = capacity;
+    }
+    bounds->count = count;
+}
+
+void DestroyGrassTileBounds(GrassTileBounds* bounds)
+{
+    ASSERT(bounds);
+    AppHeapFree(bounds->minX);
+    AppHeapFree(bounds->minY);
+    AppHeapFree(bounds->minZ);
+    AppHeapFree(bounds->maxX);
+    AppHeapFree(bounds->maxY);
+    AppHeapFree(bounds->maxZ);
+    *bounds = {};
+}
+
+GrassFrustum MakeGrassFrustum(math::m4f viewProj, math::v3f position, f32 maxDistance)
+{
+    // Clip position is viewProj * v, so planes are sums of matrix rows
+    f32 rows[4][4];
+    for(i32 i = 0; i < 4; i++)
+    {
+        for(i32 j = 0; j < 4; j++)
+        {
+            rows[i][j] = viewProj.m[i * 4 + j];
+        }
+    }
+    GrassFrustum result = {};
+    for(i32 j = 0; j < 4; j++)
+    {
+        result.planes[0][j] = rows[3][j] + rows[0][j];
+        result.planes[1][j] = rows[3][j] - rows[0][j];
+        result.planes[2][j] = rows[3][j] + rows[1][j];
+        result.planes[3][j] = rows[3][j] - rows[1][j];
+        result.planes[4][j] = rows[2][j];
+        result.planes[5][j] = rows[3][j] - rows[2][j];
+    }
+    result.position = position;
+    result.maxDistanceSq = maxDistance * maxDistance;
+    return result;
+}
+
+inline bool IsGrassTileVisible(const GrassTileBounds& bounds, u32 i, const GrassFrustum& frustum)
+{
+    for(i32 p = 0; p < 6; p++)
+    {
+        // Corner furthest along plane normal decides, per axis that is whichever of min and max projects higher
+        const f32* plane = frustum.planes[p];
+        f32 distance = MAX(plane[0] * bounds.minX[i], plane[0] * bounds.maxX[i])
+            + MAX(plane[1] * bounds.minY[i], plane[1] * bounds.maxY[i])
+            + MAX(plane[2] * bounds.minZ[i], plane[2] * bounds.maxZ[i])
+            + plane[3];
+        if(distance < 0) return false;
+    }
+    f32 dx = MAX(MAX(bounds.minX[i] - frustum.position.x, frustum.position.x - bounds.maxX[i]), 0.f);
+    f32 dy = MAX(MAX(bounds.minY[i] - frustum.position.y, frustum.position.y - bounds.maxY[i]), 0.f);
+    f32 dz = MAX(MAX(bounds.minZ[i] - frustum.position.z, frustum.position.z - bounds.maxZ[i]), 0.f);
+    return dx * dx + dy * dy + dz * dz <= frustum.maxDistanceSq;
+}
+
+u32 CullGrassTilesScalar(const GrassTileBounds& bounds, const GrassFrustum* frusta, u32 frustumCount,
+        u32* visibleTiles, u32* frustumVisibleCounts)
+{
+    for(u32 f = 0; f < frustumCount; f++) frustumVisibleCounts[f] = 0;
+    u32 visibleCount = 0;
+    for(u32 i = 0; i < bounds.count; i++)
+    {
+        bool visible = false;
+        for(u32 f = 0; f < frustumCount; f++)
+        {
+            if(!IsGrassTileVisible(bounds, i, frusta[f])) continue;
+            frustumVisibleCounts[f]++;
+            visible = true;
+        }
+        if(visible) visibleTiles[visibleCount++] = i;
+    }
+    return visibleCount;
+}
+
+#if defined(__AVX2__)
+#define GRASS_TILE_LANES 8
+
+// Bit per lane, set when tile is inside frustum
+inline u32 CullGrassTileLanes(const GrassTileBounds& bounds, u32 i, const GrassFrustum& frustum)
+{
+    __m256 minX = _mm256_loadu_ps(bounds.minX + i);
+    __m256 minY = _mm256_loadu_ps(bounds.minY + i);
+    __m256 minZ = _mm256_loadu_ps(bounds.minZ + i);
+    __m256 maxX = _mm256_loadu_ps(bounds.maxX + i);
+    __m256 maxY = _mm256_loadu_ps(bounds.maxY + i);
+    __m256 maxZ = _mm256_loadu_ps(bounds.maxZ + i);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for(i32 p = 0; p < 6; p++)
+    {
+        const f32* plane = frustum.planes[p];
+        __m256 a = _mm256_set1_ps(plane[0]);
+        __m256 b = _mm256_set1_ps(plane[1]);
+        __m256 c = _mm256_set1_ps(plane[2]);
+        __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_max_ps(_mm256_mul_ps(a, minX), _mm256_mul_ps(a, maxX)),
+                    _mm256_max_ps(_mm256_mul_ps(b, minY), _mm256_mul_ps(b, maxY))),
+                _mm256_add_ps(
+                    _mm256_max_ps(_mm256_mul_ps(c, minZ), _mm256_mul_ps(c, maxZ)),
+                    _mm256_set1_ps(plane[3])));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+    }
+    __m256 px = _mm256_set1_ps(frustum.position.x);
+    __m256 py = _mm256_set1_ps(frustum.position.y);
+    __m256 pz = _mm256_set1_ps(frustum.position.z);
+    __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minX, px), _mm256_sub_ps(px, maxX)), zero);
+    __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minY, py), _mm256_sub_ps(py, maxY)), zero);
+    __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minZ, pz), _mm256_sub_ps(pz, maxZ)), zero);
+    __m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distanceSq, _mm256_set1_ps(frustum.maxDistanceSq), _CMP_LE_OQ));
+    return (u32)_mm256_movemask_ps(inside);
+}
+
+#elif defined(__SSE4_1__)
+#define GRASS_TILE_LANES 4
+
+inline u32 CullGrassTileLanes(const GrassTileBounds& bounds, u32 i, const GrassFrustum& frustum)
+{
+    __m128 minX = _mm_loadu_ps(bounds.minX + i);
+    __m128 minY = _mm_loadu_ps(bounds.minY + i);
+    __m128 minZ = _mm_loadu_ps(bounds.minZ + i);
+    __m128 maxX = _mm_loadu_ps(bounds.maxX + i);
+    __m128 maxY = _mm_loadu_ps(bounds.maxY + i);
+    __m128 maxZ = _mm_loadu_ps(bounds.maxZ + i);
+    __m128 zero = _mm_setzero_ps();
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for(i32 p = 0; p < 6; p++)
+    {
+        const f32* plane = frustum.planes[p];
+        __m128 a = _mm_set1_ps(plane[0]);
+        __m128 b = _mm_set1_ps(plane[1]);
+        __m128 c = _mm_set1_ps(plane[2]);
+        __m128 distance = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_max_ps(_mm_mul_ps(a, minX), _mm_mul_ps(a, maxX)),
+                    _mm_max_ps(_mm_mul_ps(b, minY), _mm_mul_ps(b, maxY))),
+                _mm_add_ps(
+                    _mm_max_ps(_mm_mul_ps(c, minZ), _mm_mul_ps(c, maxZ)),
+                    _mm_set1_ps(plane[3])));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+    }
+    __m128 px = _mm_set1_ps(frustum.position.x);
+    __m128 py = _mm_set1_ps(frustum.position.y);
+    __m128 pz = _mm_set1_ps(frustum.position.z);
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, px), _mm_sub_ps(px, maxX)), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, py), _mm_sub_ps(py, maxY)), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, pz), _mm_sub_ps(pz, maxZ)), zero);
+    __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    inside = _mm_and_ps(inside, _mm_cmple_ps(distanceSq, _mm_set1_ps(frustum.maxDistanceSq)));
+    return (u32)_mm_movemask_ps(inside);
+}
+#endif
+
+u32 CullGrassTiles(const GrassTileBounds& bounds, const GrassFrustum* frusta, u32 frustumCount,
+        u32* visibleTiles, u32* frustumVisibleCounts)
+{
+#if defined(GRASS_TILE_LANES)
+    for(u32 f = 0; f < frustumCount; f++) frustumVisibleCounts[f] = 0;
+    u32 visibleCount = 0;
+    for(u32 i = 0; i < bounds.count; i += GRASS_TILE_LANES)
+    {
+        // Lanes past count read padding and are dropped here
+        u32 laneMask = bounds.count - i >= GRASS_TILE_LANES ?
+            (1u << GRASS_TILE_LANES) - 1 :
+            (1u << (bounds.count - i)) - 1;
+        u32 visibleMask = 0;
+        for(u32 f = 0; f < frustumCount; f++)
+        {
+            u32 frustumMask = CullGrassTileLanes(bounds, i, frusta[f]) & laneMask;
+            frustumVisibleCounts[f] += (u32)__builtin_popcount(frustumMask);
+            visibleMask |= frustumMask;
+        }
+        while(visibleMask)
+        {
+            visibleTiles[visibleCount++] = i + (u32)__builtin_ctz(visibleMask);
+            visibleMask &= visibleMask - 1;
+        }
+    }
+    return visibleCount;
+#else
+    return CullGrassTilesScalar(bounds, frusta, frustumCount, visibleTiles, frustumVisibleCounts);
+#endif
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,50 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/math.hpp"
+
+// Coarse CPU culling of the grass field. Field is split into square tiles of blade cells, and each
+// tile's AABB is kept as structure of arrays, so one frustum test covers 8 tiles with AVX2 (4 with
+// SSE4.1, scalar otherwise). Tiles outside every view frustum, or past far distance from every view,
+// are never placed, culled per blade or drawn.
+
+namespace ty
+{
+namespace Grass
+{
+
+struct GrassTileBounds
+{
+    // Capacity is padded to a multiple of 8, so kernels load full vectors past count
+    f32* minX = NULL;
+    f32* minY = NULL;
+    f32* minZ = NULL;
+    f32* maxX = NULL;
+    f32* maxY = NULL;
+    f32* maxZ = NULL;
+    u32 count = 0;
+    u32 capacity = 0;
+};
+
+struct GrassFrustum
+{
+    // a, b, c, d: inside when a * x + b * y + c * z + d >= 0, not normalized
+    f32 planes[6][4] = {};
+    math::v3f position = {};
+    f32 maxDistanceSq = 0;      // Tiles fully past this distance from position are culled
+};
+
+void ResizeGrassTileBounds(GrassTileBounds* bounds, u32 count);
+void DestroyGrassTileBounds(GrassTileBounds* bounds);
+// Clip planes of viewProj with [0, 1] depth range, same as grass_cull.comp
+GrassFrustum MakeGrassFrustum(math::m4f viewProj, math::v3f position, f32 maxDistance);
+
+// Writes indices of tiles inside any frustum to visibleTiles, which must hold bounds.count entries,
+// and how many tiles each frustum sees to frustumVisibleCounts. Returns visible tile count.
+u32 CullGrassTiles(const GrassTileBounds& bounds, const GrassFrustum* frusta, u32 frustumCount,
+        u32* visibleTiles, u32* frustumVisibleCounts);
+// Reference for validation and benchmarks
+u32 CullGrassTilesScalar(const GrassTileBounds& bounds, const GrassFrustum* frusta, u32 frustumCount,
+        u32* visibleTiles, u32* frustumVisibleCounts);
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,103 @@
+#include "app/latency.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/math.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include <thread>
+#include <wchar.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void ParseLatencySettings(const wchar_t* cmdLine)
+{
+    latencySettings = {};
+    if(!cmdLine) return;
+    latencySettings.lowLatency = wcsstr(cmdLine, L"--low-latency") != NULL;
+    const wchar_t* frameLimitArg = wcsstr(cmdLine, L"--frame-limit=");
+    if(frameLimitArg)
+    {
+        latencySettings.frameLimitFPS = MAX(0.f, (f32)wcstod(frameLimitArg + wcslen(L"--frame-limit="), NULL));
+    }
+    latencyFrameLimitFPS = latencySettings.frameLimitFPS;
+}
+
+void InitLatency()
+{
+    latencyStats = {};
+    latencyLimiterSleepMS = 0;
+    for(i32 i = 0; i < RENDER_CONCURRENT_FRAMES; i++)
+    {
+        latencyInputPending[i] = false;
+    }
+    latencyLimiterTimer.Start();
+}
+
+void WaitFrameLimiter()
+{
+    latencyLimiterTimer.Stop();
+    f64 elapsedMS = latencyLimiterTimer.GetElapsedMS();
+    f32 frameLimitFPS = latencyFrameLimitFPS.load();
+    f32 sleepMS = 0;
+    if(frameLimitFPS > 0)
+    {
+        f64 periodMS = 1000.0 / frameLimitFPS;
+        // Sleep is coarse, so leave the last 2ms to a yielding spin
+        if(periodMS - elapsedMS > 2.0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds((i64)((periodMS - elapsedMS - 2.0) * 1000.0)));
+        }
+        while(true)
+        {
+            latencyLimiterTimer.Stop();
+            if(latencyLimiterTimer.GetElapsedMS() >= periodMS) break;
+            std::this_thread::yield();
+        }
+        sleepMS = (f32)(latencyLimiterTimer.GetElapsedMS() - elapsedMS);
+    }
+    latencyLimiterSleepMS = sleepMS;
+    latencyLimiterTimer.Start();
+}
+
+void MarkFrameInput(i32 frame, time::Timer inputTimer)
+{
+    i32 slot = frame % RENDER_CONCURRENT_FRAMES;
+    latencyInputTimers[slot] = inputTimer;
+    latencyInputPending[slot] = true;
+}
+
+void MarkFramePresented(i32 frame)
+{
+    i32 slot = frame % RENDER_CONCURRENT_FRAMES;
+    if(!latencyInputPending[slot]) return;
+    latencyInputTimers[slot].Stop();
+    latencyStats.inputToPresentMS = math::Lerp(latencyStats.inputToPresentMS,
+            (f32)latencyInputTimers[slot].GetElapsedMS(), latencySettings.smoothing);
+}
+
+void MarkFrameRetired(i32 frame)
+{
+    // Fence for this slot belongs to frame - RENDER_CONCURRENT_FRAMES, whose input timer is still in slot
+    i32 slot = frame % RENDER_CONCURRENT_FRAMES;
+    if(!latencyInputPending[slot]) return;
+    latencyInputTimers[slot].Stop();
+    latencyStats.inputToRetireMS = math::Lerp(latencyStats.inputToRetireMS,
+            (f32)latencyInputTimers[slot].GetElapsedMS(), latencySettings.smoothing);
+    latencyInputPending[slot] = false;
+}
+
+void UpdateLatencyUI()
+{
+    egui::SliderF32(IStr("Frame Limit FPS (0 = off)"), &latencySettings.frameLimitFPS, 0, 240);
+    latencyFrameLimitFPS = latencySettings.frameLimitFPS;
+    egui::Text("Latency mode: %s", latencySettings.lowLatency ? "low latency" : "pipelined");
+    egui::Text("Input to present %.2f ms, input to GPU retire <= %.2f ms, limiter sleep %.2f ms",
+            latencyStats.inputToPresentMS,
+            latencyStats.inputToRetireMS,
+            latencyLimiterSleepMS.load());
+}
+
+};  // namespace Grass
+};  // namespace ty
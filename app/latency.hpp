@@ -0,0 +1,51 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/time.hpp"
+#include "engine/src/render/render.hpp"
+
+#include <atomic>
+
+// Low latency frame pacing. In latency mode the main loop waits on the frame fence first, then
+// runs the optional frame limiter, and only then polls input and moves the camera right before
+// recording, so the camera isn't stale by the GPU wait. Limiter sleep happens before input sampling
+// for the same reason. Latency is measured from input sampling to present call return, and to the
+// fence wait that retires the frame, which bounds when GPU finished it (RENDER_CONCURRENT_FRAMES later).
+
+namespace ty
+{
+namespace Grass
+{
+
+struct LatencySettings
+{
+    bool lowLatency = false;        // Late input sampling loop, from --low-latency
+    f32 frameLimitFPS = 0;          // 0 disables limiter, from --frame-limit=N. Render side, UI edits it.
+    f32 smoothing = 0.1f;
+};
+
+struct LatencyStats
+{
+    f32 inputToPresentMS = 0;       // Smoothed
+    f32 inputToRetireMS = 0;        // Smoothed, upper bound of input to GPU done
+};
+
+inline LatencySettings latencySettings = {};
+inline LatencyStats latencyStats = {};
+inline std::atomic<f32> latencyFrameLimitFPS = 0;      // Published by render side, limiter runs sim side
+inline std::atomic<f32> latencyLimiterSleepMS = 0;     // Published by sim side limiter, shown in render side UI
+inline time::Timer latencyInputTimers[RENDER_CONCURRENT_FRAMES];  // Started when frame's input was sampled
+inline bool latencyInputPending[RENDER_CONCURRENT_FRAMES] = {};
+inline time::Timer latencyLimiterTimer = {};
+
+void ParseLatencySettings(const wchar_t* cmdLine);
+void InitLatency();
+// Sleeps until frame limit period since previous call has passed
+void WaitFrameLimiter();
+void MarkFrameInput(i32 frame, time::Timer inputTimer);
+void MarkFramePresented(i32 frame);
+// Call right after frame fence wait
+void MarkFrameRetired(i32 frame);
+void UpdateLatencyUI();
+
+};  // namespace Grass
+};  // namespace ty
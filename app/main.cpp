@@ -16,14 +16,50 @@
 #include "engine/src/render/egui.hpp"
 
 #include "app/terrain.hpp"
+#include "app/grass_tiles.hpp"
 #include "app/grass.hpp"
+#include "app/grass_bake.hpp"
+#include "app/bench.hpp"
+#include "app/governor.hpp"
+#include "app/frame_memory.hpp"
+#include "app/gpu_memory.hpp"
+#include "app/frame_graph.hpp"
+#include "app/present.hpp"
+#include "app/gpu_stats.hpp"
+#include "app/mesh_optimize.hpp"
+#include "app/sim.hpp"
+#include "app/latency.hpp"
+#include "app/compute_tuning.hpp"
+#include "app/shader_variants.hpp"
+#include "app/trace.hpp"
+#include "app/capture.hpp"
+#include "app/redraw.hpp"
+#include "app/map_stream.hpp"
 
 // Single compilation unit
 #include "app/camera.cpp"
 #include "app/state.cpp"
 #include "app/render_utils.cpp"
 #include "app/terrain.cpp"
+#include "app/grass_tiles.cpp"
 #include "app/grass.cpp"
+#include "app/grass_bake.cpp"
+#include "app/bench.cpp"
+#include "app/governor.cpp"
+#include "app/frame_memory.cpp"
+#include "app/gpu_memory.cpp"
+#include "app/frame_graph.cpp"
+#include "app/present.cpp"
+#include "app/gpu_stats.cpp"
+#include "app/mesh_optimize.cpp"
+#include "app/sim.cpp"
+#include "app/latency.cpp"
+#include "app/compute_tuning.cpp"
+#include "app/shader_variants.cpp"
+#include "app/trace.cpp"
+#include "app/capture.cpp"
+#include "app/redraw.cpp"
+#include "app/map_stream.cpp"
 
 // TODO_LIST:
 // App:
@@ -43,6 +79,53 @@ render::Window window = {};
 Handle<render::RenderTarget> hRenderTargetMain;
 Handle<render::RenderPass> hRenderPassUI;
 
+Handle<render::RenderTarget> MakeRenderTargetMain(f32 scale)
+{
+    render::RenderTargetDesc renderTargetMainDesc = {};
+    renderTargetMainDesc.width = (u32)(appWidth * scale);
+    renderTargetMainDesc.height = (u32)(appHeight * scale);
+    renderTargetMainDesc.colorImageCount = 1;
+    renderTargetMainDesc.colorImageFormats[0] = render::FORMAT_RGBA8_SRGB;
+    renderTargetMainDesc.depthImageFormat = render::FORMAT_D32_FLOAT;
+    // At full resolution color output can be the acquired swap chain image itself (same size and
+    // RGBA8 sRGB format), which removes the full screen copy at the end of the frame.
+    renderTargetMainDesc.swapChainColor = IsPresentDirect(scale);
+    Handle<render::RenderTarget> result = render::MakeRenderTarget(renderTargetMainDesc);
+    // RGBA8 color + D32 depth, swap chain images are owned by engine
+    u64 pixelCount = (u64)renderTargetMainDesc.width * renderTargetMainDesc.height;
+    TrackGpuRenderTarget("Main target", result, pixelCount * (renderTargetMainDesc.swapChainColor ? 4 : 8));
+    return result;
+}
+
+Handle<render::RenderPass> MakeRenderPassUI(Handle<render::RenderTarget> hRenderTarget)
+{
+    render::RenderPassDesc renderPassUIDesc = {};
+    renderPassUIDesc.loadOp = render::LOAD_OP_LOAD;
+    renderPassUIDesc.storeOp = render::STORE_OP_STORE;
+    renderPassUIDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    // Last pass of the frame, leaves main color ready for present or for the copy to swap chain
+    renderPassUIDesc.finalLayout = IsPresentDirect(renderScale) ?
+        render::IMAGE_LAYOUT_PRESENT :
+        render::IMAGE_LAYOUT_TRANSFER_SRC;
+    return render::MakeRenderPass(renderPassUIDesc, hRenderTarget);
+}
+
+void SetRenderScaleMain(f32 newRenderScale)
+{
+    // Internal resolution change, main target is scaled to swap chain size on copy.
+    // With direct present this also switches between swap chain and offscreen color.
+    // Pipelines are kept since new render passes have the same formats.
+    if(newRenderScale == renderScale) return;
+    renderScale = newRenderScale;
+
+    DeferDestroyRenderTarget(hRenderTargetMain);
+    DeferDestroyRenderPass(hRenderPassUI);
+    hRenderTargetMain = MakeRenderTargetMain(renderScale);
+    hRenderPassUI = MakeRenderPassUI(hRenderTargetMain);
+    SetTerrainRenderTarget(hRenderTargetMain);
+    SetGrassRenderTarget(hRenderTargetMain);
+}
+
 void AppInit()
 {
     // Engine system initialization
@@ -51,31 +134,37 @@ void AppInit()
     asset::Init();
 
     render::MakeWindow(&window, appWidth, appHeight, "Grass");
-    render::Init(&window);
+    render::Init(&window, presentConfig.presentMode, presentConfig.swapChainImageCount);
 
     // Default state
     InitState();
+    InitFrameMemory();
+    InitGpuMemory();
     InitDefaultRenderResources();
+    InitGpuStats();
+    InitCapture(appWidth, appHeight);
+    // Workgroup sizes must be known before compute pipelines are made
+    bool computeTuned = !computeAutotuneForced && LoadComputeTuning();
 
     // Render outputs
-    render::RenderTargetDesc renderTargetMainDesc = {};
-    renderTargetMainDesc.width = appWidth;
-    renderTargetMainDesc.height = appHeight;
-    renderTargetMainDesc.colorImageCount = 1;
-    renderTargetMainDesc.colorImageFormats[0] = render::FORMAT_RGBA8_SRGB;
-    renderTargetMainDesc.depthImageFormat = render::FORMAT_D32_FLOAT;
-    hRenderTargetMain = render::MakeRenderTarget(renderTargetMainDesc);
+    hRenderTargetMain = MakeRenderTargetMain(renderScale);
 
     // App systems
+    InitMapStreaming();
     InitTerrain(hRenderTargetMain); 
     InitGrass(hRenderTargetMain);
+    InitTerrainGrassFarField(&streamedGrassDensity);
+    if(!computeTuned)
+    {
+        AutotuneCompute();
+        if(!SaveComputeTuning())
+        {
+            LOGF("Compute tuning not saved, autotuning again next run\n");
+        }
+        grassPositionsDirty = true;
+    }
 
-    render::RenderPassDesc renderPassUIDesc = {};
-    renderPassUIDesc.loadOp = render::LOAD_OP_LOAD;
-    renderPassUIDesc.storeOp = render::STORE_OP_STORE;
-    renderPassUIDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
-    renderPassUIDesc.finalLayout = render::IMAGE_LAYOUT_TRANSFER_SRC;
-    hRenderPassUI = render::MakeRenderPass(renderPassUIDesc, hRenderTargetMain);
+    hRenderPassUI = MakeRenderPassUI(hRenderTargetMain);
     egui::Init(&window, hRenderPassUI);
 
     // App settings
@@ -86,96 +175,331 @@ void AppInit()
 void AppShutdown()
 {
     ShutdownGrass();
+    ShutdownMapStreaming();
+    ShutdownGpuStats();
+    ShutdownCapture();
+    DestroyFrameGraph(&frameGraph);
+    ProcessDeferredDestroys(true);
+    ShutdownGpuMemory();
 
     egui::Shutdown();
     render::Shutdown();
     render::DestroyWindow(&window);
 
+    ShutdownFrameMemory();
     mem::DestroyHeapAllocator(&appHeap);
 }
 
 void AppUpdate()
 {
-    window.PollMessages();
+    // Simulation side, runs on main thread ahead of render thread when pipelined
+    AdvanceSimTime();
+    PollWindowMessages(&window);
 
     input::Update();
-    if(input::IsKeyDown(input::KEY_ESCAPE))
+    simInputTimer.Start();
+    // Camera consumes TraceFrame rather than devices, so replay can substitute recorded input and time
+    TraceFrameRecord& frame = simTraceFrame.record;
+    if(IsTraceReplaying())
     {
-        window.state = render::WINDOW_CLOSED;
-        return;
+        if(!ReadTraceFrame(&simTraceFrame))
+        {
+            window.state = render::WINDOW_CLOSED;
+            return;
+        }
+        simDeltaTime = frame.deltaTime;
+        simWorldTime = frame.worldTime;
+    }
+    else
+    {
+        frame = {};
+        frame.deltaTime = simDeltaTime;
+        frame.worldTime = simWorldTime;
+        if(input::IsKeyDown(input::KEY_ESCAPE)) frame.flags |= TRACE_FRAME_QUIT;
+        if(input::IsKeyJustDown(input::KEY_P))
+        {
+            input::ToggleMouseHide();
+            input::ToggleMouseLock();
+        }
+        if(input::IsMouseLocked())
+        {
+            frame.flags |= TRACE_FRAME_MOUSE_LOCKED;
+            if(input::IsKeyDown(input::KEY_W)) frame.flags |= TRACE_FRAME_MOVE_FORWARD;
+            if(input::IsKeyDown(input::KEY_S)) frame.flags |= TRACE_FRAME_MOVE_BACK;
+            if(input::IsKeyDown(input::KEY_A)) frame.flags |= TRACE_FRAME_MOVE_LEFT;
+            if(input::IsKeyDown(input::KEY_D)) frame.flags |= TRACE_FRAME_MOVE_RIGHT;
+            frame.mouseDelta = input::GetMouseDelta();
+        }
     }
-    if(input::IsKeyJustDown(input::KEY_P))
+
+    if(frame.flags & TRACE_FRAME_QUIT)
     {
-        input::ToggleMouseHide();
-        input::ToggleMouseLock();
+        window.state = render::WINDOW_CLOSED;
+        return;
     }
 
-    if(input::IsMouseLocked())
+    if(frame.flags & TRACE_FRAME_MOUSE_LOCKED)
     {
         math::v3f cameraInputPos = {0,0,0};
-        if(input::IsKeyDown(input::KEY_W)) cameraInputPos.z += 1;
-        if(input::IsKeyDown(input::KEY_S)) cameraInputPos.z -= 1;
-        if(input::IsKeyDown(input::KEY_A)) cameraInputPos.x -= 1;
-        if(input::IsKeyDown(input::KEY_D)) cameraInputPos.x += 1;
-        math::v2f cameraInputRot = input::GetMouseDelta();
-        RotateCamera(appCamera, cameraInputRot, TO_RAD(360.f) / 4.f, deltaTime);
-        MoveCamera(appCamera, cameraInputPos, 50.f, deltaTime);
+        if(frame.flags & TRACE_FRAME_MOVE_FORWARD) cameraInputPos.z += 1;
+        if(frame.flags & TRACE_FRAME_MOVE_BACK) cameraInputPos.z -= 1;
+        if(frame.flags & TRACE_FRAME_MOVE_LEFT) cameraInputPos.x -= 1;
+        if(frame.flags & TRACE_FRAME_MOVE_RIGHT) cameraInputPos.x += 1;
+        RotateCamera(simCamera, frame.mouseDelta, TO_RAD(360.f) / 4.f, simDeltaTime);
+        MoveCamera(simCamera, cameraInputPos, 50.f, simDeltaTime);
     }
 }
 
+f32 frameGpuWaitS = 0;
+f32 frameRecordS = 0;       // Render side CPU work of previous frame, from after fence wait to before present
+
+void AppBeginFrame()
+{
+    // Time blocked on frame fence, for traces
+    time::Timer fenceTimer;
+    fenceTimer.Start();
+    render::BeginFrame(currentFrame);
+    fenceTimer.Stop();
+    frameGpuWaitS = (f32)fenceTimer.GetElapsedS();
+    MarkFrameRetired(currentFrame);
+    MarkCaptureRetired(currentFrame);
+}
+
 void AppRender()
 {
-    // Frame setup
+    // Frame setup, after AppBeginFrame waited on frame fence
+    time::Timer recordTimer;
+    recordTimer.Start();
     Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_FRAME, currentFrame);
-    render::BeginFrame(currentFrame);
+    BeginFrameMemory(currentFrame);
+    BeginGpuMemoryFrame(currentFrame);
+    ProcessDeferredDestroys();
+    // Delta time after skipped frames includes idle sleep, which isn't frame cost
+    // GPU duration is read back by BeginGpuStatsFrame, so it lags a few frames like other GPU stats
+    if(!frameResumed) UpdateGovernor(frameRecordS, gpuFrameMS / 1000.f);
+    SetRenderScaleMain(GetGovernorRenderScale());
     render::BeginCommandBuffer(hCmd);
-    egui::BeginFrame();
-
-    // Frame commands
-    // Clear render output
-    render::Barrier barrier = {};
-    barrier.srcAccess = render::MEMORY_ACCESS_NONE;
-    barrier.dstAccess = render::MEMORY_ACCESS_TRANSFER_WRITE;
-    barrier.srcStage = render::PIPELINE_STAGE_TOP;
-    barrier.dstStage = render::PIPELINE_STAGE_TRANSFER;
-    render::CmdPipelineBarrierTextureLayout(hCmd, render::GetColorOutput(hRenderTargetMain, 0), render::IMAGE_LAYOUT_TRANSFER_DST, barrier);
-    render::CmdClearColorTexture(hCmd, render::GetColorOutput(hRenderTargetMain, 0), 1, 0.5, 0.3, 1);
-    barrier.srcAccess = render::MEMORY_ACCESS_TRANSFER_WRITE;
-    barrier.dstAccess = render::MEMORY_ACCESS_COLOR_OUTPUT_WRITE;
-    barrier.srcStage = render::PIPELINE_STAGE_TRANSFER;
-    barrier.dstStage = render::PIPELINE_STAGE_COLOR_OUTPUT;
-    render::CmdPipelineBarrierTextureLayout(hCmd, render::GetColorOutput(hRenderTargetMain, 0), render::IMAGE_LAYOUT_COLOR_OUTPUT, barrier);
+    BeginGpuStatsFrame(hCmd, currentFrame);
+    {
+        std::lock_guard<std::mutex> lock(windowInputMutex);
+        egui::BeginFrame();
+    }
 
     UpdateTerrainConstants();
     UpdateGrassConstants();
+    UpdateGovernorUI();
+    UpdateMemoryUI();
+    UpdateGpuMemoryUI();
+    UpdateGpuStatsUI();
+    UpdateLatencyUI();
+    UpdateCaptureUI();
+    UpdateRedrawUI();
+    UpdateMapStreamUI();
+    UpdateMapStreaming();
     UpdateGrassUniforms();
+    UpdateTerrainUniforms();
+    UpdateRedrawSettings();
+
+    // Frame commands, barriers between passes come from declared resource usage
+    FrameGraph* graph = &frameGraph;
+    BeginFrameGraph(graph);
+    // Initial usages are the last ones from previous frame.
+    // A direct present main color is a different swap chain image each frame, contents are discarded.
+    bool presentDirect = IsPresentDirect(renderScale);
+    FrameGraphResource colorMain = ImportFrameGraphTexture(graph, "Main color",
+            render::GetColorOutput(hRenderTargetMain, 0),
+            presentDirect ? FRAME_GRAPH_USAGE_NONE : FRAME_GRAPH_USAGE_TRANSFER_READ);
+    FrameGraphResource depthMain = ImportFrameGraphTexture(graph, "Main depth",
+            render::GetDepthOutput(hRenderTargetMain), FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+    FrameGraphResource grassInstances = ImportFrameGraphBuffer(graph, "Grass instances",
+            hSbGrassInstanceData, FRAME_GRAPH_USAGE_VERTEX_READ);
+    FrameGraphResource grassDrawArgs = ImportFrameGraphBuffer(graph, "Grass draw args",
+            hSbGrassDrawArgs, FRAME_GRAPH_USAGE_INDIRECT_READ);
+    FrameGraphResource grassTileCounts = ImportFrameGraphBuffer(graph, "Grass tile counts",
+            hSbGrassTileCounts, FRAME_GRAPH_USAGE_COMPUTE_READ);
+    FrameGraphResource grassVisible = ImportFrameGraphBuffer(graph, "Grass visible indices",
+            hSbGrassVisible, FRAME_GRAPH_USAGE_VERTEX_READ);
+    // Splat buffer lives from its clear to resolve, graph releases its memory once splatting is off
+    bool grassSplatEnabled = IsGrassSplatEnabled();
+    FrameGraphResource grassSplat = -1;
+    if(grassSplatEnabled) grassSplat = CreateFrameGraphBuffer(graph, "Grass splat", GetGrassSplatSize());
+
+    i32 pass = AddFrameGraphPass(graph, "Clear", [](Handle<render::CommandBuffer> hCmd)
+    {
+        // Overdraw heat is additive, so it starts from black
+        if(grassDebugMode == GRASS_DEBUG_OVERDRAW)
+        {
+            render::CmdClearColorTexture(hCmd, render::GetColorOutput(hRenderTargetMain, 0), 0, 0, 0, 1);
+        }
+        else
+        {
+            render::CmdClearColorTexture(hCmd, render::GetColorOutput(hRenderTargetMain, 0), 1, 0.5, 0.3, 1);
+        }
+        render::CmdClearDepthTexture(hCmd, render::GetDepthOutput(hRenderTargetMain), 1);
+    });
+    UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_TRANSFER_WRITE);
+    UseFrameGraphResource(graph, pass, depthMain, FRAME_GRAPH_USAGE_TRANSFER_WRITE);
+
+    pass = AddFrameGraphPass(graph, "Terrain", [](Handle<render::CommandBuffer> hCmd)
+    {
+        BeginGpuStatsScope(hCmd, GPU_STATS_TERRAIN);
+        RenderTerrain(hCmd);
+        EndGpuStatsScope(hCmd, GPU_STATS_TERRAIN);
+    });
+    UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+    UseFrameGraphResource(graph, pass, depthMain, FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+
+    // Only tiles that just became visible and weren't placed since placement inputs last changed
+    if(grassTilePlaceCount > 0)
+    {
+        pass = AddFrameGraphPass(graph, "Grass placement", [](Handle<render::CommandBuffer> hCmd)
+        {
+            PopulateGrassPositions(hCmd);
+        });
+        UseFrameGraphResource(graph, pass, grassInstances, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+        UseFrameGraphResource(graph, pass, grassTileCounts, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+    }
+
+    // Visible list ranges come from placed blade counts
+    pass = AddFrameGraphPass(graph, "Grass draw args reset", [](Handle<render::CommandBuffer> hCmd)
+    {
+        ResetVisibleGrassDrawArgs(hCmd);
+    });
+    UseFrameGraphResource(graph, pass, grassDrawArgs, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+    UseFrameGraphResource(graph, pass, grassTileCounts, FRAME_GRAPH_USAGE_COMPUTE_READ);
 
-    RenderTerrain(hCmd);
-    PopulateGrassPositions(hCmd);
-    barrier.srcAccess = render::MEMORY_ACCESS_SHADER_WRITE;
-    barrier.dstAccess = render::MEMORY_ACCESS_SHADER_READ;
-    barrier.srcStage = render::PIPELINE_STAGE_COMPUTE_SHADER;
-    barrier.dstStage = render::PIPELINE_STAGE_VERTEX_SHADER;
-    render::CmdPipelineBarrier(hCmd, barrier);
-    RenderGrassInstances(hCmd);
-
-    // Render GUI
-    render::BeginRenderPass(hCmd, hRenderPassUI);
-    egui::DrawFrame(hCmd);
-    render::EndRenderPass(hCmd, hRenderPassUI);
-
-    // Copy to swap chain image and end frame
-    barrier.srcAccess = render::MEMORY_ACCESS_COLOR_OUTPUT_WRITE;
-    barrier.dstAccess = render::MEMORY_ACCESS_TRANSFER_READ;
-    barrier.srcStage = render::PIPELINE_STAGE_COLOR_OUTPUT;
-    barrier.dstStage = render::PIPELINE_STAGE_TRANSFER;
-    render::CmdPipelineBarrierTextureLayout(hCmd, render::GetColorOutput(hRenderTargetMain, 0), render::IMAGE_LAYOUT_TRANSFER_SRC, barrier);
-    render::CmdCopyToSwapChain(hCmd, render::GetColorOutput(hRenderTargetMain, 0));
+    if(grassSplatEnabled)
+    {
+        pass = AddFrameGraphPass(graph, "Grass splat clear", [](Handle<render::CommandBuffer> hCmd)
+        {
+            ClearGrassSplat(hCmd);
+        });
+        UseFrameGraphResource(graph, pass, grassSplat, FRAME_GRAPH_USAGE_TRANSFER_WRITE);
+    }
+
+    // Culls for every grass view at once, extra views would be drawn into their own passes after it
+    pass = AddFrameGraphPass(graph, "Grass cull", [](Handle<render::CommandBuffer> hCmd)
+    {
+        BeginGpuStatsScope(hCmd, GPU_STATS_GRASS_CULL);
+        CullGrassInstances(hCmd);
+        EndGpuStatsScope(hCmd, GPU_STATS_GRASS_CULL);
+    });
+    UseFrameGraphResource(graph, pass, grassInstances, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+    UseFrameGraphResource(graph, pass, grassDrawArgs, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+    UseFrameGraphResource(graph, pass, grassTileCounts, FRAME_GRAPH_USAGE_COMPUTE_READ);
+    UseFrameGraphResource(graph, pass, grassVisible, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+    if(grassSplatEnabled) UseFrameGraphResource(graph, pass, grassSplat, FRAME_GRAPH_USAGE_COMPUTE_WRITE);
+
+    // Reduced resolution grass draws into its own target, cleared to zero coverage
+    bool grassLowRes = IsGrassLowRes();
+    FrameGraphResource grassLowResColor = -1;
+    FrameGraphResource grassLowResDepth = -1;
+    if(grassLowRes)
+    {
+        FrameGraphUsage lowResInitialUsage = grassLowResFresh ? FRAME_GRAPH_USAGE_NONE : FRAME_GRAPH_USAGE_FRAGMENT_READ;
+        grassLowResFresh = false;
+        grassLowResColor = ImportFrameGraphTexture(graph, "Grass low res color",
+                render::GetColorOutput(hRenderTargetGrassLowRes, 0), lowResInitialUsage);
+        grassLowResDepth = ImportFrameGraphTexture(graph, "Grass low res depth",
+                render::GetDepthOutput(hRenderTargetGrassLowRes), lowResInitialUsage);
+        pass = AddFrameGraphPass(graph, "Grass low res clear", [](Handle<render::CommandBuffer> hCmd)
+        {
+            render::CmdClearColorTexture(hCmd, render::GetColorOutput(hRenderTargetGrassLowRes, 0), 0, 0, 0, 0);
+            render::CmdClearDepthTexture(hCmd, render::GetDepthOutput(hRenderTargetGrassLowRes), 1);
+        });
+        UseFrameGraphResource(graph, pass, grassLowResColor, FRAME_GRAPH_USAGE_TRANSFER_WRITE);
+        UseFrameGraphResource(graph, pass, grassLowResDepth, FRAME_GRAPH_USAGE_TRANSFER_WRITE);
+    }
+
+    pass = AddFrameGraphPass(graph, "Grass draw", [](Handle<render::CommandBuffer> hCmd)
+    {
+        BeginGpuStatsScope(hCmd, GPU_STATS_GRASS_DRAW);
+        RenderGrassInstances(hCmd, grassMainView);
+        EndGpuStatsScope(hCmd, GPU_STATS_GRASS_DRAW);
+    });
+    if(grassLowRes)
+    {
+        UseFrameGraphResource(graph, pass, grassLowResColor, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+        UseFrameGraphResource(graph, pass, grassLowResDepth, FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+    }
+    else
+    {
+        UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+        UseFrameGraphResource(graph, pass, depthMain, FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+    }
+    UseFrameGraphResource(graph, pass, grassInstances, FRAME_GRAPH_USAGE_VERTEX_READ);
+    UseFrameGraphResource(graph, pass, grassVisible, FRAME_GRAPH_USAGE_VERTEX_READ);
+    UseFrameGraphResource(graph, pass, grassDrawArgs, FRAME_GRAPH_USAGE_INDIRECT_READ);
+
+    if(grassLowRes)
+    {
+        // Before splat resolve, so splats depth test against composited blades
+        pass = AddFrameGraphPass(graph, "Grass upsample", [](Handle<render::CommandBuffer> hCmd)
+        {
+            UpsampleGrass(hCmd);
+        });
+        UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+        UseFrameGraphResource(graph, pass, depthMain, FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+        UseFrameGraphResource(graph, pass, grassLowResColor, FRAME_GRAPH_USAGE_FRAGMENT_READ);
+        UseFrameGraphResource(graph, pass, grassLowResDepth, FRAME_GRAPH_USAGE_FRAGMENT_READ);
+    }
+
+    if(grassSplatEnabled)
+    {
+        pass = AddFrameGraphPass(graph, "Grass splat resolve", [](Handle<render::CommandBuffer> hCmd)
+        {
+            BeginGpuStatsScope(hCmd, GPU_STATS_GRASS_SPLAT_RESOLVE);
+            ResolveGrassSplat(hCmd);
+            EndGpuStatsScope(hCmd, GPU_STATS_GRASS_SPLAT_RESOLVE);
+        });
+        UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+        UseFrameGraphResource(graph, pass, depthMain, FRAME_GRAPH_USAGE_DEPTH_OUTPUT);
+        UseFrameGraphResource(graph, pass, grassSplat, FRAME_GRAPH_USAGE_FRAGMENT_READ);
+    }
+
+    // Scene without UI, copied to a readback buffer the encoder thread gets frames later
+    if(BeginCaptureFrame(currentFrame, (u32)(appWidth * renderScale), (u32)(appHeight * renderScale)))
+    {
+        pass = AddFrameGraphPass(graph, "Capture", [](Handle<render::CommandBuffer> hCmd)
+        {
+            RecordCaptureCopy(hCmd, render::GetColorOutput(hRenderTargetMain, 0));
+        }, true);
+        UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_TRANSFER_READ);
+    }
+
+    pass = AddFrameGraphPass(graph, "UI", [](Handle<render::CommandBuffer> hCmd)
+    {
+        BeginGpuStatsScope(hCmd, GPU_STATS_UI);
+        render::BeginRenderPass(hCmd, hRenderPassUI);
+        egui::DrawFrame(hCmd);
+        render::EndRenderPass(hCmd, hRenderPassUI);
+        EndGpuStatsScope(hCmd, GPU_STATS_UI);
+    }, presentDirect);
+    UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_COLOR_OUTPUT);
+
+    if(!presentDirect)
+    {
+        pass = AddFrameGraphPass(graph, "Copy to swap chain", [](Handle<render::CommandBuffer> hCmd)
+        {
+            render::CmdCopyToSwapChain(hCmd, render::GetColorOutput(hRenderTargetMain, 0));
+        }, true);
+        UseFrameGraphResource(graph, pass, colorMain, FRAME_GRAPH_USAGE_TRANSFER_READ);
+    }
+
+    CompileFrameGraph(graph);
+    SetGrassSplatBuffer(grassSplatEnabled ? GetFrameGraphBuffer(graph, grassSplat) : Handle<render::Buffer>());
+    ExecuteFrameGraph(graph, hCmd);
+
+    // End frame
+    EndGpuStatsFrame(hCmd, currentFrame);
     render::EndCommandBuffer(hCmd);
     render::EndFrame(currentFrame, hCmd);
+    recordTimer.Stop();
+    frameRecordS = (f32)recordTimer.GetElapsedS();
 
     // Present
     render::Present(currentFrame);
+    MarkFramePresented(currentFrame);
 }
 
 };  // namespace Grass
@@ -186,15 +510,171 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrev, PWSTR pCmdLine, int nC
     using namespace ty;
     using namespace Grass;
 
+    if(pCmdLine && wcsstr(pCmdLine, L"--bake-grass"))
+    {
+        // Offline, no InitState, only app heap for bake scratch
+        appHeap = mem::MakeHeapAllocator(appHeapCapacity);
+        bool result = BakeDefaultGrassFile();
+        mem::DestroyHeapAllocator(&appHeap);
+        return result ? 0 : 1;
+    }
+    if(pCmdLine && wcsstr(pCmdLine, L"--build-maps"))
+    {
+        // Offline, no InitState, only app heap for mip and tile scratch
+        appHeap = mem::MakeHeapAllocator(appHeapCapacity);
+        bool result = BuildDefaultMapFiles();
+        mem::DestroyHeapAllocator(&appHeap);
+        return result ? 0 : 1;
+    }
+
+    ParsePresentConfig(pCmdLine);
+    ParseLatencySettings(pCmdLine);
+    ParseTraceSettings(pCmdLine);
+    ParseCaptureSettings(pCmdLine);
+    ParseRedrawSettings(pCmdLine);
+    ParseMapStreamSettings(pCmdLine);
+    computeAutotuneForced = pCmdLine && wcsstr(pCmdLine, L"--autotune");
     AppInit();
+    InitSim();
+    InitLatency();
+    InitRedraw();
+    frameGraph.printNext = pCmdLine && wcsstr(pCmdLine, L"--print-frame-graph");
+
+    if(pCmdLine && wcsstr(pCmdLine, L"--bench"))
+    {
+        RunBenchmarks([]()
+        {
+            PollWindowMessages(&window);
+            AppBeginFrame();
+            AppRender();
+            AdvanceState();
+        });
+        AppShutdown();
+        return 0;
+    }
+
+    if(!BeginTrace())
+    {
+        AppShutdown();
+        return 1;
+    }
+
+    if(IsTraceReplaying())
+    {
+        // Single threaded and unpaced, frames only depend on trace. Governor would make
+        // them depend on timing, so it stays off and the UI can't turn it back on.
+        while(window.state != render::WINDOW_CLOSED)
+        {
+            governorSettings.targetFrameMS = 0;
+            time::Timer frameTimer;
+            frameTimer.Start();
+            AppUpdate();
+            if(window.state == render::WINDOW_CLOSED) break;
+            FrameSnapshot snapshot = MakeFrameSnapshot();
+            frameTimer.Stop();
+            f32 updateMS = (f32)frameTimer.GetElapsedMS();
+            AppBeginFrame();
+            time::Timer renderTimer;
+            renderTimer.Start();
+            ApplyFrameSnapshot(snapshot);
+            AppRender();
+            AdvanceState();
+            renderTimer.Stop();
+            frameTimer.Stop();
+            WriteTraceTimings(updateMS, (f32)renderTimer.GetElapsedMS(), frameGpuWaitS * 1000.f, (f32)frameTimer.GetElapsedMS());
+        }
+        EndTrace();
+        AppShutdown();
+        return 0;
+    }
+
+    if(latencySettings.lowLatency)
+    {
+        // Input is sampled after fence wait and limiter, right before recording.
+        // Fence is already waited when on demand rendering decides, so that frame is drawn
+        // anyway, and following iterations decide before waiting (GPU is idle by then).
+        while(window.state != render::WINDOW_CLOSED)
+        {
+            if(redrawState.skipping)
+            {
+                AppUpdate();
+                if(!ShouldRedraw())
+                {
+                    WaitRedrawIdle();
+                    continue;
+                }
+                AppBeginFrame();
+            }
+            else
+            {
+                AppBeginFrame();
+                WaitFrameLimiter();
+                AppUpdate();
+                ShouldRedraw();
+            }
+            ApplyFrameSnapshot(MakeFrameSnapshot());
+            AppRender();
+            AdvanceState();
+        }
+        EndTrace();
+        AppShutdown();
+        return 0;
+    }
+
+    if(pCmdLine && wcsstr(pCmdLine, L"--single-thread"))
+    {
+        while(window.state != render::WINDOW_CLOSED)
+        {
+            WaitFrameLimiter();
+            AppUpdate();
+            if(window.state != render::WINDOW_CLOSED && !ShouldRedraw())
+            {
+                WaitRedrawIdle();
+                continue;
+            }
+            FrameSnapshot snapshot = MakeFrameSnapshot();
+            AppBeginFrame();
+            ApplyFrameSnapshot(snapshot);
+            AppRender();
+            AdvanceState();
+        }
+        EndTrace();
+        AppShutdown();
+        return 0;
+    }
 
+    // Render thread draws frame N while main thread simulates frame N+1
+    std::thread renderThread([]()
+    {
+        while(true)
+        {
+            FrameSnapshot snapshot = PopFrameSnapshot();
+            if(snapshot.quit) break;
+            AppBeginFrame();
+            ApplyFrameSnapshot(snapshot);
+            AppRender();
+            AdvanceState();
+        }
+    });
+    // Limiting simulation paces render thread through snapshot queue
     while(window.state != render::WINDOW_CLOSED)
     {
+        WaitFrameLimiter();
         AppUpdate();
-        AppRender();
-        AdvanceState();
+        if(window.state == render::WINDOW_CLOSED) break;
+        if(!ShouldRedraw())
+        {
+            WaitRedrawIdle();
+            continue;
+        }
+        PushFrameSnapshot(MakeFrameSnapshot());
     }
+    FrameSnapshot quitSnapshot = {};
+    quitSnapshot.quit = true;
+    PushFrameSnapshot(quitSnapshot);
+    renderThread.join();
 
+    EndTrace();
     AppShutdown();
     return 0;
 }
@@ -0,0 +1,660 @@
+#include "app/map_stream.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/file.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/state.hpp"
+#include "app/terrain.hpp"
+#include "app/gpu_memory.hpp"
+#include "app/frame_memory.hpp"
+#include "app/render_utils.hpp"
+#include "app/redraw.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void ParseMapStreamSettings(const wchar_t* cmdLine)
+{
+    mapStreamSettings = {};
+    if(!cmdLine) return;
+    const wchar_t* budgetArg = wcsstr(cmdLine, L"--map-budget-mb=");
+    if(budgetArg)
+    {
+        mapStreamSettings.budgetMB = (u32)MAX(1, (i32)wcstol(budgetArg + wcslen(L"--map-budget-mb="), NULL, 10));
+    }
+    const wchar_t* radiusArg = wcsstr(cmdLine, L"--map-stream-radius=");
+    if(radiusArg)
+    {
+        mapStreamSettings.streamRadius = MAX(1.f, (f32)wcstod(radiusArg + wcslen(L"--map-stream-radius="), NULL));
+    }
+}
+
+u32 GetTiledMapBytesPerTexel(u32 format)
+{
+    switch(format)
+    {
+        case TILED_MAP_FORMAT_R16: return 2;
+        case TILED_MAP_FORMAT_R8_UNORM: return 1;
+        default: return 0;
+    }
+}
+
+// Box filters 2x2 texels of previous mip, clamped at odd edges. Density and selector masks are averaged
+// as is, so coarse density mips keep the mean probability and selector mips blend neighbouring selections.
+u8* MakeTiledMapMip(u32 format, const u8* texels, u32 width, u32 height, u32 mipWidth, u32 mipHeight)
+{
+    u32 bytesPerTexel = GetTiledMapBytesPerTexel(format);
+    u8* result = (u8*)AppHeapAlloc((u64)mipWidth * mipHeight * bytesPerTexel);
+    for(u32 y = 0; y < mipHeight; y++)
+    {
+        for(u32 x = 0; x < mipWidth; x++)
+        {
+            u32 x0 = x * 2;
+            u32 y0 = y * 2;
+            u32 x1 = MIN(x0 + 1, width - 1);
+            u32 y1 = MIN(y0 + 1, height - 1);
+            u64 sources[4] =
+            {
+                (u64)y0 * width + x0, (u64)y0 * width + x1,
+                (u64)y1 * width + x0, (u64)y1 * width + x1,
+            };
+            u64 target = (u64)y * mipWidth + x;
+            if(format == TILED_MAP_FORMAT_R8_UNORM)
+            {
+                u32 sum = 0;
+                for(i32 i = 0; i < 4; i++) sum += texels[sources[i]];
+                result[target] = (u8)((sum + 2) / 4);
+            }
+            else
+            {
+                const u16* source16 = (const u16*)texels;
+                u32 sum = 0;
+                for(i32 i = 0; i < 4; i++) sum += source16[sources[i]];
+                ((u16*)result)[target] = (u16)((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+bool WriteTiledMap(const char* path, TiledMapFormat format, const void* texels, u32 width, u32 height, u32 tileSize)
+{
+    ASSERT(texels && width > 0 && height > 0);
+    // Tile pool packs R8 texels 4 per word, tiles must stay word aligned
+    ASSERT(tileSize >= 2 && tileSize % 2 == 0);
+    u32 bytesPerTexel = GetTiledMapBytesPerTexel(format);
+
+    TiledMapHeader header = {};
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.tileSize = tileSize;
+    u32 mipWidth = width;
+    u32 mipHeight = height;
+    while(true)
+    {
+        ASSERT(header.mipCount < MAX_TILED_MAP_MIPS);
+        TiledMapMip& mip = header.mips[header.mipCount++];
+        mip.width = mipWidth;
+        mip.height = mipHeight;
+        mip.tilesX = (mipWidth + tileSize - 1) / tileSize;
+        mip.tilesY = (mipHeight + tileSize - 1) / tileSize;
+        mip.firstTile = header.tileCount;
+        header.tileCount += mip.tilesX * mip.tilesY;
+        if(mip.tilesX == 1 && mip.tilesY == 1) break;
+        mipWidth = (mipWidth + 1) / 2;
+        mipHeight = (mipHeight + 1) / 2;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if(!file)
+    {
+        LOGF("Failed to open tiled map file for writing: %s\n", path);
+        return false;
+    }
+    u8 headerBlock[tiledMapDataOffset] = {};
+    memcpy(headerBlock, &header, sizeof(TiledMapHeader));
+    bool result = fwrite(headerBlock, sizeof(headerBlock), 1, file) == 1;
+
+    u64 tileBytes = (u64)tileSize * tileSize * bytesPerTexel;
+    u8* tile = (u8*)AppHeapAlloc(tileBytes);
+    const u8* mipTexels = (const u8*)texels;
+    u8* ownedMipTexels = NULL;
+    for(u32 m = 0; m < header.mipCount && result; m++)
+    {
+        TiledMapMip& mip = header.mips[m];
+        if(m > 0)
+        {
+            TiledMapMip& previous = header.mips[m - 1];
+            u8* next = MakeTiledMapMip(format, mipTexels, previous.width, previous.height, mip.width, mip.height);
+            AppHeapFree(ownedMipTexels);
+            ownedMipTexels = next;
+            mipTexels = next;
+        }
+        for(u32 tileY = 0; tileY < mip.tilesY && result; tileY++)
+        {
+            for(u32 tileX = 0; tileX < mip.tilesX && result; tileX++)
+            {
+                for(u32 y = 0; y < tileSize; y++)
+                {
+                    u32 sourceY = MIN(tileY * tileSize + y, mip.height - 1);
+                    for(u32 x = 0; x < tileSize; x++)
+                    {
+                        u32 sourceX = MIN(tileX * tileSize + x, mip.width - 1);
+                        memcpy(tile + ((u64)y * tileSize + x) * bytesPerTexel,
+                                mipTexels + ((u64)sourceY * mip.width + sourceX) * bytesPerTexel,
+                                bytesPerTexel);
+                    }
+                }
+                result = fwrite(tile, tileBytes, 1, file) == 1;
+            }
+        }
+    }
+    AppHeapFree(ownedMipTexels);
+    AppHeapFree(tile);
+    result = fclose(file) == 0 && result;
+    return result;
+}
+
+bool BuildGrassDensityMapFile(Handle<asset::Image> hAsset)
+{
+    ASSERT(hAsset.IsValid());
+    asset::Image& asset = asset::images[hAsset];
+    u64 texelCount = (u64)asset.width * asset.height;
+    u8* density = (u8*)AppHeapAlloc(texelCount);
+    for(u64 i = 0; i < texelCount; i++)
+    {
+        density[i] = asset.data[i * asset.channels];
+    }
+    CreateDirectoryA("resources/maps", NULL);
+    bool result = WriteTiledMap(GRASS_DENSITY_MAP_PATH, TILED_MAP_FORMAT_R8_UNORM, density, asset.width, asset.height);
+    AppHeapFree(density);
+    LOGF("Built tiled density map %s from %ux%u image\n", GRASS_DENSITY_MAP_PATH, asset.width, asset.height);
+    return result;
+}
+
+inline u32 MapNoiseHash(u32 x)
+{
+    u32 state = x * 747796405u + 2891336453u;
+    u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Smoothly interpolated random lattice values in [0, 1], cellsPerSide lattice cells over the map
+f32 SampleMapValueNoise(f32 u, f32 v, u32 cellsPerSide, u32 seed)
+{
+    f32 x = u * cellsPerSide;
+    f32 y = v * cellsPerSide;
+    u32 x0 = (u32)x;
+    u32 y0 = (u32)y;
+    f32 tx = x - x0;
+    f32 ty = y - y0;
+    tx = tx * tx * (3 - 2 * tx);
+    ty = ty * ty * (3 - 2 * ty);
+    f32 corners[4];
+    for(u32 i = 0; i < 4; i++)
+    {
+        u32 h = MapNoiseHash(MapNoiseHash(MapNoiseHash(x0 + (i & 1)) ^ (y0 + (i >> 1))) ^ seed);
+        corners[i] = (h >> 8) * (1.f / 16777216.f);
+    }
+    f32 top = corners[0] + (corners[1] - corners[0]) * tx;
+    f32 bottom = corners[2] + (corners[3] - corners[2]) * tx;
+    return top + (bottom - top) * ty;
+}
+
+bool BuildGrassSpeciesMapFile()
+{
+    const char* imagePath = IMAGE_PATH"grass_species.png";
+    u8* selector = NULL;
+    u32 width = 0;
+    u32 height = 0;
+    FILE* imageFile = fopen(imagePath, "rb");
+    bool authored = imageFile != NULL;
+    if(authored)
+    {
+        fclose(imageFile);
+        Handle<asset::Image> hAsset = asset::LoadImageFile(file::MakePath(IStr(imagePath)));
+        asset::Image& asset = asset::images[hAsset];
+        width = asset.width;
+        height = asset.height;
+        selector = (u8*)AppHeapAlloc((u64)width * height);
+        for(u64 i = 0; i < (u64)width * height; i++)
+        {
+            selector[i] = asset.data[i * asset.channels];
+        }
+    }
+    else
+    {
+        // Patches a few dozen units wide over the default terrain, with smaller breakup inside them.
+        // Averaged noise clusters around 0.5, contrast spreads it over every species.
+        width = 512;
+        height = 512;
+        selector = (u8*)AppHeapAlloc((u64)width * height);
+        for(u32 y = 0; y < height; y++)
+        {
+            for(u32 x = 0; x < width; x++)
+            {
+                f32 u = (x + 0.5f) / width;
+                f32 v = (y + 0.5f) / height;
+                f32 noise = SampleMapValueNoise(u, v, 8, 0) * 0.7f + SampleMapValueNoise(u, v, 32, 1) * 0.3f;
+                f32 value = MIN(MAX((noise - 0.5f) * 2.5f + 0.5f, 0.f), 1.f);
+                selector[(u64)y * width + x] = (u8)(value * 255.f + 0.5f);
+            }
+        }
+    }
+    CreateDirectoryA("resources/maps", NULL);
+    bool result = WriteTiledMap(GRASS_SPECIES_MAP_PATH, TILED_MAP_FORMAT_R8_UNORM, selector, width, height);
+    AppHeapFree(selector);
+    LOGF("Built tiled species map %s from %s (%ux%u)\n", GRASS_SPECIES_MAP_PATH,
+            authored ? imagePath : "procedural noise", width, height);
+    return result;
+}
+
+bool BuildDefaultMapFiles()
+{
+    asset::Init();
+    Handle<asset::Image> hAssetDensity = asset::LoadImageFile(file::MakePath(IStr(IMAGE_PATH"grass_density.png")));
+    bool result = BuildGrassDensityMapFile(hAssetDensity);
+    return BuildGrassSpeciesMapFile() && result;
+}
+
+void MapStreamThreadMain(i32 threadIndex)
+{
+    while(true)
+    {
+        MapTileRequest request = {};
+        if(!mapStreamRequests[threadIndex].Pop(&request))
+        {
+            if(mapStreamQuit.load()) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        // Cold tiles fault in from disk here, never on render thread
+        StreamedMap* map = request.map;
+        memcpy(map->staging + request.staging * map->tileBytes,
+                map->view + tiledMapDataOffset + request.tile * map->tileBytes,
+                map->tileBytes);
+        // Capacity matches loads in flight, render side drains every frame
+        while(!mapStreamCompletions[threadIndex].Push(request) && !mapStreamQuit.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        redrawRequested = true;
+    }
+}
+
+void InitMapStreaming()
+{
+    streamedMapCount = 0;
+    mapStreamFrame = 0;
+    mapStreamQuit = false;
+    for(i32 i = 0; i < MAP_STREAM_IO_THREADS; i++)
+    {
+        mapStreamThreads[i] = std::thread(MapStreamThreadMain, i);
+    }
+}
+
+void CloseStreamedMap(StreamedMap* map)
+{
+    ASSERT(map);
+    if(map->hUbMap.IsValid()) DeferDestroyBuffer(map->hUbMap);
+    if(map->hSbPageTable.IsValid()) DeferDestroyBuffer(map->hSbPageTable);
+    if(map->hSbTilePool.IsValid()) DeferDestroyBuffer(map->hSbTilePool);
+    AppHeapFree(map->tileSlots);
+    AppHeapFree(map->slots);
+    AppHeapFree(map->staging);
+    AppHeapFree(map->pageTable);
+    AppHeapFree(map->pagesChanged);
+    if(map->view) UnmapViewOfFile(map->view);
+    if(map->mappingHandle) CloseHandle(map->mappingHandle);
+    if(map->fileHandle) CloseHandle(map->fileHandle);
+    *map = {};
+}
+
+void ShutdownMapStreaming()
+{
+    // I/O threads finish queued requests, completions left over are dropped with their maps
+    mapStreamQuit = true;
+    for(i32 i = 0; i < MAP_STREAM_IO_THREADS; i++)
+    {
+        mapStreamThreads[i].join();
+        MapTileRequest request = {};
+        while(mapStreamCompletions[i].Pop(&request)) {}
+    }
+    for(u32 i = 0; i < streamedMapCount; i++)
+    {
+        StreamedMap* map = streamedMaps[i];
+        LOGF("Map %s: %u tile loads (%.1f MB), %u evictions\n",
+                map->name,
+                map->stats.loads,
+                map->stats.bytesLoaded / (1024.0 * 1024.0),
+                map->stats.evictions);
+        CloseStreamedMap(map);
+    }
+    streamedMapCount = 0;
+}
+
+bool MapTiledMapFile(StreamedMap* map, const char* path)
+{
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return false;
+    map->fileHandle = fileHandle;
+    LARGE_INTEGER fileSize = {};
+    if(!GetFileSizeEx(fileHandle, &fileSize) || (u64)fileSize.QuadPart < tiledMapDataOffset) return false;
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mappingHandle) return false;
+    map->mappingHandle = mappingHandle;
+    u8* view = (u8*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!view) return false;
+    map->view = view;
+    map->header = (TiledMapHeader*)view;
+
+    TiledMapHeader& header = *map->header;
+    u32 bytesPerTexel = GetTiledMapBytesPerTexel(header.format);
+    map->tileBytes = (u64)header.tileSize * header.tileSize * bytesPerTexel;
+    if(header.magic != tiledMapMagic
+            || header.version != tiledMapVersion
+            || bytesPerTexel == 0
+            || header.tileSize < 2 || header.tileSize % 2 != 0
+            || header.mipCount == 0 || header.mipCount > MAX_TILED_MAP_MIPS
+            || header.mips[header.mipCount - 1].tilesX * header.mips[header.mipCount - 1].tilesY != 1
+            || (u64)fileSize.QuadPart < tiledMapDataOffset + (u64)header.tileCount * map->tileBytes)
+    {
+        LOGF("Invalid tiled map file: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+void RebuildMapPageTable(StreamedMap* map)
+{
+    // Each finest tile points at finest resident tile covering it. Tile grids nest,
+    // finest tile (x, y) is covered by tile (x >> m, y >> m) of mip m.
+    TiledMapHeader& header = *map->header;
+    TiledMapMip& finest = header.mips[0];
+    // Entries are compared against previous ones, so consumers of map texels only redo changed tiles
+    map->stats.fallbackTiles = 0;
+    for(u32 tileY = 0; tileY < finest.tilesY; tileY++)
+    {
+        for(u32 tileX = 0; tileX < finest.tilesX; tileX++)
+        {
+            u32 entry = 0;
+            u32 m = 0;
+            for(; m < header.mipCount; m++)
+            {
+                TiledMapMip& mip = header.mips[m];
+                i32 slot = map->tileSlots[mip.firstTile + (tileY >> m) * mip.tilesX + (tileX >> m)];
+                if(slot >= 0 && map->slots[slot].state == MAP_TILE_SLOT_RESIDENT)
+                {
+                    entry = ((u32)slot << 8) | m;
+                    break;
+                }
+            }
+            // Coarsest tile is pinned
+            ASSERT(m < header.mipCount);
+            if(m > 0) map->stats.fallbackTiles++;
+            u32 page = tileY * finest.tilesX + tileX;
+            map->pagesChanged[page] = map->pageTable[page] != entry;
+            map->residencyChanged = map->residencyChanged || map->pagesChanged[page];
+            map->pageTable[page] = entry;
+        }
+    }
+    if(!map->residencyChanged) return;
+    render::CopyMemoryToBuffer(map->hSbPageTable, 0, (u64)finest.tilesX * finest.tilesY * sizeof(u32), map->pageTable);
+}
+
+bool OpenStreamedMap(StreamedMap* map, const char* name, const char* path)
+{
+    ASSERT(map && streamedMapCount < MAX_STREAMED_MAPS);
+    *map = {};
+    map->name = name;
+    if(!MapTiledMapFile(map, path))
+    {
+        CloseStreamedMap(map);
+        return false;
+    }
+    TiledMapHeader& header = *map->header;
+
+    // Pool is at least pinned tile plus one streamed tile, and never more than the whole map
+    u64 budgetSlots = MB(mapStreamSettings.budgetMB) / map->tileBytes;
+    map->slotCount = (u32)MIN((u64)header.tileCount, MAX(budgetSlots, (u64)2));
+    map->slots = (MapTileSlot*)AppHeapAlloc(map->slotCount * sizeof(MapTileSlot));
+    for(u32 i = 0; i < map->slotCount; i++) map->slots[i] = {};
+    map->tileSlots = (i32*)AppHeapAlloc(header.tileCount * sizeof(i32));
+    for(u32 i = 0; i < header.tileCount; i++) map->tileSlots[i] = -1;
+    u32 pageCount = header.mips[0].tilesX * header.mips[0].tilesY;
+    map->staging = (u8*)AppHeapAlloc(MAX_MAP_TILE_LOADS * map->tileBytes);
+    // No entry is all ones, so first rebuild changes every page
+    map->pageTable = (u32*)AppHeapAlloc(pageCount * sizeof(u32));
+    memset(map->pageTable, 0xFF, pageCount * sizeof(u32));
+    map->pagesChanged = (u8*)AppHeapAlloc(pageCount);
+
+    StreamedMapBlock block = {};
+    block.width = header.width;
+    block.height = header.height;
+    block.tileSize = header.tileSize;
+    block.tilesX = header.mips[0].tilesX;
+    block.tilesY = header.mips[0].tilesY;
+    block.mipCount = header.mipCount;
+    map->hUbMap = MakeGpuBuffer("Streamed map info", render::BUFFER_TYPE_UNIFORM, sizeof(StreamedMapBlock), sizeof(StreamedMapBlock), &block);
+    map->hSbPageTable = MakeGpuBuffer("Streamed map page table", render::BUFFER_TYPE_STORAGE,
+            pageCount * sizeof(u32), pageCount * sizeof(u32));
+    map->hSbTilePool = MakeGpuBuffer("Streamed map tile pool", render::BUFFER_TYPE_STORAGE,
+            map->slotCount * map->tileBytes, map->tileBytes);
+
+    // Coarsest mip is a single tile, loaded now and kept as fallback for every other tile
+    u32 coarsestTile = header.mips[header.mipCount - 1].firstTile;
+    MapTileSlot& pinnedSlot = map->slots[0];
+    pinnedSlot.state = MAP_TILE_SLOT_RESIDENT;
+    pinnedSlot.tile = coarsestTile;
+    pinnedSlot.pinned = true;
+    map->tileSlots[coarsestTile] = 0;
+    render::CopyMemoryToBuffer(map->hSbTilePool, 0, map->tileBytes,
+            map->view + tiledMapDataOffset + coarsestTile * map->tileBytes);
+    RebuildMapPageTable(map);
+
+    streamedMaps[streamedMapCount++] = map;
+    LOGF("Streaming map %s: %ux%u, %u mips, %u tiles of %u, pool of %u tiles (%.1f MB)\n",
+            name, header.width, header.height, header.mipCount, header.tileCount, header.tileSize,
+            map->slotCount, (map->slotCount * map->tileBytes) / (1024.0 * 1024.0));
+    return true;
+}
+
+void FinishMapTileLoads()
+{
+    for(i32 i = 0; i < MAP_STREAM_IO_THREADS; i++)
+    {
+        MapTileRequest request = {};
+        while(mapStreamCompletions[i].Pop(&request))
+        {
+            // Slot was free for longer than frames in flight, nothing reads it yet
+            StreamedMap* map = request.map;
+            render::CopyMemoryToBuffer(map->hSbTilePool, request.slot * map->tileBytes, map->tileBytes,
+                    map->staging + request.staging * map->tileBytes);
+            map->stagingBusy[request.staging] = false;
+            map->loadsInFlight--;
+            map->slots[request.slot].state = MAP_TILE_SLOT_RESIDENT;
+            map->pageTableDirty = true;
+            map->stats.loads++;
+            map->stats.bytesLoaded += map->tileBytes;
+        }
+    }
+}
+
+bool IssueMapTileLoad(StreamedMap* map, u32 tile, i32 slotIndex)
+{
+    i32 staging = 0;
+    while(map->stagingBusy[staging]) staging++;
+    MapTileRequest request =
+    {
+        .map = map,
+        .tile = tile,
+        .slot = slotIndex,
+        .staging = staging,
+    };
+    if(!mapStreamRequests[mapStreamNextThread % MAP_STREAM_IO_THREADS].Push(request)) return false;
+    mapStreamNextThread++;
+
+    MapTileSlot& slot = map->slots[slotIndex];
+    slot.state = MAP_TILE_SLOT_LOADING;
+    slot.tile = tile;
+    slot.lastWantedFrame = mapStreamFrame;
+    map->tileSlots[tile] = slotIndex;
+    map->stagingBusy[staging] = true;
+    map->loadsInFlight++;
+    return true;
+}
+
+bool EvictMapTile(StreamedMap* map)
+{
+    // Least recently wanted, tiles wanted this frame are never evicted
+    i32 victim = -1;
+    for(u32 i = 0; i < map->slotCount; i++)
+    {
+        MapTileSlot& slot = map->slots[i];
+        if(slot.state != MAP_TILE_SLOT_RESIDENT || slot.pinned || slot.lastWantedFrame == mapStreamFrame) continue;
+        if(victim < 0 || slot.lastWantedFrame < map->slots[victim].lastWantedFrame) victim = (i32)i;
+    }
+    if(victim < 0) return false;
+    MapTileSlot& slot = map->slots[victim];
+    map->tileSlots[slot.tile] = -1;
+    slot.state = MAP_TILE_SLOT_RETIRING;
+    slot.retireFrame = mapStreamFrame + RENDER_CONCURRENT_FRAMES;
+    map->pageTableDirty = true;
+    map->stats.evictions++;
+    return true;
+}
+
+void RequestMapTiles(StreamedMap* map, math::v3f cameraPosition, f32 terrainSize)
+{
+    for(u32 i = 0; i < map->slotCount; i++)
+    {
+        MapTileSlot& slot = map->slots[i];
+        if(slot.state == MAP_TILE_SLOT_RETIRING && mapStreamFrame >= slot.retireFrame) slot.state = MAP_TILE_SLOT_FREE;
+    }
+
+    // Wanted region is a square around camera in finest texels, doubling in size for each coarser mip
+    TiledMapHeader& header = *map->header;
+    f32 centerX = cameraPosition.x / terrainSize * header.width;
+    f32 centerY = cameraPosition.z / terrainSize * header.height;
+    f32 radiusX = mapStreamSettings.streamRadius / terrainSize * header.width;
+    f32 radiusY = mapStreamSettings.streamRadius / terrainSize * header.height;
+    u32 missing = 0;
+    // Coarse mips first, so fallback improves in steps and finest tiles get what budget is left
+    for(i32 m = (i32)header.mipCount - 1; m >= 0; m--)
+    {
+        TiledMapMip& mip = header.mips[m];
+        f32 mipTileTexels = (f32)(header.tileSize << m);
+        f32 mipRadiusX = radiusX * (f32)(1 << m);
+        f32 mipRadiusY = radiusY * (f32)(1 << m);
+        i32 minX = MIN(MAX((i32)floorf((centerX - mipRadiusX) / mipTileTexels), 0), (i32)mip.tilesX - 1);
+        i32 maxX = MIN(MAX((i32)floorf((centerX + mipRadiusX) / mipTileTexels), 0), (i32)mip.tilesX - 1);
+        i32 minY = MIN(MAX((i32)floorf((centerY - mipRadiusY) / mipTileTexels), 0), (i32)mip.tilesY - 1);
+        i32 maxY = MIN(MAX((i32)floorf((centerY + mipRadiusY) / mipTileTexels), 0), (i32)mip.tilesY - 1);
+        for(i32 tileY = minY; tileY <= maxY; tileY++)
+        {
+            for(i32 tileX = minX; tileX <= maxX; tileX++)
+            {
+                u32 tile = mip.firstTile + tileY * mip.tilesX + tileX;
+                i32 slot = map->tileSlots[tile];
+                if(slot >= 0)
+                {
+                    map->slots[slot].lastWantedFrame = mapStreamFrame;
+                    continue;
+                }
+                if(map->loadsInFlight >= MAX_MAP_TILE_LOADS) continue;
+                i32 freeSlot = -1;
+                for(u32 i = 0; i < map->slotCount && freeSlot < 0; i++)
+                {
+                    if(map->slots[i].state == MAP_TILE_SLOT_FREE) freeSlot = (i32)i;
+                }
+                if(freeSlot < 0 || !IssueMapTileLoad(map, tile, freeSlot)) missing++;
+            }
+        }
+    }
+
+    // Tiles that found no free slot wait for evicted ones to retire, meanwhile coarser mips are shown
+    for(u32 i = 0; i < missing; i++)
+    {
+        if(!EvictMapTile(map)) break;
+    }
+}
+
+void UpdateMapStreaming()
+{
+    mapStreamFrame++;
+    FinishMapTileLoads();
+    for(u32 i = 0; i < streamedMapCount; i++)
+    {
+        RequestMapTiles(streamedMaps[i], appCamera.position, terrainConstants.terrainSize);
+    }
+    // Replayed frames must not depend on I/O timing, so requested tiles land in the frame that wanted them
+    if(IsTraceReplaying())
+    {
+        bool loading = true;
+        while(loading)
+        {
+            FinishMapTileLoads();
+            loading = false;
+            for(u32 i = 0; i < streamedMapCount; i++)
+            {
+                loading = loading || streamedMaps[i]->loadsInFlight > 0;
+            }
+            if(loading) std::this_thread::yield();
+        }
+    }
+    for(u32 i = 0; i < streamedMapCount; i++)
+    {
+        StreamedMap* map = streamedMaps[i];
+        // Loads and evictions can leave every entry as it was, e.g. a coarse tile where finer ones are resident
+        map->residencyChanged = false;
+        if(map->pageTableDirty) RebuildMapPageTable(map);
+        map->pageTableDirty = false;
+    }
+}
+
+void UpdateMapStreamUI()
+{
+    egui::SliderF32(IStr("Map Stream Radius"), &mapStreamSettings.streamRadius, 8, 512);
+    for(u32 i = 0; i < streamedMapCount; i++)
+    {
+        StreamedMap* map = streamedMaps[i];
+        u32 resident = 0;
+        for(u32 s = 0; s < map->slotCount; s++)
+        {
+            if(map->slots[s].state == MAP_TILE_SLOT_RESIDENT) resident++;
+        }
+        egui::Text("Map %s: %u/%u tiles resident, %u loading, %u tiles on fallback mip, %u loads, %u evictions",
+                map->name,
+                resident,
+                map->slotCount,
+                map->loadsInFlight,
+                map->stats.fallbackTiles,
+                map->stats.loads,
+                map->stats.evictions);
+    }
+}
+
+u8 ReadTiledMapTexel(const StreamedMap* map, u32 x, u32 y)
+{
+    ASSERT(map && map->header);
+    const TiledMapHeader& header = *map->header;
+    ASSERT(GetTiledMapBytesPerTexel(header.format) == 1);
+    const TiledMapMip& mip = header.mips[0];
+    x = MIN(x, mip.width - 1);
+    y = MIN(y, mip.height - 1);
+    u32 tile = mip.firstTile + (y / header.tileSize) * mip.tilesX + x / header.tileSize;
+    u64 texel = (u64)(y % header.tileSize) * header.tileSize + x % header.tileSize;
+    return map->view[tiledMapDataOffset + tile * map->tileBytes + texel];
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,194 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/math.hpp"
+#include "engine/src/asset/asset.hpp"
+#include "engine/src/render/render.hpp"
+
+#include "app/sim.hpp"
+
+#include <atomic>
+#include <thread>
+
+// Out of core authored maps (grass density, terrain height). On disk a map is a mip chain of fixed
+// size square tiles (.tmap, see TiledMapHeader), built offline from an image with --build-maps.
+// The file is memory mapped, and I/O threads copy tiles near the camera out of the mapping into
+// staging, so page faults on cold tiles never block the render thread. Render side uploads finished
+// tiles into slots of a GPU tile pool sized by a memory budget, evicting the least recently wanted
+// tile when the pool is full. Evicted slots are reused only after frames in flight that may read them retire.
+// Shaders read a map through a page table with one entry per finest mip tile, pointing at the finest
+// resident tile covering it. Coarsest mip is loaded when the map is opened and never evicted,
+// so a missing tile falls back to a coarser mip instead of stalling the frame.
+
+#define GRASS_DENSITY_MAP_PATH "resources/maps/grass_density.tmap"
+#define GRASS_SPECIES_MAP_PATH "resources/maps/grass_species.tmap"
+
+namespace ty
+{
+namespace Grass
+{
+
+enum TiledMapFormat
+{
+    TILED_MAP_FORMAT_R16,       // Height maps, unorm
+    TILED_MAP_FORMAT_R8_UNORM,  // Density and selector masks, e.g. grass species
+};
+
+const u32 tiledMapMagic = 0x50414D54;      // "TMAP"
+const u32 tiledMapVersion = 2;     // 2: density maps are unorm, no sRGB format
+const u32 tiledMapDefaultTileSize = 128;
+// Tile data starts page aligned, so tiles of a power of two size never straddle extra pages
+const u64 tiledMapDataOffset = KB(4);
+
+#define MAX_TILED_MAP_MIPS 16
+
+struct TiledMapMip
+{
+    u32 width = 0;              // Texels, each mip is half of previous one rounded up
+    u32 height = 0;
+    u32 tilesX = 0;
+    u32 tilesY = 0;
+    u32 firstTile = 0;          // Tiles are stored by mip, then row major within mip
+    u32 padding0[3];
+};
+static_assert(sizeof(TiledMapMip) == 32);
+
+struct TiledMapHeader
+{
+    u32 magic = tiledMapMagic;
+    u32 version = tiledMapVersion;
+    u32 format = TILED_MAP_FORMAT_R8_UNORM;
+    u32 width = 0;
+    u32 height = 0;
+    u32 tileSize = 0;           // Texels per side, edge tiles are padded by clamping
+    u32 mipCount = 0;           // Last mip fits in a single tile
+    u32 tileCount = 0;
+    TiledMapMip mips[MAX_TILED_MAP_MIPS];
+};
+static_assert(sizeof(TiledMapHeader) <= tiledMapDataOffset);
+
+// Read by shaders along with page table and tile pool
+struct StreamedMapBlock
+{
+    u32 width = 0;
+    u32 height = 0;
+    u32 tileSize = 0;
+    u32 tilesX = 0;             // Finest mip tiles, page table is tilesX * tilesY entries
+    u32 tilesY = 0;
+    u32 mipCount = 0;
+    u32 padding0[2];
+};
+
+enum MapTileSlotState
+{
+    MAP_TILE_SLOT_FREE,
+    MAP_TILE_SLOT_LOADING,      // Assigned to a tile, I/O thread reading it
+    MAP_TILE_SLOT_RESIDENT,
+    MAP_TILE_SLOT_RETIRING,     // Evicted, frames in flight may still read it
+};
+
+struct MapTileSlot
+{
+    MapTileSlotState state = MAP_TILE_SLOT_FREE;
+    u32 tile = 0;
+    u32 lastWantedFrame = 0;    // LRU key
+    u32 retireFrame = 0;
+    bool pinned = false;
+};
+
+// Loads in flight per map, also the number of staging blocks
+#define MAX_MAP_TILE_LOADS 16
+
+struct StreamedMap;
+
+struct MapTileRequest
+{
+    StreamedMap* map = NULL;
+    u32 tile = 0;
+    i32 slot = -1;
+    i32 staging = -1;
+};
+
+struct StreamedMapStats
+{
+    u32 loads = 0;
+    u32 evictions = 0;
+    u32 fallbackTiles = 0;      // Finest tiles currently served by a coarser mip
+    u64 bytesLoaded = 0;
+};
+
+struct StreamedMap
+{
+    const char* name = NULL;
+    void* fileHandle = NULL;
+    void* mappingHandle = NULL;
+    u8* view = NULL;
+    TiledMapHeader* header = NULL;
+    u64 tileBytes = 0;
+
+    // Residency, render side
+    i32* tileSlots = NULL;      // Per tile, slot holding it or -1
+    MapTileSlot* slots = NULL;
+    u32 slotCount = 0;
+    bool pageTableDirty = false;
+    bool residencyChanged = false;  // Page table entries changed this frame
+    u32* pageTable = NULL;      // Per finest tile, slot << 8 | mip, CPU copy of GPU page table
+    u8* pagesChanged = NULL;    // Per finest tile, entry changed this frame. Valid while residencyChanged.
+    u8* staging = NULL;         // MAX_MAP_TILE_LOADS tiles, written by I/O threads
+    bool stagingBusy[MAX_MAP_TILE_LOADS] = {};
+    u32 loadsInFlight = 0;
+    StreamedMapStats stats = {};
+
+    // GPU resources
+    Handle<render::Buffer> hUbMap;
+    Handle<render::Buffer> hSbPageTable;
+    Handle<render::Buffer> hSbTilePool;
+};
+
+struct MapStreamSettings
+{
+    u32 budgetMB = 16;          // GPU tile pool size per map
+    f32 streamRadius = 64.f;    // World units around camera where finest mip is wanted, doubles per mip
+};
+
+#define MAP_STREAM_IO_THREADS 2
+#define MAX_STREAMED_MAPS 4
+
+inline MapStreamSettings mapStreamSettings = {};
+inline u32 mapStreamFrame = 0;
+inline SpscQueue<MapTileRequest, MAX_MAP_TILE_LOADS> mapStreamRequests[MAP_STREAM_IO_THREADS];
+inline SpscQueue<MapTileRequest, MAX_MAP_TILE_LOADS> mapStreamCompletions[MAP_STREAM_IO_THREADS];
+inline std::thread mapStreamThreads[MAP_STREAM_IO_THREADS];
+inline std::atomic<bool> mapStreamQuit = false;
+inline u32 mapStreamNextThread = 0;
+inline StreamedMap* streamedMaps[MAX_STREAMED_MAPS];
+inline u32 streamedMapCount = 0;
+
+inline StreamedMap streamedGrassDensity = {};  // Feeds grass placement and terrain far field
+inline StreamedMap streamedGrassSpecies = {};  // Grass placement picks blade species from it
+
+void ParseMapStreamSettings(const wchar_t* cmdLine);
+// Writes a tiled map with its mip chain. Texels are tightly packed in format.
+bool WriteTiledMap(const char* path, TiledMapFormat format, const void* texels, u32 width, u32 height, u32 tileSize = tiledMapDefaultTileSize);
+// Converts R channel of density image to GRASS_DENSITY_MAP_PATH
+bool BuildGrassDensityMapFile(Handle<asset::Image> hAsset);
+// Converts R channel of authored species image to GRASS_SPECIES_MAP_PATH,
+// or writes procedural patches when there is no authored image
+bool BuildGrassSpeciesMapFile();
+// Offline entry point, builds map files from authored images without initializing rendering
+bool BuildDefaultMapFiles();
+
+// Starts I/O threads, maps are opened after
+void InitMapStreaming();
+// Stops I/O threads and closes every opened map
+void ShutdownMapStreaming();
+// Maps file and makes GPU resources. Coarsest mip is loaded before returning.
+bool OpenStreamedMap(StreamedMap* map, const char* name, const char* path);
+// Render side, once per frame before map consumers. Uploads finished tiles, requests tiles
+// near camera position and rebuilds page table when residency changed.
+void UpdateMapStreaming();
+void UpdateMapStreamUI();
+// Finest mip texel of an 8 bit map, read from the mapped file. Touches file pages, not for the render loop.
+u8 ReadTiledMapTexel(const StreamedMap* map, u32 x, u32 y);
+
+};  // namespace Grass
+};  // namespace ty
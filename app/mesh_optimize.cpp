@@ -0,0 +1,385 @@
+#include "app/mesh_optimize.hpp"
+#include "engine/src/core/debug.hpp"
+
+#include "app/frame_memory.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+f32 ComputeACMR(u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize)
+{
+    ASSERT(cacheSize <= meshOptimizeCacheSize);
+    if(indexCount < 3) return 0;
+    u32 cache[meshOptimizeCacheSize];
+    u32 cacheCount = 0;
+    u32 cacheHead = 0;
+    u32 misses = 0;
+    for(u32 i = 0; i < indexCount; i++)
+    {
+        u32 v = indices[i];
+        ASSERT(v < vertexCount);
+        bool hit = false;
+        for(u32 j = 0; j < cacheCount; j++)
+        {
+            if(cache[j] == v)
+            {
+                hit = true;
+                break;
+            }
+        }
+        if(hit) continue;
+        misses++;
+        // FIFO, oldest entry is replaced
+        if(cacheCount < cacheSize) cache[cacheCount++] = v;
+        else
+        {
+            cache[cacheHead] = v;
+            cacheHead = (cacheHead + 1) % cacheSize;
+        }
+    }
+    return (f32)misses / (indexCount / 3);
+}
+
+static f32 ForsythVertexScore(i32 cachePosition, u32 activeTriangles)
+{
+    // No triangles left to draw, vertex is never picked again
+    if(activeTriangles == 0) return -1.f;
+    f32 score = 0;
+    if(cachePosition >= 0)
+    {
+        // Last triangle's vertices get a fixed score, so the next triangle doesn't just reuse its edge
+        if(cachePosition < 3) score = 0.75f;
+        else score = powf(1.f - (f32)(cachePosition - 3) / (meshOptimizeCacheSize - 3), 1.5f);
+    }
+    // Favour vertices with few triangles left, so they leave cache finished instead of being reloaded
+    score += 2.f / sqrtf((f32)activeTriangles);
+    return score;
+}
+
+void OptimizeVertexCache(u32* indices, u32 indexCount, u32 vertexCount)
+{
+    ASSERT(indexCount % 3 == 0);
+    u32 triangleCount = indexCount / 3;
+    if(triangleCount == 0) return;
+
+    // Triangles using each vertex, as ranges of one shared list. Active ranges shrink as triangles are emitted.
+    u32* vertexTriangleOffsets = (u32*)AppHeapAlloc(sizeof(u32) * (vertexCount + 1));
+    u32* vertexActiveTriangles = (u32*)AppHeapAlloc(sizeof(u32) * vertexCount);
+    u32* vertexTriangles = (u32*)AppHeapAlloc(sizeof(u32) * indexCount);
+    i32* vertexCachePositions = (i32*)AppHeapAlloc(sizeof(i32) * vertexCount);
+    f32* vertexScores = (f32*)AppHeapAlloc(sizeof(f32) * vertexCount);
+    bool* triangleEmitted = (bool*)AppHeapAlloc(sizeof(bool) * triangleCount);
+    u32* output = (u32*)AppHeapAlloc(sizeof(u32) * indexCount);
+
+    memset(vertexActiveTriangles, 0, sizeof(u32) * vertexCount);
+    for(u32 i = 0; i < indexCount; i++)
+    {
+        vertexActiveTriangles[indices[i]]++;
+    }
+    vertexTriangleOffsets[0] = 0;
+    for(u32 v = 0; v < vertexCount; v++)
+    {
+        vertexTriangleOffsets[v + 1] = vertexTriangleOffsets[v] + vertexActiveTriangles[v];
+        vertexActiveTriangles[v] = 0;
+    }
+    for(u32 t = 0; t < triangleCount; t++)
+    {
+        for(u32 k = 0; k < 3; k++)
+        {
+            u32 v = indices[t * 3 + k];
+            vertexTriangles[vertexTriangleOffsets[v] + vertexActiveTriangles[v]++] = t;
+        }
+    }
+    for(u32 v = 0; v < vertexCount; v++)
+    {
+        vertexCachePositions[v] = -1;
+        vertexScores[v] = ForsythVertexScore(-1, vertexActiveTriangles[v]);
+    }
+    memset(triangleEmitted, 0, sizeof(bool) * triangleCount);
+
+    // Cache holds up to 3 extra entries while a triangle is added, those are evicted right after
+    u32 cache[meshOptimizeCacheSize + 3];
+    u32 cacheCount = 0;
+    i32 bestTriangle = -1;
+    u32 scanCursor = 0;     // Every triangle before this one was emitted
+    for(u32 emitted = 0; emitted < triangleCount; emitted++)
+    {
+        if(bestTriangle < 0)
+        {
+            // Nothing left around cached vertices, start over from next unemitted triangle
+            while(triangleEmitted[scanCursor]) scanCursor++;
+            bestTriangle = (i32)scanCursor;
+        }
+        u32 t = (u32)bestTriangle;
+        u32* triangle = indices + t * 3;
+        triangleEmitted[t] = true;
+        for(u32 k = 0; k < 3; k++)
+        {
+            output[emitted * 3 + k] = triangle[k];
+            u32 v = triangle[k];
+            u32* vertexList = vertexTriangles + vertexTriangleOffsets[v];
+            for(u32 j = 0; j < vertexActiveTriangles[v]; j++)
+            {
+                if(vertexList[j] != t) continue;
+                vertexList[j] = vertexList[vertexActiveTriangles[v] - 1];
+                vertexActiveTriangles[v]--;
+                break;
+            }
+        }
+
+        // Emitted triangle's vertices move to cache front, the rest shift back
+        u32 newCache[meshOptimizeCacheSize + 3];
+        u32 newCacheCount = 0;
+        for(u32 k = 0; k < 3; k++)
+        {
+            bool duplicate = false;
+            for(u32 j = 0; j < newCacheCount; j++) duplicate |= newCache[j] == triangle[k];
+            if(!duplicate) newCache[newCacheCount++] = triangle[k];
+        }
+        for(u32 i = 0; i < cacheCount; i++)
+        {
+            u32 v = cache[i];
+            if(v == triangle[0] || v == triangle[1] || v == triangle[2]) continue;
+            newCache[newCacheCount++] = v;
+        }
+        for(u32 i = 0; i < newCacheCount; i++)
+        {
+            u32 v = newCache[i];
+            vertexCachePositions[v] = i < meshOptimizeCacheSize ? (i32)i : -1;
+            vertexScores[v] = ForsythVertexScore(vertexCachePositions[v], vertexActiveTriangles[v]);
+        }
+
+        // Only triangles around changed vertices changed score, best of them goes next
+        bestTriangle = -1;
+        f32 bestScore = -1.f;
+        for(u32 i = 0; i < newCacheCount; i++)
+        {
+            u32 v = newCache[i];
+            u32* vertexList = vertexTriangles + vertexTriangleOffsets[v];
+            for(u32 j = 0; j < vertexActiveTriangles[v]; j++)
+            {
+                u32* candidate = indices + vertexList[j] * 3;
+                f32 score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+                if(score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = (i32)vertexList[j];
+                }
+            }
+        }
+
+        cacheCount = MIN(newCacheCount, meshOptimizeCacheSize);
+        memcpy(cache, newCache, sizeof(u32) * cacheCount);
+    }
+    memcpy(indices, output, sizeof(u32) * indexCount);
+
+    AppHeapFree(output);
+    AppHeapFree(triangleEmitted);
+    AppHeapFree(vertexScores);
+    AppHeapFree(vertexCachePositions);
+    AppHeapFree(vertexTriangles);
+    AppHeapFree(vertexActiveTriangles);
+    AppHeapFree(vertexTriangleOffsets);
+}
+
+u32 OptimizeVertexFetch(u32* indices, u32 indexCount, u32 vertexCount, u32* remap)
+{
+    const u32 unassigned = 0xFFFFFFFF;
+    u32* newIndices = (u32*)AppHeapAlloc(sizeof(u32) * vertexCount);
+    memset(newIndices, 0xFF, sizeof(u32) * vertexCount);
+    u32 newVertexCount = 0;
+    for(u32 i = 0; i < indexCount; i++)
+    {
+        u32 v = indices[i];
+        if(newIndices[v] == unassigned)
+        {
+            newIndices[v] = newVertexCount;
+            remap[newVertexCount] = v;
+            newVertexCount++;
+        }
+        indices[i] = newIndices[v];
+    }
+    AppHeapFree(newIndices);
+    return newVertexCount;
+}
+
+static u16 QuantizeUnorm16(f32 value)
+{
+    return (u16)(CLAMP(value, 0.f, 1.f) * 65535.f + 0.5f);
+}
+
+static i16 QuantizeSnorm16(f32 value)
+{
+    return (i16)roundf(CLAMP(value, -1.f, 1.f) * 32767.f);
+}
+
+QuantizedMesh MakeQuantizedMesh(Handle<asset::Model> hAsset, u32 attributeFlags)
+{
+    //TODO(caio): No proper materials, just using index 0 from model asset
+    asset::Model& asset = asset::models[hAsset];
+    const u32 assetStride = 8;      // Position, normal, uv floats
+    u32 assetVertexCount = (u32)(asset.vertices.count / assetStride);
+    u32* assetIndices = asset.groups[0].indices.data;
+    u32 indexCount = (u32)asset.groups[0].indices.count;
+    ASSERT(attributeFlags & MESH_ATTRIBUTE_POSITION);
+    ASSERT(indexCount % 3 == 0);
+
+    QuantizedMesh result = {};
+    if(attributeFlags & MESH_ATTRIBUTE_POSITION)
+    {
+        result.attributes[result.attributeCount++] = render::VERTEX_ATTR_RGBA16_UNORM;
+        result.vertexStride += 4 * sizeof(u16);
+    }
+    if(attributeFlags & MESH_ATTRIBUTE_NORMAL)
+    {
+        result.attributes[result.attributeCount++] = render::VERTEX_ATTR_RGBA16_SNORM;
+        result.vertexStride += 4 * sizeof(i16);
+    }
+    if(attributeFlags & MESH_ATTRIBUTE_UV)
+    {
+        result.attributes[result.attributeCount++] = render::VERTEX_ATTR_RG16_UNORM;
+        result.vertexStride += 2 * sizeof(u16);
+    }
+
+    // Quantization range is mesh bounds
+    math::v3f positionMax = {};
+    math::v2f uvMax = {};
+    for(u32 v = 0; v < assetVertexCount; v++)
+    {
+        f32* src = asset.vertices.data + v * assetStride;
+        math::v3f position = { src[0], src[1], src[2] };
+        math::v2f uv = { src[6], src[7] };
+        if(v == 0)
+        {
+            result.positionMin = position;
+            positionMax = position;
+            result.uvMin = uv;
+            uvMax = uv;
+            continue;
+        }
+        result.positionMin = { MIN(result.positionMin.x, position.x), MIN(result.positionMin.y, position.y), MIN(result.positionMin.z, position.z) };
+        positionMax = { MAX(positionMax.x, position.x), MAX(positionMax.y, position.y), MAX(positionMax.z, position.z) };
+        result.uvMin = { MIN(result.uvMin.x, uv.x), MIN(result.uvMin.y, uv.y) };
+        uvMax = { MAX(uvMax.x, uv.x), MAX(uvMax.y, uv.y) };
+    }
+    result.positionExtent = { positionMax.x - result.positionMin.x, positionMax.y - result.positionMin.y, positionMax.z - result.positionMin.z };
+    result.uvExtent = { uvMax.x - result.uvMin.x, uvMax.y - result.uvMin.y };
+    // Flat axes quantize to 0, extent is never divided by there
+    math::v3f positionScale =
+    {
+        result.positionExtent.x > 0 ? 1.f / result.positionExtent.x : 0,
+        result.positionExtent.y > 0 ? 1.f / result.positionExtent.y : 0,
+        result.positionExtent.z > 0 ? 1.f / result.positionExtent.z : 0,
+    };
+    math::v2f uvScale =
+    {
+        result.uvExtent.x > 0 ? 1.f / result.uvExtent.x : 0,
+        result.uvExtent.y > 0 ? 1.f / result.uvExtent.y : 0,
+    };
+
+    u32 stride = result.vertexStride;
+    u8* quantized = (u8*)AppHeapAlloc((u64)assetVertexCount * stride);
+    memset(quantized, 0, (u64)assetVertexCount * stride);
+    for(u32 v = 0; v < assetVertexCount; v++)
+    {
+        f32* src = asset.vertices.data + v * assetStride;
+        u8* dst = quantized + (u64)v * stride;
+        if(attributeFlags & MESH_ATTRIBUTE_POSITION)
+        {
+            u16* position = (u16*)dst;
+            position[0] = QuantizeUnorm16((src[0] - result.positionMin.x) * positionScale.x);
+            position[1] = QuantizeUnorm16((src[1] - result.positionMin.y) * positionScale.y);
+            position[2] = QuantizeUnorm16((src[2] - result.positionMin.z) * positionScale.z);
+            dst += 4 * sizeof(u16);
+        }
+        if(attributeFlags & MESH_ATTRIBUTE_NORMAL)
+        {
+            i16* normal = (i16*)dst;
+            normal[0] = QuantizeSnorm16(src[3]);
+            normal[1] = QuantizeSnorm16(src[4]);
+            normal[2] = QuantizeSnorm16(src[5]);
+            dst += 4 * sizeof(i16);
+        }
+        if(attributeFlags & MESH_ATTRIBUTE_UV)
+        {
+            u16* uv = (u16*)dst;
+            uv[0] = QuantizeUnorm16((src[6] - result.uvMin.x) * uvScale.x);
+            uv[1] = QuantizeUnorm16((src[7] - result.uvMin.y) * uvScale.y);
+        }
+    }
+
+    // Weld vertices that are identical after stripping and quantization (OBJ import splits
+    // vertices per normal/uv combination), with an open addressing table of first occurrences
+    u32 tableSize = 1;
+    while(tableSize < assetVertexCount * 2) tableSize <<= 1;
+    u32* table = (u32*)AppHeapAlloc(sizeof(u32) * tableSize);
+    memset(table, 0xFF, sizeof(u32) * tableSize);
+    u32* weldRemap = (u32*)AppHeapAlloc(sizeof(u32) * assetVertexCount);
+    u32* weldSource = (u32*)AppHeapAlloc(sizeof(u32) * assetVertexCount);
+    u32 weldedCount = 0;
+    for(u32 v = 0; v < assetVertexCount; v++)
+    {
+        u8* vertex = quantized + (u64)v * stride;
+        // FNV-1a
+        u32 hash = 2166136261u;
+        for(u32 i = 0; i < stride; i++) hash = (hash ^ vertex[i]) * 16777619u;
+        u32 slot = hash & (tableSize - 1);
+        while(table[slot] != 0xFFFFFFFF
+                && memcmp(quantized + (u64)weldSource[table[slot]] * stride, vertex, stride) != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if(table[slot] == 0xFFFFFFFF)
+        {
+            table[slot] = weldedCount;
+            weldSource[weldedCount] = v;
+            weldedCount++;
+        }
+        weldRemap[v] = table[slot];
+    }
+
+    result.indexCount = indexCount;
+    result.indices = (u32*)AppHeapAlloc(sizeof(u32) * indexCount);
+    for(u32 i = 0; i < indexCount; i++)
+    {
+        result.indices[i] = weldRemap[assetIndices[i]];
+    }
+
+    result.acmrBefore = ComputeACMR(assetIndices, indexCount, assetVertexCount);
+    OptimizeVertexCache(result.indices, indexCount, weldedCount);
+    u32* fetchRemap = (u32*)AppHeapAlloc(sizeof(u32) * MAX(weldedCount, 1));
+    result.vertexCount = OptimizeVertexFetch(result.indices, indexCount, weldedCount, fetchRemap);
+    result.vertices = (u8*)AppHeapAlloc((u64)result.vertexCount * stride);
+    for(u32 v = 0; v < result.vertexCount; v++)
+    {
+        memcpy(result.vertices + (u64)v * stride, quantized + (u64)weldSource[fetchRemap[v]] * stride, stride);
+    }
+    result.acmrAfter = ComputeACMR(result.indices, indexCount, result.vertexCount);
+
+    LOGF("Mesh import: %u -> %u vertices, %u -> %u bytes per vertex, ACMR %.3f -> %.3f (%u entry FIFO)\n",
+            assetVertexCount, result.vertexCount,
+            (u32)(assetStride * sizeof(f32)), stride,
+            result.acmrBefore, result.acmrAfter, meshVertexCacheSize);
+
+    AppHeapFree(fetchRemap);
+    AppHeapFree(weldSource);
+    AppHeapFree(weldRemap);
+    AppHeapFree(table);
+    AppHeapFree(quantized);
+    return result;
+}
+
+void DestroyQuantizedMesh(QuantizedMesh* mesh)
+{
+    if(mesh->vertices) AppHeapFree(mesh->vertices);
+    if(mesh->indices) AppHeapFree(mesh->indices);
+    *mesh = {};
+}
+
+};  // namespace Grass
+};  // namespace ty
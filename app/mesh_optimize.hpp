@@ -0,0 +1,59 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/math.hpp"
+#include "engine/src/asset/asset.hpp"
+#include "engine/src/render/render.hpp"
+
+// Model import path for meshes drawn many times per frame. Keeps only the attributes a pipeline
+// reads, quantizes them to 16 bit relative to the mesh bounds, welds vertices that became identical,
+// orders triangles for post-transform cache reuse (Forsyth's linear speed algorithm) and vertices
+// in first use order for fetch locality. OBJ assets are position, normal, uv floats (32 bytes).
+
+namespace ty
+{
+namespace Grass
+{
+
+enum MeshAttributeFlags
+{
+    MESH_ATTRIBUTE_POSITION = 1 << 0,   // RGBA16 unorm in bounds, w unused
+    MESH_ATTRIBUTE_NORMAL = 1 << 1,     // RGBA16 snorm, w unused
+    MESH_ATTRIBUTE_UV = 1 << 2,         // RG16 unorm in uv bounds
+};
+
+const u32 meshVertexCacheSize = 16;     // FIFO size for ACMR reports, conservative for current GPUs
+const u32 meshOptimizeCacheSize = 32;   // LRU size Forsyth scores are tuned for
+
+struct QuantizedMesh
+{
+    u8* vertices = NULL;
+    u32 vertexCount = 0;
+    u32 vertexStride = 0;               // In bytes
+    u32* indices = NULL;
+    u32 indexCount = 0;
+    render::VertexAttribute attributes[3];
+    u32 attributeCount = 0;
+
+    // Dequantized value = min + unorm * extent
+    math::v3f positionMin = {};
+    math::v3f positionExtent = {};
+    math::v2f uvMin = {};
+    math::v2f uvExtent = {};
+
+    // Average transformed vertices per triangle, 0.5 is ideal and 3 is no reuse
+    f32 acmrBefore = 0;
+    f32 acmrAfter = 0;
+};
+
+f32 ComputeACMR(u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize = meshVertexCacheSize);
+// Reorders triangles in place
+void OptimizeVertexCache(u32* indices, u32 indexCount, u32 vertexCount);
+// Renumbers vertices in first use order, writes old vertex index of each new one to remap.
+// Returns new vertex count, unreferenced vertices are dropped.
+u32 OptimizeVertexFetch(u32* indices, u32 indexCount, u32 vertexCount, u32* remap);
+
+QuantizedMesh MakeQuantizedMesh(Handle<asset::Model> hAsset, u32 attributeFlags);
+void DestroyQuantizedMesh(QuantizedMesh* mesh);
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,44 @@
+#include "app/present.hpp"
+#include "engine/src/core/debug.hpp"
+
+#include <wchar.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void ParsePresentConfig(const wchar_t* cmdLine)
+{
+    presentConfig = {};
+    if(!cmdLine) return;
+
+    if(wcsstr(cmdLine, L"--present-mode=mailbox")) presentConfig.presentMode = render::PRESENT_MODE_MAILBOX;
+    else if(wcsstr(cmdLine, L"--present-mode=immediate")) presentConfig.presentMode = render::PRESENT_MODE_IMMEDIATE;
+    else if(wcsstr(cmdLine, L"--present-mode=fifo")) presentConfig.presentMode = render::PRESENT_MODE_FIFO;
+
+    const wchar_t* imageCountArg = wcsstr(cmdLine, L"--swapchain-images=");
+    if(imageCountArg)
+    {
+        i32 imageCount = (i32)wcstol(imageCountArg + wcslen(L"--swapchain-images="), NULL, 10);
+        // Fewer than 2 can't present while rendering, engine clamps to surface limits
+        presentConfig.swapChainImageCount = (u32)CLAMP(imageCount, 2, 8);
+    }
+
+    if(wcsstr(cmdLine, L"--present-direct")) presentConfig.path = PRESENT_PATH_DIRECT;
+
+    const char* modeNames[] = { "fifo", "mailbox", "immediate" };
+    LOGF("Present: %s, %u swap chain images, %s path\n",
+            modeNames[presentConfig.presentMode],
+            presentConfig.swapChainImageCount,
+            presentConfig.path == PRESENT_PATH_DIRECT ? "direct" : "copy");
+}
+
+bool IsPresentDirect(f32 scale)
+{
+    // Swap chain image can't be rendered at a different size, scaled frames still need a blit
+    return presentConfig.path == PRESENT_PATH_DIRECT && scale == 1.f;
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,36 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/render/render.hpp"
+
+// Startup presentation settings, from command line:
+//   --present-mode=fifo|mailbox|immediate
+//   --swapchain-images=N
+//   --present-direct    Render straight into the acquired swap chain image while render scale is 1,
+//                       only falling back to an offscreen target and scaling blit below that.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum PresentPath
+{
+    PRESENT_PATH_COPY,      // Offscreen main target, copied to swap chain every frame
+    PRESENT_PATH_DIRECT,
+};
+
+struct PresentConfig
+{
+    render::PresentMode presentMode = render::PRESENT_MODE_FIFO;
+    u32 swapChainImageCount = 3;
+    PresentPath path = PRESENT_PATH_COPY;
+};
+
+inline PresentConfig presentConfig = {};
+
+void ParsePresentConfig(const wchar_t* cmdLine);
+// Whether main target for given render scale is the swap chain image
+bool IsPresentDirect(f32 scale);
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,123 @@
+#include "app/redraw.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/input.hpp"
+#include "engine/src/render/egui.hpp"
+
+#include "app/grass.hpp"
+#include "app/sim.hpp"
+#include "app/capture.hpp"
+
+#include <string.h>
+#include <thread>
+#include <wchar.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+void ParseRedrawSettings(const wchar_t* cmdLine)
+{
+    redrawSettings = {};
+    if(!cmdLine) return;
+    redrawSettings.onDemand = wcsstr(cmdLine, L"--always-redraw") == NULL;
+    const wchar_t* idleFPSArg = wcsstr(cmdLine, L"--idle-fps=");
+    if(idleFPSArg)
+    {
+        redrawSettings.idleFPS = MAX(0.f, (f32)wcstod(idleFPSArg + wcslen(L"--idle-fps="), NULL));
+    }
+    redrawIdleFPS = redrawSettings.idleFPS;
+}
+
+void InitRedraw()
+{
+    redrawState = {};
+    redrawState.lastCamera = simCamera;
+    redrawState.activeTimer.Start();
+    redrawState.idleTickTimer.Start();
+    redrawFramesDrawn = 0;
+    redrawFramesSkipped = 0;
+    // First frames always draw
+    redrawRequested = true;
+}
+
+bool HasRedrawInput()
+{
+    math::v2f mouseDelta = input::GetMouseDelta();
+    if(mouseDelta.x != 0 || mouseDelta.y != 0) return true;
+    for(i32 i = 0; i < input::MOUSE_COUNT; i++)
+    {
+        if(input::IsMouseDown((input::MouseButton)i)) return true;
+    }
+    for(i32 i = 0; i < input::KEY_COUNT; i++)
+    {
+        if(input::IsKeyDown((input::KeyboardKey)i)) return true;
+    }
+    return false;
+}
+
+bool ShouldRedraw()
+{
+    RedrawState& state = redrawState;
+    u32 reasons = 0;
+    if(!redrawSettings.onDemand || captureSettings.enabled) reasons |= REDRAW_FORCED;
+    if(HasRedrawInput()) reasons |= REDRAW_INPUT;
+    if(memcmp(&simCamera, &state.lastCamera, sizeof(Camera)) != 0) reasons |= REDRAW_CAMERA;
+    // Published on render side, a stale read only delays the change by one iteration
+    if(redrawAnimating.load()) reasons |= REDRAW_ANIMATION;
+    if(redrawRequested.exchange(false)) reasons |= REDRAW_REQUESTED;
+    if(reasons) state.activeTimer.Start();
+
+    state.activeTimer.Stop();
+    state.idleTickTimer.Stop();
+    bool active = state.activeTimer.GetElapsedS() < redrawSettings.activeHoldS;
+    f32 idleFPS = redrawIdleFPS.load();
+    if(!reasons && !active && idleFPS > 0
+            && state.idleTickTimer.GetElapsedS() >= 1.0 / idleFPS)
+    {
+        reasons |= REDRAW_IDLE_TICK;
+    }
+
+    if(!reasons && !active)
+    {
+        state.skipping = true;
+        redrawFramesSkipped++;
+        return false;
+    }
+    state.resumed = state.skipping;
+    state.skipping = false;
+    state.reasons = reasons;
+    state.lastCamera = simCamera;
+    state.idleTickTimer.Start();
+    redrawFramesDrawn++;
+    return true;
+}
+
+void WaitRedrawIdle()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(redrawSettings.idlePollMS));
+}
+
+void UpdateRedrawSettings()
+{
+    TraceSettings settings = GetTraceSettings();
+    if(memcmp(&settings, &redrawLastSettings, sizeof(TraceSettings)) != 0 || grassTilePlaceCount > 0)
+    {
+        redrawRequested = true;
+    }
+    redrawLastSettings = settings;
+    redrawAnimating = grassUniforms.windStrength > 0;
+}
+
+void UpdateRedrawUI()
+{
+    egui::Text("Redraw: %s, %u frames drawn, %u iterations skipped",
+            redrawSettings.onDemand ? "on demand" : "always",
+            redrawFramesDrawn.load(),
+            redrawFramesSkipped.load());
+    egui::SliderF32(IStr("Idle Redraw FPS (0 = changes only)"), &redrawSettings.idleFPS, 0, 30);
+    redrawIdleFPS = redrawSettings.idleFPS;
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,71 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/time.hpp"
+
+#include "app/camera.hpp"
+#include "app/trace.hpp"
+
+#include <atomic>
+
+// On demand rendering. Simulation still runs every loop iteration, but a frame is only recorded
+// and presented when something visible may have changed: device input (which covers egui edits),
+// camera movement, time dependent effects (wind), settings changed on render side, or grass tiles
+// placed in the last frame (streamed density may still be refining). Otherwise the iteration is skipped, the last presented image stays on screen,
+// and the loop sleeps briefly before polling again. Frames are still drawn at a low idle rate so
+// stats in the UI keep updating. --always-redraw disables skipping.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum RedrawReason
+{
+    REDRAW_INPUT = 1 << 0,
+    REDRAW_CAMERA = 1 << 1,
+    REDRAW_ANIMATION = 1 << 2,
+    REDRAW_REQUESTED = 1 << 3,      // Render side settings change or pending work
+    REDRAW_IDLE_TICK = 1 << 4,
+    REDRAW_FORCED = 1 << 5,         // On demand off, or a frame consumer like capture needs every frame
+};
+
+struct RedrawSettings
+{
+    bool onDemand = true;
+    f32 idleFPS = 4.f;              // Redraw rate with nothing changing, 0 only redraws on change. Render side, UI edits it.
+    f32 activeHoldS = 0.5f;         // Keep drawing after last change, so UI hover and release states show
+    u32 idlePollMS = 8;             // Sleep between input polls while skipping
+};
+
+struct RedrawState
+{
+    Camera lastCamera = {};
+    time::Timer activeTimer = {};   // Since last change
+    time::Timer idleTickTimer = {}; // Since last frame drawn
+    bool skipping = false;          // Previous iteration was skipped
+    bool resumed = false;           // Frame being decided follows skipped iterations
+    u32 reasons = 0;                // Of last drawn frame
+};
+
+inline RedrawSettings redrawSettings = {};
+inline RedrawState redrawState = {};
+inline std::atomic<bool> redrawRequested = false;
+inline std::atomic<bool> redrawAnimating = false;    // Published by render side, grass uniforms are render side
+inline std::atomic<f32> redrawIdleFPS = 0;           // Published by render side UI, read by sim side
+inline std::atomic<u32> redrawFramesDrawn = 0;       // Published by sim side, shown in render side UI
+inline std::atomic<u32> redrawFramesSkipped = 0;
+inline TraceSettings redrawLastSettings = {};  // Render side
+inline bool frameResumed = false;   // Render side, frame follows skipped iterations so its delta time includes idle
+
+void ParseRedrawSettings(const wchar_t* cmdLine);
+void InitRedraw();
+// Sim side, after AppUpdate. Returns false when this iteration can skip rendering.
+bool ShouldRedraw();
+// Sim side, instead of rendering a skipped iteration
+void WaitRedrawIdle();
+// Render side, after settings UI. Requests another frame when settings or grass state changed.
+void UpdateRedrawSettings();
+void UpdateRedrawUI();
+
+};  // namespace Grass
+};  // namespace ty
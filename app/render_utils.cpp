@@ -1,6 +1,8 @@
 #include "app/render_utils.hpp"
 #include "engine/src/render/render.hpp"
 
+#include "app/gpu_memory.hpp"
+
 namespace ty
 {
 namespace Grass
@@ -13,27 +15,23 @@ Handle<render::Shader> MakeShaderFromAsset(Handle<asset::Shader> hAsset, render:
     return render::MakeShader(type, asset.size, asset.data);
 }
 
-Handle<render::Texture> MakeTextureFromAsset(Handle<asset::Image> hAsset, render::ImageUsageFlags usage)
+Handle<render::Texture> MakeTextureFromAsset(Handle<asset::Image> hAsset, render::ImageUsageFlags usage, const char* name, render::Format format)
 {
     ASSERT(hAsset.IsValid());
     asset::Image& asset = asset::images[hAsset];
     u64 assetSize = asset.width * asset.height * asset.channels;
-    //TODO(caio): Figure out a better way to handle this besides
-    // creating a new staging buffer every time
-    Handle<render::Buffer> hStaging = render::MakeBuffer(
-            render::BUFFER_TYPE_STAGING, 
-            assetSize, 
-            assetSize,
-            asset.data);
+    // Immediate upload below is waited on, staging only has to outlive it
+    Handle<render::Buffer> hStaging = MakeGpuTransientBuffer("Upload staging", assetSize, asset.data);
     render::TextureDesc desc = {};
     desc.type = render::IMAGE_TYPE_2D; //TODO(caio): Hardcoded
     desc.width = asset.width;
     desc.height = asset.height;
     desc.mipLevels = render::GetMaxMipLevels(asset.width, asset.height);
-    desc.format = render::FORMAT_RGBA8_SRGB; //TODO(caio): Hardcoded
+    desc.format = format;
     desc.usageFlags = usage;
     desc.layout = render::IMAGE_LAYOUT_UNDEFINED;
     Handle<render::Texture> result = render::MakeTexture(desc);
+    TrackGpuTexture(name, result, GetTextureMemorySize(desc.width, desc.height, desc.mipLevels, 4));
 
     // Upload data through staging buffer
     Handle<render::CommandBuffer> hCmd = render::GetAvailableCommandBuffer(render::COMMAND_BUFFER_IMMEDIATE);
@@ -65,7 +63,7 @@ Handle<render::Texture> MakeTextureFromAsset(Handle<asset::Image> hAsset, render
 Handle<render::Buffer> MakeVbFromAsset(Handle<asset::Model> hAsset)
 {
     asset::Model& asset = asset::models[hAsset];
-    return render::MakeBuffer(render::BUFFER_TYPE_VERTEX, 
+    return MakeGpuBuffer("Model vertices", render::BUFFER_TYPE_VERTEX,
             asset.vertices.count * sizeof(f32), 
             sizeof(f32),
             asset.vertices.data);
@@ -75,7 +73,7 @@ Handle<render::Buffer> MakeIbFromAsset(Handle<asset::Model> hAsset)
 {
     //TODO(caio): No proper materials, just using index 0 from model asset
     asset::Model& asset = asset::models[hAsset];
-    return render::MakeBuffer(render::BUFFER_TYPE_INDEX, 
+    return MakeGpuBuffer("Model indices", render::BUFFER_TYPE_INDEX,
             asset.groups[0].indices.count * sizeof(u32), 
             sizeof(u32),
             asset.groups[0].indices.data);
@@ -85,6 +83,102 @@ void InitDefaultRenderResources()
 {
     render::SamplerDesc desc = {};
     hSamplerLinear = render::MakeSampler(desc);
+
+    f32 fullscreenData[] =
+    {
+        // position (x, y, z), normal (x, y, z), uv (u, v)
+        -1.f, -1.f, 0.f,   0.f, 0.f, 1.f,  0.f, 0.f,
+         3.f, -1.f, 0.f,   0.f, 0.f, 1.f,  2.f, 0.f,
+        -1.f,  3.f, 0.f,   0.f, 0.f, 1.f,  0.f, 2.f,
+    };
+    u32 fullscreenIndices[] = { 0, 1, 2 };
+    hVbFullscreen = MakeGpuBuffer("Fullscreen vertices", render::BUFFER_TYPE_VERTEX,
+            ARR_LEN(fullscreenData) * sizeof(f32),
+            sizeof(f32),
+            fullscreenData);
+    hIbFullscreen = MakeGpuBuffer("Fullscreen indices", render::BUFFER_TYPE_INDEX,
+            ARR_LEN(fullscreenIndices) * sizeof(u32),
+            sizeof(u32),
+            fullscreenIndices);
+
+    render::VertexAttribute vertexAttributesDefault[] =
+    {
+        render::VERTEX_ATTR_V3F,
+        render::VERTEX_ATTR_V3F,
+        render::VERTEX_ATTR_V2F,
+    };
+    hVertexLayoutDefault = render::MakeVertexLayout(ARR_LEN(vertexAttributesDefault), vertexAttributesDefault);
+}
+
+void PushDeferredDestroy(DeferredDestroyEntry entry)
+{
+    ASSERT(deferredDestroyCount < MAX_DEFERRED_DESTROYS);
+    entry.retireFrame = currentFrame + RENDER_CONCURRENT_FRAMES;
+    deferredDestroys[deferredDestroyCount++] = entry;
+}
+
+void DeferDestroyBuffer(Handle<render::Buffer> hBuffer)
+{
+    DeferredDestroyEntry entry = {};
+    entry.type = DEFERRED_DESTROY_BUFFER;
+    entry.hBuffer = hBuffer;
+    PushDeferredDestroy(entry);
+}
+
+void DeferDestroyResourceSet(Handle<render::ResourceSet> hResourceSet)
+{
+    DeferredDestroyEntry entry = {};
+    entry.type = DEFERRED_DESTROY_RESOURCE_SET;
+    entry.hResourceSet = hResourceSet;
+    PushDeferredDestroy(entry);
+}
+
+void DeferDestroyRenderTarget(Handle<render::RenderTarget> hRenderTarget)
+{
+    DeferredDestroyEntry entry = {};
+    entry.type = DEFERRED_DESTROY_RENDER_TARGET;
+    entry.hRenderTarget = hRenderTarget;
+    PushDeferredDestroy(entry);
+}
+
+void DeferDestroyRenderPass(Handle<render::RenderPass> hRenderPass)
+{
+    DeferredDestroyEntry entry = {};
+    entry.type = DEFERRED_DESTROY_RENDER_PASS;
+    entry.hRenderPass = hRenderPass;
+    PushDeferredDestroy(entry);
+}
+
+void ProcessDeferredDestroys(bool flush)
+{
+    // Call after render::BeginFrame, when frame fence for currentFrame has been waited on
+    i32 i = 0;
+    while(i < deferredDestroyCount)
+    {
+        DeferredDestroyEntry& entry = deferredDestroys[i];
+        if(!flush && currentFrame < entry.retireFrame)
+        {
+            i++;
+            continue;
+        }
+
+        switch(entry.type)
+        {
+            case DEFERRED_DESTROY_BUFFER:
+                DestroyGpuBuffer(entry.hBuffer);
+                break;
+            case DEFERRED_DESTROY_RESOURCE_SET: render::DestroyResourceSet(entry.hResourceSet); break;
+            case DEFERRED_DESTROY_RENDER_TARGET:
+                UntrackGpuResource(GPU_RESOURCE_RENDER_TARGET, entry.hRenderTarget.value);
+                render::DestroyRenderTarget(entry.hRenderTarget);
+                break;
+            case DEFERRED_DESTROY_RENDER_PASS: render::DestroyRenderPass(entry.hRenderPass); break;
+            default: ASSERT(0);
+        }
+        // Swap remove
+        deferredDestroys[i] = deferredDestroys[deferredDestroyCount - 1];
+        deferredDestroyCount--;
+    }
 }
 
 };  // namespace Grass
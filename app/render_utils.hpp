@@ -10,13 +10,49 @@ namespace Grass
 {
 
 Handle<render::Shader> MakeShaderFromAsset(Handle<asset::Shader> hAsset, render::ShaderType type);
-Handle<render::Texture> MakeTextureFromAsset(Handle<asset::Image> hAsset, render::ImageUsageFlags usage);
+Handle<render::Texture> MakeTextureFromAsset(Handle<asset::Image> hAsset, render::ImageUsageFlags usage, const char* name = "Texture",
+        render::Format format = render::FORMAT_RGBA8_SRGB);
 Handle<render::Buffer> MakeVbFromAsset(Handle<asset::Model> hAsset);
 Handle<render::Buffer> MakeIbFromAsset(Handle<asset::Model> hAsset);
 
 void InitDefaultRenderResources();
 
+// Deferred destruction for resources that may still be referenced by frames in flight.
+// Resources are destroyed once RENDER_CONCURRENT_FRAMES frames have started after the request.
+enum DeferredDestroyType
+{
+    DEFERRED_DESTROY_BUFFER,
+    DEFERRED_DESTROY_RESOURCE_SET,
+    DEFERRED_DESTROY_RENDER_TARGET,
+    DEFERRED_DESTROY_RENDER_PASS,
+};
+
+struct DeferredDestroyEntry
+{
+    DeferredDestroyType type = DEFERRED_DESTROY_BUFFER;
+    Handle<render::Buffer> hBuffer;
+    Handle<render::ResourceSet> hResourceSet;
+    Handle<render::RenderTarget> hRenderTarget;
+    Handle<render::RenderPass> hRenderPass;
+    i32 retireFrame = 0;
+};
+
+#define MAX_DEFERRED_DESTROYS 256
+inline DeferredDestroyEntry deferredDestroys[MAX_DEFERRED_DESTROYS];
+inline i32 deferredDestroyCount = 0;
+
+void DeferDestroyBuffer(Handle<render::Buffer> hBuffer);
+void DeferDestroyResourceSet(Handle<render::ResourceSet> hResourceSet);
+void DeferDestroyRenderTarget(Handle<render::RenderTarget> hRenderTarget);
+void DeferDestroyRenderPass(Handle<render::RenderPass> hRenderPass);
+void ProcessDeferredDestroys(bool flush = false);
+
 inline Handle<render::Sampler> hSamplerLinear;
+// Single triangle covering the screen, vertices already in clip space.
+// Same position/normal/uv layout as model vertex buffers.
+inline Handle<render::Buffer> hVbFullscreen;
+inline Handle<render::Buffer> hIbFullscreen;
+inline Handle<render::VertexLayout> hVertexLayoutDefault;
 
 };  // namespace Grass
 };  // namespace ty
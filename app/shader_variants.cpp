@@ -0,0 +1,58 @@
+#include "app/shader_variants.hpp"
+#include "engine/src/core/debug.hpp"
+#include "engine/src/core/string.hpp"
+
+#include "app/render_utils.hpp"
+
+#include <string.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+Handle<render::Shader> GetShaderVariant(const char* path, render::ShaderType type, u32 features)
+{
+    ASSERT(features < SHADER_FEATURE_MASK_COUNT);
+    for(i32 i = 0; i < shaderVariantCount; i++)
+    {
+        ShaderVariant& variant = shaderVariants[i];
+        if(variant.type == type && variant.features == features && strcmp(variant.path, path) == 0)
+        {
+            return variant.hShader;
+        }
+    }
+
+    const char* defines[SHADER_FEATURE_COUNT];
+    u32 defineCount = 0;
+    for(u32 i = 0; i < SHADER_FEATURE_COUNT; i++)
+    {
+        if(features & (1 << i)) defines[defineCount++] = shaderFeatureDefines[i];
+    }
+
+    ASSERT(shaderVariantCount < MAX_SHADER_VARIANTS);
+    ShaderVariant& variant = shaderVariants[shaderVariantCount++];
+    variant.path = path;
+    variant.type = type;
+    variant.features = features;
+    variant.hAsset = asset::LoadShader(file::MakePath(IStr(path)), defineCount, defines);
+    variant.hShader = MakeShaderFromAsset(variant.hAsset, type);
+    LOGF("Compiled shader variant %s (features 0x%x)\n", path, features);
+    return variant.hShader;
+}
+
+void PrecompileShaderVariants(const char* path, render::ShaderType type, u32 supportedFeatures)
+{
+    ASSERT(supportedFeatures < SHADER_FEATURE_MASK_COUNT);
+    // Walks submasks down to zero
+    u32 features = supportedFeatures;
+    while(true)
+    {
+        GetShaderVariant(path, type, features);
+        if(features == 0) break;
+        features = (features - 1) & supportedFeatures;
+    }
+}
+
+};  // namespace Grass
+};  // namespace ty
@@ -0,0 +1,52 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/asset/asset.hpp"
+#include "engine/src/render/render.hpp"
+
+// Shader permutations. Consumers request a shader by path and feature bitmask, each set feature
+// is passed to the GLSL compile as a FEATURE_* define, so disabled features are compiled out instead
+// of paying for a runtime branch. Consumers precompile every combination of their supported features
+// at init, so toggling a setting doesn't stall a frame on a GLSL compile. Variants are cached for the run.
+// Pipelines pick the variant matching current settings, and keep one pipeline per used variant.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum ShaderFeature
+{
+    SHADER_FEATURE_WIND = 1 << 0,
+    SHADER_FEATURE_DEBUG_VIEW = 1 << 1,
+    SHADER_FEATURE_SPLAT = 1 << 2,
+};
+#define SHADER_FEATURE_COUNT 3
+#define SHADER_FEATURE_MASK_COUNT (1 << SHADER_FEATURE_COUNT)
+
+inline const char* shaderFeatureDefines[SHADER_FEATURE_COUNT] =
+{
+    "FEATURE_WIND",
+    "FEATURE_DEBUG_VIEW",
+    "FEATURE_SPLAT",
+};
+
+struct ShaderVariant
+{
+    const char* path = NULL;
+    render::ShaderType type = render::SHADER_TYPE_VERTEX;
+    u32 features = 0;
+    Handle<asset::Shader> hAsset;
+    Handle<render::Shader> hShader;
+};
+
+#define MAX_SHADER_VARIANTS 64
+inline ShaderVariant shaderVariants[MAX_SHADER_VARIANTS];
+inline i32 shaderVariantCount = 0;
+
+// Features must only include those the shader supports, so equivalent variants aren't compiled twice
+Handle<render::Shader> GetShaderVariant(const char* path, render::ShaderType type, u32 features);
+// Compiles every subset of supported features, including none
+void PrecompileShaderVariants(const char* path, render::ShaderType type, u32 supportedFeatures);
+
+};  // namespace Grass
+};  // namespace ty
@@ -1,7 +1,6 @@
 #version 460 core
-layout(location = 0) in vec3 aPosition;
-layout(location = 1) in vec3 aNormal;
-layout(location = 2) in vec2 aUV;
+// 16 bit unorm in species mesh bounds, normals and uvs are stripped on import
+layout(location = 0) in vec4 aPositionQuantized;
 
 layout(push_constant) uniform uConstantBlock
 {
@@ -9,12 +8,16 @@ layout(push_constant) uniform uConstantBlock
     mat4 proj;
     float worldTime;
     float deltaTime;
+    uint viewIndex;
+    uint debugMode;
 } uConstants;
 
 struct GrassInstanceData
 {
     vec3 position;
+    float windSample;
     vec2 uv;
+    uint species;
 };
 
 layout(std140, set = 0, binding = 0) readonly buffer InstanceDataBlock
@@ -29,21 +32,135 @@ layout(std140, set = 0, binding = 1) uniform UniformBlock
     //vec2 windDirection;
     float windAngle;
     float windStrength;
-
+    uint bladesPerSide;
+    uint instanceCapacity;
+    float farDistance;
+    float farFadeBand;
+    float splatDistance;
+    uint targetWidth;
+    uint targetHeight;
+    float bladeHeight;
 } uUniforms;
 
-layout(set = 0, binding = 2) uniform sampler2D texWindNoise;
+// gl_InstanceIndex starts at this view's region, set by draw args first instance
+layout(std430, set = 0, binding = 2) readonly buffer VisibleBlock
+{
+    uint indices[];
+} uVisible;
+
+struct View
+{
+    mat4 viewProj;
+    vec3 position;
+};
+
+layout(std140, set = 0, binding = 3) uniform ViewsBlock
+{
+    View views[4];
+    uint viewCount;
+} uViews;
+
+struct Species
+{
+    vec3 positionMin;
+    float height;
+    vec3 positionExtent;
+    vec3 tipColor;
+};
+
+// Indexed by instance species, every species is drawn by the same multi draw indirect call
+layout(std140, set = 0, binding = 5) uniform SpeciesBlock
+{
+    Species species[3];
+} uSpecies;
+
+// Variant features (see shader_variants.hpp): FEATURE_WIND, FEATURE_DEBUG_VIEW.
+// Disabled features are compiled out instead of branched around.
 
 layout(location = 0) out struct
 {
-    vec2 UV;
     float windDisplacement;
     float height;
 } VOut;
+layout(location = 3) flat out vec3 VTipColor;
+
+#ifdef FEATURE_DEBUG_VIEW
+layout(set = 0, binding = 4) uniform sampler2D texDensity;
+
+// Alpha 0 when debug view is off, otherwise fragment outputs this color as is
+layout(location = 2) flat out vec4 VDebugColor;
+
+#define GRASS_DEBUG_NONE 0
+#define GRASS_DEBUG_OVERDRAW 1
+#define GRASS_DEBUG_TILE 2
+#define GRASS_DEBUG_LOD 3
+#define GRASS_DEBUG_DENSITY 4
+#define GRASS_DEBUG_ORDER 5
+#define GRASS_DEBUG_SPECIES 6
+
+// Matches grassTileBladesPerSide
+const uint tileBladesPerSide = 32u;
+
+uint hash(uint x)
+{
+    uint state = x * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+vec3 heatColor(float t)
+{
+    return clamp(vec3(t * 2 - 0.5, 1 - abs(t * 2 - 1), 1.5 - t * 2), 0, 1);
+}
+
+vec4 debugColor(GrassInstanceData instanceData, uint iid, float farFade)
+{
+    switch(uConstants.debugMode)
+    {
+        case GRASS_DEBUG_OVERDRAW:
+        {
+            // Added once per shaded fragment, red saturates after 16 layers
+            return vec4(1.0 / 16, 1.0 / 48, 1.0 / 128, 1);
+        }
+        case GRASS_DEBUG_TILE:
+        {
+            uvec2 tile = uvec2(instanceData.uv * float(uUniforms.bladesPerSide)) / tileBladesPerSide;
+            uint h = hash(hash(tile.x) ^ tile.y);
+            return vec4(vec3(h & 0xFF, (h >> 8) & 0xFF, (h >> 16) & 0xFF) / 255.0, 1);
+        }
+        case GRASS_DEBUG_LOD:
+        {
+            return vec4(1 - farFade, farFade, 0, 1);
+        }
+        case GRASS_DEBUG_DENSITY:
+        {
+            // Placement survival probability, unorm like the streamed map, scaled to blades per square unit
+            float density = textureLod(texDensity, instanceData.uv, 0).r * uUniforms.grassDensity;
+            return vec4(heatColor(density / 10), 1);
+        }
+        case GRASS_DEBUG_ORDER:
+        {
+            // Morton order shows as nested Z shaped gradients, row major as stripes
+            float order = float(iid % (tileBladesPerSide * tileBladesPerSide)) / float(tileBladesPerSide * tileBladesPerSide);
+            return vec4(vec3(order), 1);
+        }
+        case GRASS_DEBUG_SPECIES:
+        {
+            uint h = hash(instanceData.species + 1u);
+            return vec4(vec3(h & 0xFF, (h >> 8) & 0xFF, (h >> 16) & 0xFF) / 255.0, 1);
+        }
+        default: return vec4(0);
+    }
+}
+#endif
 
 void main()
 {
-    GrassInstanceData instanceData = uInstances.data[gl_InstanceIndex];
+    // Visible lists keep cull workgroups' blades contiguous, so consecutive instances are close in instance buffer
+    uint iid = uVisible.indices[gl_InstanceIndex];
+    GrassInstanceData instanceData = uInstances.data[iid];
+    Species species = uSpecies.species[instanceData.species];
+    vec3 aPosition = species.positionMin + aPositionQuantized.xyz * species.positionExtent;
 
     // Wind displaces vertices based on their height, so bases stay intact
     //TODO(caio): This should bend instead of just translating vertices
@@ -51,6 +168,12 @@ void main()
     //vec2 windDirection = normalize(uUniforms.windDirection);
     //vec2 windUV = instanceData.uv + (uConstants.worldTime * uUniforms.windDirection);
 
+    // Blades shrink inside far fade band, so they don't pop where they stop being placed
+    float cameraDistance = distance(instanceData.position, uViews.views[uConstants.viewIndex].position);
+    float farFade = clamp((uUniforms.farDistance - cameraDistance) / uUniforms.farFadeBand, 0, 1);
+    vec3 bladePosition = vec3(aPosition.x, aPosition.y * farFade, aPosition.z);
+
+#ifdef FEATURE_WIND
     vec2 windDirection = vec2(0, 1);
     float windAngleSin = sin(uUniforms.windAngle);
     float windAngleCos = cos(uUniforms.windAngle);
@@ -58,14 +181,18 @@ void main()
             windDirection.x * windAngleCos - windDirection.y * windAngleSin,
             windDirection.x * windAngleSin + windDirection.y * windAngleCos);
 
-    vec2 windUV = instanceData.uv + (uConstants.worldTime * windDirection);
-    float windDisplacement = aPosition.y
+    // Noise was sampled by cull compute, once per blade for all views
+    float windDisplacement = bladePosition.y
         //* windStrength
         * uUniforms.windStrength
-        * texture(texWindNoise, windUV).r;
+        * instanceData.windSample;
     
     vec3 finalPosition = instanceData.position
         + (windDisplacement * vec3(windDirection.x, 0, windDirection.y));
+#else
+    float windDisplacement = 0;
+    vec3 finalPosition = instanceData.position;
+#endif
     
     mat4 instanceTranslation = mat4(
             vec4(1, 0, 0, 0),
@@ -73,8 +200,11 @@ void main()
             vec4(0, 0, 1, 0),
             vec4(finalPosition, 1)
             );
-    gl_Position = uConstants.proj * uConstants.view * instanceTranslation * vec4(aPosition, 1);
-    VOut.UV = aUV;
+    gl_Position = uConstants.proj * uConstants.view * instanceTranslation * vec4(bladePosition, 1);
     VOut.windDisplacement = windDisplacement;
     VOut.height = aPosition.y / 10;
+    VTipColor = species.tipColor;
+#ifdef FEATURE_DEBUG_VIEW
+    VDebugColor = debugColor(instanceData, iid, farFade);
+#endif
 }
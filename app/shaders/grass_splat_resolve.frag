@@ -0,0 +1,36 @@
+#version 460 core
+#extension GL_ARB_gpu_shader_int64 : require
+
+layout(std430, set = 0, binding = 0) readonly buffer SplatBlock
+{
+    uint64_t pixels[];
+} uSplat;
+
+layout(std140, set = 0, binding = 1) uniform UniformBlock
+{
+    float terrainSize;
+    float grassDensity;
+    float windAngle;
+    float windStrength;
+    uint bladesPerSide;
+    uint instanceCapacity;
+    float farDistance;
+    float farFadeBand;
+    float splatDistance;
+    uint targetWidth;
+    uint targetHeight;
+    float bladeHeight;
+} uUniforms;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    uint index = pixel.y * uUniforms.targetWidth + pixel.x;
+    uint64_t value = uSplat.pixels[index];
+    if(value == 0xFFFFFFFFFFFFFFFFUL) discard;
+
+    gl_FragDepth = uintBitsToFloat(uint(value >> 32));
+    oColor = unpackUnorm4x8(uint(value));
+}
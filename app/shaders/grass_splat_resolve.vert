@@ -0,0 +1,10 @@
+#version 460 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aUV;
+
+void main()
+{
+    // Fullscreen triangle, already in clip space
+    gl_Position = vec4(aPosition.xy, 0, 1);
+}
@@ -0,0 +1,56 @@
+#version 460 core
+
+layout(set = 0, binding = 0) uniform sampler2D texGrassColor;     // Alpha is blade coverage
+layout(set = 0, binding = 1) uniform sampler2D texGrassDepth;
+
+layout(push_constant) uniform uConstantBlock
+{
+    vec2 targetSize;
+    vec2 lowResSize;
+    float depthSharpness;
+} uConstants;
+
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    // Position in low res texel space, 4 nearest texels form the bilinear footprint
+    vec2 lowResPosition = gl_FragCoord.xy / uConstants.targetSize * uConstants.lowResSize - 0.5;
+    ivec2 baseTexel = ivec2(floor(lowResPosition));
+    vec2 f = lowResPosition - vec2(baseTexel);
+    ivec2 maxTexel = ivec2(uConstants.lowResSize) - 1;
+
+    vec4 colors[4];
+    float depths[4];
+    float bilinearWeights[4];
+    float referenceDepth = 1;
+    for(int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(baseTexel + offset, ivec2(0), maxTexel);
+        colors[i] = texelFetch(texGrassColor, texel, 0);
+        depths[i] = texelFetch(texGrassDepth, texel, 0).r;
+        bilinearWeights[i] = (offset.x == 1 ? f.x : 1 - f.x) * (offset.y == 1 ? f.y : 1 - f.y);
+        if(colors[i].a > 0) referenceDepth = min(referenceDepth, depths[i]);
+    }
+    if(referenceDepth >= 1) discard;
+
+    // Nearest covered sample is the reference, samples at other depths (blades behind it,
+    // or terrain showing through) get down weighted instead of blurred across the edge.
+    // 1 - depth is roughly proportional to 1 / view distance, so this difference is relative.
+    vec3 color = vec3(0);
+    float weightSum = 0;
+    float coverage = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        float relativeDistance = abs(depths[i] - referenceDepth) / max(1 - referenceDepth, 1e-6);
+        float weight = bilinearWeights[i] * colors[i].a * exp(-relativeDistance * uConstants.depthSharpness);
+        color += colors[i].rgb * weight;
+        weightSum += weight;
+        coverage += bilinearWeights[i] * colors[i].a;
+    }
+
+    // Depth tested against full resolution terrain, so terrain edges stay sharp
+    gl_FragDepth = referenceDepth;
+    oColor = vec4(color / max(weightSum, 1e-6), coverage);
+}
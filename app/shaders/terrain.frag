@@ -2,11 +2,77 @@
 layout(location = 0) in struct
 {
     vec4 Color;
+    vec3 WorldPosition;
 } PIn;
 
+layout(std140, set = 0, binding = 0) uniform UniformBlock
+{
+    vec3 cameraPosition;
+    float terrainSize;
+    float grassFarDistance;
+    float grassFarFadeBand;
+} uUniforms;
+
+// Streamed density map, see map_stream.hpp
+layout(std140, set = 0, binding = 1) uniform DensityMapBlock
+{
+    uint width;
+    uint height;
+    uint tileSize;
+    uint tilesX;
+    uint tilesY;
+    uint mipCount;
+} uDensityMap;
+
+// One entry per finest mip tile: pool slot of finest resident tile covering it << 8 | its mip
+layout(std430, set = 0, binding = 2) readonly buffer DensityPagesBlock
+{
+    uint entries[];
+} uDensityPages;
+
+// Resident tiles, tileSize * tileSize unorm bytes each, packed 4 per uint
+layout(std430, set = 0, binding = 3) readonly buffer DensityTilesBlock
+{
+    uint words[];
+} uDensityTiles;
+
 layout(location = 0) out vec4 oColor;
 
+// Density at finest mip texel, from a coarser mip while its tile isn't resident
+float fetchDensity(ivec2 texel)
+{
+    uint tileSize = uDensityMap.tileSize;
+    uvec2 tile = uvec2(texel) / tileSize;
+    uint entry = uDensityPages.entries[tile.y * uDensityMap.tilesX + tile.x];
+    uint mip = entry & 0xFFu;
+    // Tile grids nest, mip tile (tile >> mip) holds texel (texel >> mip)
+    uvec2 tileTexel = (uvec2(texel) >> mip) - (tile >> mip) * tileSize;
+    uint index = (entry >> 8u) * tileSize * tileSize + tileTexel.y * tileSize + tileTexel.x;
+    return float((uDensityTiles.words[index >> 2u] >> ((index & 3u) * 8u)) & 0xFFu) / 255.0;
+}
+
+// Bilinear filtered like the linear sampled texture this replaces
+float sampleDensity(vec2 uv)
+{
+    ivec2 densitySize = ivec2(uDensityMap.width, uDensityMap.height);
+    vec2 position = uv * vec2(densitySize) - 0.5;
+    ivec2 baseTexel = ivec2(floor(position));
+    vec2 f = position - vec2(baseTexel);
+    float d00 = fetchDensity(clamp(baseTexel, ivec2(0), densitySize - 1));
+    float d10 = fetchDensity(clamp(baseTexel + ivec2(1, 0), ivec2(0), densitySize - 1));
+    float d01 = fetchDensity(clamp(baseTexel + ivec2(0, 1), ivec2(0), densitySize - 1));
+    float d11 = fetchDensity(clamp(baseTexel + ivec2(1, 1), ivec2(0), densitySize - 1));
+    return mix(mix(d00, d10, f.x), mix(d01, d11, f.x), f.y);
+}
+
 void main()
 {
-    oColor = PIn.Color;
+    // Grass far field: average blade color weighted by grass density,
+    // fading in over the band where blades fade out
+    vec3 farGrassColor = vec3(0.09, 0.55, 0.01);
+    float cameraDistance = distance(PIn.WorldPosition, uUniforms.cameraPosition);
+    float farFade = smoothstep(uUniforms.grassFarDistance - uUniforms.grassFarFadeBand, uUniforms.grassFarDistance, cameraDistance);
+    float density = sampleDensity(PIn.WorldPosition.xz / uUniforms.terrainSize);
+
+    oColor = vec4(mix(PIn.Color.rgb, farGrassColor, farFade * density), PIn.Color.a);
 }
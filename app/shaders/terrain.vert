@@ -13,6 +13,7 @@ layout(push_constant) uniform uConstantBlock
 layout(location = 0) out struct
 {
     vec4 Color;
+    vec3 WorldPosition;
 } VOut;
 
 void main()
@@ -22,6 +23,8 @@ void main()
             vec4(0, uConstants.terrainSize, 0, 0),
             vec4(0, 0, uConstants.terrainSize, 0),
             vec4(0, 0, 0, 1));
-    gl_Position = uConstants.proj * uConstants.view * worldMatrix * vec4(aPosition, 1);
+    vec4 worldPosition = worldMatrix * vec4(aPosition, 1);
+    gl_Position = uConstants.proj * uConstants.view * worldPosition;
     VOut.Color = vec4(aPosition, 1);
+    VOut.WorldPosition = worldPosition.xyz;
 }
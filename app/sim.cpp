@@ -0,0 +1,78 @@
+#include "app/sim.hpp"
+
+#include "app/state.hpp"
+#include "app/latency.hpp"
+#include "app/redraw.hpp"
+
+namespace ty
+{
+namespace Grass
+{
+
+void InitSim()
+{
+    simCamera = appCamera;
+    simDeltaTime = 0;
+    simWorldTime = 0;
+    simWorldTimer.Start();
+    simFrameTimer.Start();
+}
+
+void PollWindowMessages(render::Window* window)
+{
+    std::lock_guard<std::mutex> lock(windowInputMutex);
+    window->PollMessages();
+}
+
+void AdvanceSimTime()
+{
+    simFrameTimer.Stop();
+    simDeltaTime = (f32)simFrameTimer.GetElapsedS();
+    simFrameTimer.Start();
+    simWorldTimer.Stop();
+    simWorldTime = (f32)simWorldTimer.GetElapsedS();
+}
+
+FrameSnapshot MakeFrameSnapshot()
+{
+    FrameSnapshot result = {};
+    result.camera = simCamera;
+    result.inputTimer = simInputTimer;
+    result.worldTime = simWorldTime;
+    result.trace = simTraceFrame;
+    result.resumed = redrawState.resumed;
+    return result;
+}
+
+void ApplyFrameSnapshot(const FrameSnapshot& snapshot)
+{
+    appCamera = snapshot.camera;
+    worldTime = snapshot.worldTime;
+    traceFrame = snapshot.trace;
+    frameResumed = snapshot.resumed;
+    MarkFrameInput(currentFrame, snapshot.inputTimer);
+}
+
+void PushFrameSnapshot(const FrameSnapshot& snapshot)
+{
+    // Render thread is behind, waiting here is what paces simulation
+    while(!frameSnapshots.Push(snapshot))
+    {
+        std::this_thread::yield();
+    }
+}
+
+FrameSnapshot PopFrameSnapshot()
+{
+    FrameSnapshot result = {};
+    // Simulation stops producing while on demand rendering skips frames, so back off to sleeping
+    for(u32 spin = 0; !frameSnapshots.Pop(&result); spin++)
+    {
+        if(spin < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return result;
+}
+
+};  // namespace Grass
+};  // namespace ty
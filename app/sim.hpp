@@ -0,0 +1,89 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/math.hpp"
+#include "engine/src/core/time.hpp"
+#include "engine/src/render/window.hpp"
+
+#include "app/camera.hpp"
+#include "app/trace.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Pipelined main loop. The main thread owns the window, so it runs simulation (messages, input,
+// camera) and produces one immutable FrameSnapshot per frame. A render thread consumes snapshots
+// and records, submits and presents frames. Simulation of frame N+1 overlaps rendering of frame N,
+// so frame time approaches max(update, render) instead of their sum.
+// Render side reads appCamera and worldTime only from the snapshot it is rendering.
+
+namespace ty
+{
+namespace Grass
+{
+
+// Lock free single producer, single consumer ring
+template <typename T, u32 capacity>
+struct SpscQueue
+{
+    T items[capacity];
+    std::atomic<u32> head = 0;      // Next item to pop, written by consumer only
+    std::atomic<u32> tail = 0;      // Next item to push, written by producer only
+
+    bool Push(const T& item)
+    {
+        u32 t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == capacity) return false;
+        items[t % capacity] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T* item)
+    {
+        u32 h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) return false;
+        *item = items[h % capacity];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+struct FrameSnapshot
+{
+    Camera camera = {};
+    f32 worldTime = 0;
+    time::Timer inputTimer = {};    // Started when input for this frame was sampled, for latency stats
+    TraceFrame trace = {};          // Input and timing this frame was simulated with
+    bool resumed = false;           // Follows iterations skipped by on demand rendering
+    bool quit = false;              // Last snapshot, render thread exits after it
+};
+
+// Simulation may run this many frames ahead of the frame being rendered
+const u32 frameSnapshotQueueSize = 1;
+
+inline SpscQueue<FrameSnapshot, frameSnapshotQueueSize> frameSnapshots;
+inline Camera simCamera = {};       // Simulation side camera, render side gets copies through snapshots
+inline time::Timer simWorldTimer = {};
+inline time::Timer simFrameTimer = {};
+inline time::Timer simInputTimer = {};
+inline f32 simDeltaTime = 0;
+inline f32 simWorldTime = 0;
+inline TraceFrame simTraceFrame = {};
+// Engine egui input is queued by the window procedure while messages are polled and
+// consumed by egui::BeginFrame, which run on different threads when pipelined
+inline std::mutex windowInputMutex;
+
+void InitSim();
+void PollWindowMessages(render::Window* window);
+// Simulation frame and world time, measured between calls or read from replayed trace
+void AdvanceSimTime();
+FrameSnapshot MakeFrameSnapshot();
+void ApplyFrameSnapshot(const FrameSnapshot& snapshot);
+// Blocks until snapshot is queued
+void PushFrameSnapshot(const FrameSnapshot& snapshot);
+// Blocks until a snapshot is available
+FrameSnapshot PopFrameSnapshot();
+
+};  // namespace Grass
+};  // namespace ty
@@ -2,6 +2,8 @@
 #include "app/camera.hpp"
 #include "engine/src/core/memory.hpp"
 
+#include "app/frame_memory.hpp"
+
 namespace ty
 {
 namespace Grass
@@ -9,7 +11,7 @@ namespace Grass
 
 void InitState()
 {
-    appHeap = mem::MakeHeapAllocator(GB(1));
+    appHeap = mem::MakeHeapAllocator(appHeapCapacity);
 
     math::v3f initialCameraPos = {-5, 24, -5};
     math::v3f initialCameraTarget = {256, 0, 256};
@@ -15,6 +15,7 @@ namespace Grass
 
 const i32 appWidth = 1920;
 const i32 appHeight = 1080;
+inline f32 renderScale = 1.f;   // Internal resolution scale of main render target
 
 inline mem::HeapAllocator appHeap = {};
 
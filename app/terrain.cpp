@@ -1,6 +1,8 @@
 #include "app\terrain.hpp"
 #include "app\state.hpp"
 #include "app\render_utils.hpp"
+#include "app\grass.hpp"
+#include "app\gpu_memory.hpp"
 
 namespace ty
 {
@@ -32,23 +34,20 @@ void InitTerrain(Handle<render::RenderTarget> hRenderTarget)
     hVsTerrain = MakeShaderFromAsset(hAssetVsTerrain, render::SHADER_TYPE_VERTEX);
     hPsTerrain = MakeShaderFromAsset(hAssetPsTerrain, render::SHADER_TYPE_PIXEL);
 
-    hVbTerrain = render::MakeBuffer(render::BUFFER_TYPE_VERTEX,
+    hVbTerrain = MakeGpuBuffer("Terrain vertices", render::BUFFER_TYPE_VERTEX,
             ARR_LEN(terrainQuadData) * sizeof(f32),
             sizeof(f32),
             terrainQuadData);
-    hIbTerrain = render::MakeBuffer(render::BUFFER_TYPE_INDEX,
+    hIbTerrain = MakeGpuBuffer("Terrain indices", render::BUFFER_TYPE_INDEX,
             ARR_LEN(terrainQuadIndices) * sizeof(u32),
             sizeof(u32),
             terrainQuadIndices);
     terrainConstants = {};
+    terrainUniforms = {};
+    hUbTerrain = MakeGpuBuffer("Terrain uniforms", render::BUFFER_TYPE_UNIFORM, sizeof(TerrainUniformBlock), sizeof(TerrainUniformBlock), &terrainUniforms);
 
     // Render pipeline
-    render::RenderPassDesc renderPassTerrainRenderDesc = {};
-    renderPassTerrainRenderDesc.loadOp = render::LOAD_OP_LOAD;
-    renderPassTerrainRenderDesc.storeOp = render::STORE_OP_STORE;
-    renderPassTerrainRenderDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
-    renderPassTerrainRenderDesc.finalLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
-    hRenderPassTerrainRender = render::MakeRenderPass(renderPassTerrainRenderDesc, hRenderTarget);
+    SetTerrainRenderTarget(hRenderTarget);
 
     render::VertexAttribute vertexAttributesTerrainRender[] =
     {
@@ -66,7 +65,30 @@ void InitTerrain(Handle<render::RenderTarget> hRenderTarget)
     pipelineTerrainDesc.pushConstantRanges[0].offset = 0;
     pipelineTerrainDesc.pushConstantRanges[0].size = sizeof(TerrainConstantBlock);
     pipelineTerrainDesc.pushConstantRanges[0].shaderStages = render::SHADER_TYPE_VERTEX;
-    hGraphicsPipelineTerrainRender = render::MakeGraphicsPipeline(hRenderPassTerrainRender, pipelineTerrainDesc, 0, NULL);
+
+    // Resource set is made once grass density exists, see InitTerrainGrassFarField
+    render::ResourceSetLayout::Entry terrainRenderResourceLayoutEntries[] =
+    {
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_PIXEL
+        },
+        {
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .shaderStages = render::SHADER_TYPE_PIXEL
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_PIXEL
+        },
+        {
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .shaderStages = render::SHADER_TYPE_PIXEL
+        },
+    };
+    hResourceLayoutTerrainRender = render::MakeResourceSetLayout(ARR_LEN(terrainRenderResourceLayoutEntries),
+            terrainRenderResourceLayoutEntries);
+    hGraphicsPipelineTerrainRender = render::MakeGraphicsPipeline(hRenderPassTerrainRender, pipelineTerrainDesc, 1, &hResourceLayoutTerrainRender);
 
 }
 
@@ -74,6 +96,53 @@ void ShutdownTerrain()
 {
 }
 
+void SetTerrainRenderTarget(Handle<render::RenderTarget> hRenderTarget)
+{
+    // Pipeline stays valid, new render pass is compatible as long as target formats match
+    if(hRenderPassTerrainRender.IsValid())
+    {
+        DeferDestroyRenderPass(hRenderPassTerrainRender);
+    }
+    render::RenderPassDesc renderPassTerrainRenderDesc = {};
+    renderPassTerrainRenderDesc.loadOp = render::LOAD_OP_LOAD;
+    renderPassTerrainRenderDesc.storeOp = render::STORE_OP_STORE;
+    renderPassTerrainRenderDesc.initialLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    renderPassTerrainRenderDesc.finalLayout = render::IMAGE_LAYOUT_COLOR_OUTPUT;
+    hRenderPassTerrainRender = render::MakeRenderPass(renderPassTerrainRenderDesc, hRenderTarget);
+}
+
+void InitTerrainGrassFarField(StreamedMap* grassDensity)
+{
+    // Far field layer: past grass far distance, terrain is tinted by grass density instead of drawing blades.
+    // Density is read from streamed map tiles, so distant terrain shows coarser mips.
+    render::ResourceSet::Entry terrainRenderResourceSetEntries[] =
+    {
+        {
+            .binding = 0,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = hUbTerrain
+        },
+        {
+            .binding = 1,
+            .resourceType = render::RESOURCE_UNIFORM_BUFFER,
+            .hBuffer = grassDensity->hUbMap
+        },
+        {
+            .binding = 2,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = grassDensity->hSbPageTable
+        },
+        {
+            .binding = 3,
+            .resourceType = render::RESOURCE_STORAGE_BUFFER,
+            .hBuffer = grassDensity->hSbTilePool
+        },
+    };
+    hResourceSetTerrainRender = render::MakeResourceSet(hResourceLayoutTerrainRender,
+            ARR_LEN(terrainRenderResourceSetEntries),
+            terrainRenderResourceSetEntries);
+}
+
 void UpdateTerrainConstants()
 {
     terrainConstants.view = math::Transpose(appCamera.GetView());
@@ -82,6 +151,15 @@ void UpdateTerrainConstants()
     terrainConstants.terrainSize = 256;
 }
 
+void UpdateTerrainUniforms()
+{
+    terrainUniforms.cameraPosition = appCamera.position;
+    terrainUniforms.terrainSize = terrainConstants.terrainSize;
+    terrainUniforms.grassFarDistance = grassUniforms.farDistance;
+    terrainUniforms.grassFarFadeBand = grassUniforms.farFadeBand;
+    render::CopyMemoryToBuffer(hUbTerrain, 0, sizeof(TerrainUniformBlock), &terrainUniforms);
+}
+
 void RenderTerrain(Handle<render::CommandBuffer> hCmd)
 {
     render::BeginRenderPass(hCmd, hRenderPassTerrainRender);
@@ -91,6 +169,10 @@ void RenderTerrain(Handle<render::CommandBuffer> hCmd)
     render::CmdSetScissor(hCmd, hRenderPassTerrainRender);
     render::CmdBindVertexBuffer(hCmd, hVbTerrain);
     render::CmdBindIndexBuffer(hCmd, hIbTerrain);
+    render::CmdBindGraphicsResources(hCmd,
+            hGraphicsPipelineTerrainRender,
+            hResourceSetTerrainRender, 0,
+            0, NULL);
     render::CmdDrawIndexed(hCmd, hIbTerrain, 1);
     render::EndRenderPass(hCmd, hRenderPassTerrainRender);
 }
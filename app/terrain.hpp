@@ -3,6 +3,8 @@
 #include "engine/src/asset/asset.hpp"
 #include "engine/src/render/render.hpp"
 
+#include "app/map_stream.hpp"
+
 namespace ty
 {
 namespace Grass
@@ -15,6 +17,15 @@ struct TerrainConstantBlock
     f32 terrainSize = 256;
 };
 
+struct TerrainUniformBlock
+{
+    math::v3f cameraPosition = {};
+    f32 terrainSize = 256;
+    f32 grassFarDistance = 0;       // Terrain shows grass far field layer past this distance
+    f32 grassFarFadeBand = 0;       // Layer fades in over this distance, while blades fade out
+    f32 padding0[2];
+};
+
 // Assets
 inline Handle<asset::Shader> hAssetVsTerrain;
 inline Handle<asset::Shader> hAssetPsTerrain;
@@ -25,19 +36,24 @@ inline Handle<render::Shader> hPsTerrain;
 inline Handle<render::Buffer> hVbTerrain;
 inline Handle<render::Buffer> hIbTerrain;
 inline TerrainConstantBlock terrainConstants;
+inline TerrainUniformBlock terrainUniforms;
+inline Handle<render::Buffer> hUbTerrain;
 //TODO(caio): Heightmap stuff
 
 // Terrain render pass
 inline Handle<render::VertexLayout> hVertexLayoutTerrainRender;
 inline Handle<render::RenderPass> hRenderPassTerrainRender;
-//inline Handle<render::ResourceSetLayout> hResourceLayoutTerrainRender;
-//inline Handle<render::ResourceSet> hResourceSetTerrainRender;
+inline Handle<render::ResourceSetLayout> hResourceLayoutTerrainRender;
+inline Handle<render::ResourceSet> hResourceSetTerrainRender;
 inline Handle<render::GraphicsPipeline> hGraphicsPipelineTerrainRender;
     
 void InitTerrain(Handle<render::RenderTarget> hRenderTarget);
 void ShutdownTerrain();
+void SetTerrainRenderTarget(Handle<render::RenderTarget> hRenderTarget);
+void InitTerrainGrassFarField(StreamedMap* grassDensity);
 
 void UpdateTerrainConstants();
+void UpdateTerrainUniforms();
 void RenderTerrain(Handle<render::CommandBuffer> hCmd);
 
 };  // namespace Grass
@@ -0,0 +1,184 @@
+#include "app/trace.hpp"
+#include "engine/src/core/debug.hpp"
+
+#include <string.h>
+#include <wchar.h>
+#include <stdlib.h>
+
+namespace ty
+{
+namespace Grass
+{
+
+bool ParseTracePathArg(const wchar_t* cmdLine, const wchar_t* argName, char* buffer, u64 bufferSize)
+{
+    const wchar_t* arg = wcsstr(cmdLine, argName);
+    if(!arg) return false;
+    arg += wcslen(argName);
+    // Path ends at next space, quoted paths aren't supported
+    wchar_t widePath[256];
+    i32 length = 0;
+    while(arg[length] && arg[length] != L' ' && length < (i32)ARR_LEN(widePath) - 1)
+    {
+        widePath[length] = arg[length];
+        length++;
+    }
+    widePath[length] = 0;
+    return length > 0 && wcstombs(buffer, widePath, bufferSize) < bufferSize;
+}
+
+void ParseTraceSettings(const wchar_t* cmdLine)
+{
+    traceState = {};
+    if(!cmdLine) return;
+    if(ParseTracePathArg(cmdLine, L"--replay=", traceState.path, sizeof(traceState.path)))
+    {
+        traceState.mode = TRACE_MODE_REPLAY;
+        if(!ParseTracePathArg(cmdLine, L"--replay-timings=", traceState.timingsPath, sizeof(traceState.timingsPath)))
+        {
+            snprintf(traceState.timingsPath, sizeof(traceState.timingsPath), "%s.csv", traceState.path);
+        }
+    }
+    else if(ParseTracePathArg(cmdLine, L"--record=", traceState.path, sizeof(traceState.path)))
+    {
+        traceState.mode = TRACE_MODE_RECORD;
+    }
+}
+
+bool BeginTrace()
+{
+    TraceState& state = traceState;
+    if(state.mode == TRACE_MODE_NONE) return true;
+
+    TraceHeader header = {};
+    header.settingsSize = sizeof(TraceSettings);
+    if(state.mode == TRACE_MODE_RECORD)
+    {
+        state.file = fopen(state.path, "wb");
+        if(!state.file || fwrite(&header, sizeof(TraceHeader), 1, state.file) != 1)
+        {
+            LOGF("Failed to open trace for recording: %s\n", state.path);
+            EndTrace();
+            return false;
+        }
+        LOGF("Recording trace: %s\n", state.path);
+        return true;
+    }
+
+    TraceHeader fileHeader = {};
+    state.file = fopen(state.path, "rb");
+    bool result = state.file
+        && fread(&fileHeader, sizeof(TraceHeader), 1, state.file) == 1
+        && fileHeader.magic == header.magic
+        && fileHeader.version == header.version
+        && fileHeader.settingsSize == header.settingsSize;
+    if(!result)
+    {
+        LOGF("Trace missing or recorded by an incompatible build: %s\n", state.path);
+        EndTrace();
+        return false;
+    }
+    state.timingsFile = fopen(state.timingsPath, "w");
+    if(!state.timingsFile)
+    {
+        LOGF("Failed to open replay timings file: %s\n", state.timingsPath);
+        EndTrace();
+        return false;
+    }
+    fprintf(state.timingsFile, "frame,update_ms,render_ms,gpu_wait_ms,frame_ms\n");
+    LOGF("Replaying trace: %s, timings to %s\n", state.path, state.timingsPath);
+    return true;
+}
+
+void EndTrace()
+{
+    TraceState& state = traceState;
+    if(state.file) fclose(state.file);
+    if(state.timingsFile) fclose(state.timingsFile);
+    if(state.mode != TRACE_MODE_NONE && state.frameIndex > 0)
+    {
+        LOGF("Trace %s: %u frames\n", state.mode == TRACE_MODE_RECORD ? "recorded" : "replayed", state.frameIndex);
+    }
+    state.file = NULL;
+    state.timingsFile = NULL;
+    state.mode = TRACE_MODE_NONE;
+}
+
+bool IsTraceReplaying()
+{
+    return traceState.mode == TRACE_MODE_REPLAY;
+}
+
+bool ReadTraceFrame(TraceFrame* frame)
+{
+    ASSERT(IsTraceReplaying());
+    FILE* file = traceState.file;
+    *frame = {};
+    if(fread(&frame->record, sizeof(TraceFrameRecord), 1, file) != 1) return false;
+    if(frame->record.flags & TRACE_FRAME_SETTINGS)
+    {
+        if(fread(&frame->settings, sizeof(TraceSettings), 1, file) != 1) return false;
+    }
+    return true;
+}
+
+TraceSettings GetTraceSettings()
+{
+    TraceSettings result = {};
+    result.grassUniforms = grassUniforms;
+    result.grassDensityRequested = grassDensityRequested;
+    result.grassSplatPixelSize = grassSplatPixelSize;
+    result.grassDebugMode = grassDebugMode;
+    result.grassResolutionLevel = grassResolutionLevel;
+    return result;
+}
+
+void UpdateTraceSettings()
+{
+    TraceState& state = traceState;
+    if(state.mode == TRACE_MODE_REPLAY)
+    {
+        if(traceFrame.record.flags & TRACE_FRAME_SETTINGS)
+        {
+            state.settings = traceFrame.settings;
+            state.hasSettings = true;
+        }
+        // Reapplied every frame, so UI interaction during replay doesn't change frames
+        if(!state.hasSettings) return;
+        grassUniforms = state.settings.grassUniforms;
+        grassDensityRequested = state.settings.grassDensityRequested;
+        grassSplatPixelSize = state.settings.grassSplatPixelSize;
+        grassDebugMode = state.settings.grassDebugMode;
+        grassResolutionLevel = state.settings.grassResolutionLevel;
+        return;
+    }
+    if(state.mode != TRACE_MODE_RECORD || !state.file) return;
+
+    // First frame always carries settings, later ones only when UI changed them
+    TraceFrameRecord record = traceFrame.record;
+    TraceSettings settings = GetTraceSettings();
+    bool changed = !state.hasSettings || memcmp(&settings, &state.settings, sizeof(TraceSettings)) != 0;
+    if(changed) record.flags |= TRACE_FRAME_SETTINGS;
+    bool result = fwrite(&record, sizeof(TraceFrameRecord), 1, state.file) == 1
+        && (!changed || fwrite(&settings, sizeof(TraceSettings), 1, state.file) == 1);
+    if(!result)
+    {
+        LOGF("Failed to write trace, recording stopped: %s\n", state.path);
+        EndTrace();
+        return;
+    }
+    state.settings = settings;
+    state.hasSettings = true;
+    state.frameIndex++;
+}
+
+void WriteTraceTimings(f32 updateMS, f32 renderMS, f32 gpuWaitMS, f32 frameMS)
+{
+    TraceState& state = traceState;
+    if(state.mode != TRACE_MODE_REPLAY) return;
+    fprintf(state.timingsFile, "%u,%.4f,%.4f,%.4f,%.4f\n", state.frameIndex, updateMS, renderMS, gpuWaitMS, frameMS);
+    state.frameIndex++;
+}
+
+};  // namespace Grass
+};  // namespace ty
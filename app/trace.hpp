@@ -0,0 +1,105 @@
+#pragma once
+#include "engine/src/core/base.hpp"
+#include "engine/src/core/math.hpp"
+
+#include "app/grass.hpp"
+
+#include <stdio.h>
+
+// Session traces. --record=path writes what drives a frame: the input the app consumed, sim delta
+// time and world time, and grass settings whenever UI edits them. --replay=path runs a single
+// threaded loop fed from the trace instead of devices and clock, with the governor off, so any
+// build renders the same frames regardless of how long they take. Replay writes per frame timings
+// as CSV next to the trace (or to --replay-timings=path) for diffing between builds.
+// Sim side reads or samples input into a TraceFrame that reaches render side in the frame snapshot.
+
+namespace ty
+{
+namespace Grass
+{
+
+enum TraceMode
+{
+    TRACE_MODE_NONE,
+    TRACE_MODE_RECORD,
+    TRACE_MODE_REPLAY,
+};
+
+enum TraceFrameFlags
+{
+    TRACE_FRAME_MOVE_FORWARD = 1 << 0,
+    TRACE_FRAME_MOVE_BACK = 1 << 1,
+    TRACE_FRAME_MOVE_LEFT = 1 << 2,
+    TRACE_FRAME_MOVE_RIGHT = 1 << 3,
+    TRACE_FRAME_MOUSE_LOCKED = 1 << 4,  // Camera follows input, after this frame's lock toggle
+    TRACE_FRAME_QUIT = 1 << 5,
+    TRACE_FRAME_SETTINGS = 1 << 6,      // TraceSettings follows record in file
+};
+
+const u32 traceMagic = 0x43525447;      // "GTRC"
+const u32 traceVersion = 2;
+
+struct TraceHeader
+{
+    u32 magic = traceMagic;
+    u32 version = traceVersion;
+    u32 settingsSize = 0;               // Rejects traces from builds with a different settings layout
+    u32 padding0 = 0;
+};
+static_assert(sizeof(TraceHeader) == 16);
+
+struct TraceFrameRecord
+{
+    f32 deltaTime = 0;
+    f32 worldTime = 0;
+    u32 flags = 0;                      // TraceFrameFlags
+    math::v2f mouseDelta = {};
+};
+static_assert(sizeof(TraceFrameRecord) == 20);
+
+// User editable state that changes what is rendered
+struct TraceSettings
+{
+    GrassUniformBlock grassUniforms = {};   // Derived fields are recomputed after replay applies these
+    f32 grassDensityRequested = 0;
+    f32 grassSplatPixelSize = 0;
+    i32 grassDebugMode = 0;
+    i32 grassResolutionLevel = 0;
+};
+
+struct TraceFrame
+{
+    TraceFrameRecord record = {};
+    TraceSettings settings = {};        // Valid with TRACE_FRAME_SETTINGS
+};
+
+struct TraceState
+{
+    TraceMode mode = TRACE_MODE_NONE;
+    char path[256] = {};
+    char timingsPath[256] = {};
+    FILE* file = NULL;
+    FILE* timingsFile = NULL;
+    u32 frameIndex = 0;
+    TraceSettings settings = {};        // Last recorded, or current replayed
+    bool hasSettings = false;
+};
+
+inline TraceState traceState = {};
+inline TraceFrame traceFrame = {};      // Render side, frame being rendered
+
+void ParseTraceSettings(const wchar_t* cmdLine);
+// Opens trace files for mode from command line. Returns false if trace can't be used.
+bool BeginTrace();
+void EndTrace();
+bool IsTraceReplaying();
+// Current user editable settings, render side
+TraceSettings GetTraceSettings();
+// Sim side. Returns false when trace has no more frames.
+bool ReadTraceFrame(TraceFrame* frame);
+// Render side, after settings UI and before settings are used. Records edits or applies replayed ones.
+void UpdateTraceSettings();
+void WriteTraceTimings(f32 updateMS, f32 renderMS, f32 gpuWaitMS, f32 frameMS);
+
+};  // namespace Grass
+};  // namespace ty